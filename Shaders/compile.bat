@@ -1,5 +1,8 @@
 cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" shader.vert -o vert.spv
+cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" shaderOct.vert -o vertOct.spv
+cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" shaderQTangent.vert -o vertQTangent.spv
 cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" defferedShader1stPass.frag -o defferedShader1stPass.spv
+cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" shaderIndirect.vert -o vertIndirect.spv
 cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" shader2.frag -o frag2.spv
 
 cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" ssShader.vert -o ssShaderVert.spv
@@ -11,6 +14,9 @@ cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" shadowShader.f
 cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" defferedShader2ndPass.vert -o defferedShader2ndPassVert.spv
 cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" defferedShader2ndPass.frag -o defferedShader2ndPassFrag.spv
 
+cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" cullDraws.comp -o cullDrawsCompute.spv
+cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" hiZ.frag -o hiZFrag.spv
+
 
 cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" particleShader.vert -o particleShaderVert.spv
 cmd /C ""C:/SDK programming/VulkanSDK/1.1.121.2/Bin32/glslc.exe"" particleShader.frag -o particleShaderFrag.spv
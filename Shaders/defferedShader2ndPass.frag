@@ -4,6 +4,7 @@
 layout(location = 0) in vec2 fragTexCoord;
 layout(location = 0) out vec4 outColor;
 
+//camera dependent, rewritten right before frame is submitted (late latching)
 layout( set =0, binding = 5) uniform LightParams 
 {
     mat4 viewProjMat;
@@ -12,12 +13,6 @@ layout( set =0, binding = 5) uniform LightParams
 	
 } lightParams;
 
-layout(push_constant) uniform PushConsts 
-{
-	mat4 viewProjMat;
-	vec3 viewSpacePos;
-	vec3 color;
-} lightPushConsts;
 
 
 layout( set =0, binding = 4) uniform sampler2D depthMap;
@@ -79,7 +74,7 @@ void main()
     float roughness = texture(metalicRoughnessAoMap, fragTexCoord).g;
     float ao        = texture(metalicRoughnessAoMap, fragTexCoord).b;
 	
-	vec3 lightPos=lightPushConsts.viewSpacePos;
+	vec3 lightPos=lightParams.viewSpacePos;
 	
 	vec3 fragPosition= texture(fragPosMap, fragTexCoord).rgb;
 	
@@ -98,7 +93,7 @@ void main()
 
     vec3 H = normalize(V + L);
         float attenuation = 1.0 / (distance * distance);
-        vec3 radiance     = lightPushConsts.color * attenuation;        
+        vec3 radiance     = lightParams.color * attenuation;        
         
         // cook-torrance brdf
         float NDF = DistributionGGX(N, H, roughness);        
@@ -121,7 +116,7 @@ void main()
     //vec3 ambient = vec3(0.03) * albedo * ao;
     vec3 color = /*ambient +*/ Lo;
 
-	vec4 lightSpaceFragPos= lightPushConsts.viewProjMat * vec4(fragPosition, 1.0);
+	vec4 lightSpaceFragPos= lightParams.viewProjMat * vec4(fragPosition, 1.0);
 	lightSpaceFragPos = lightSpaceFragPos/lightSpaceFragPos.w;
 	
 	float lightSpaceFragDistance= lightSpaceFragPos.z;
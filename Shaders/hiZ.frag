@@ -0,0 +1,37 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//farthest depth of 2x2 texels of previous level (G-buffer depth for level 0)
+layout(set = 0, binding = 0) uniform sampler2D srcDepth;
+
+layout(location = 0) out float outDepth;
+
+void main()
+{
+	ivec2 srcSize = textureSize(srcDepth, 0);
+	ivec2 dstSize = max(srcSize / 2, ivec2(1));
+	ivec2 dst = ivec2(gl_FragCoord.xy);
+	ivec2 src = dst * 2;
+	ivec2 srcMax = srcSize - 1;
+
+	float depth = max(max(texelFetch(srcDepth, min(src, srcMax), 0).r, texelFetch(srcDepth, min(src + ivec2(1, 0), srcMax), 0).r),
+		max(texelFetch(srcDepth, min(src + ivec2(0, 1), srcMax), 0).r, texelFetch(srcDepth, min(src + ivec2(1, 1), srcMax), 0).r));
+
+	//odd source size, last row / column of destination covers 3 source texels
+	bool oddX = (srcSize.x & 1) == 1 && dst.x == dstSize.x - 1;
+	bool oddY = (srcSize.y & 1) == 1 && dst.y == dstSize.y - 1;
+	if (oddX)
+	{
+		depth = max(depth, max(texelFetch(srcDepth, min(src + ivec2(2, 0), srcMax), 0).r, texelFetch(srcDepth, min(src + ivec2(2, 1), srcMax), 0).r));
+	}
+	if (oddY)
+	{
+		depth = max(depth, max(texelFetch(srcDepth, min(src + ivec2(0, 2), srcMax), 0).r, texelFetch(srcDepth, min(src + ivec2(1, 2), srcMax), 0).r));
+	}
+	if (oddX && oddY)
+	{
+		depth = max(depth, texelFetch(srcDepth, min(src + ivec2(2, 2), srcMax), 0).r);
+	}
+
+	outDepth = depth;
+}
@@ -1,10 +1,9 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+//projection and view are per frame in scene UBO
 layout(push_constant) uniform PushConsts 
 {
-	mat4 proj;
-	mat4 view;
 	mat4 model;
 } pushConsts;
 
@@ -17,6 +16,8 @@ layout(location = 5) in vec3 inBitangent;
 
 layout( set =1, binding = 0) uniform SceneUBO
 {
+	mat4 proj;
+	mat4 view;
 	vec3 cameraPos;
 	vec3 lightPos;
 	vec3 lightColor;
@@ -31,12 +32,12 @@ layout(location = 4) out vec3 fragTangent;
 layout(location = 5) out vec3 fragBitangent;
 void main() 
 {
-    gl_Position = pushConsts.proj * pushConsts.view * pushConsts.model * vec4(inPosition, 1.0);
-	fragPosition= (pushConsts.view * pushConsts.model * vec4(inPosition, 1.0)).xyz;
+    gl_Position = scene.proj * scene.view * pushConsts.model * vec4(inPosition, 1.0);
+	fragPosition= (scene.view * pushConsts.model * vec4(inPosition, 1.0)).xyz;
 	
-	fragNormal = normalize(pushConsts.view * pushConsts.model * vec4(inNormal, 0.0f)).xyz;
-    fragTangent = normalize((pushConsts.view * pushConsts.model * vec4(normalize(inTangent), 0.0))).xyz;
-    fragBitangent = normalize((pushConsts.view * pushConsts.model * vec4(normalize(inBitangent), 0.0))).xyz;
+	fragNormal = normalize(scene.view * pushConsts.model * vec4(inNormal, 0.0f)).xyz;
+    fragTangent = normalize((scene.view * pushConsts.model * vec4(normalize(inTangent), 0.0))).xyz;
+    fragBitangent = normalize((scene.view * pushConsts.model * vec4(normalize(inBitangent), 0.0))).xyz;
 
 	fragColor = inColor;
 	fragTexCoord=inTexCoord;
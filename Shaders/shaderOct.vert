@@ -0,0 +1,59 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//VertexOct input, see VertexFormat.h
+
+//projection and view are per frame in scene UBO
+layout(push_constant) uniform PushConsts 
+{
+	mat4 model;
+} pushConsts;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec2 inNormal;
+layout(location = 4) in vec4 inTangent;
+
+layout( set =1, binding = 0) uniform SceneUBO
+{
+	mat4 proj;
+	mat4 view;
+	vec3 cameraPos;
+	vec3 lightPos;
+	vec3 lightColor;
+	uint lightCount;
+} scene;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragPosition;
+layout(location = 3) out vec3 fragNormal;
+layout(location = 4) out vec3 fragTangent;
+layout(location = 5) out vec3 fragBitangent;
+
+vec3 octDecode(vec2 p)
+{
+	vec3 n = vec3(p.x, p.y, 1.0 - abs(p.x) - abs(p.y));
+	if (n.z < 0.0)
+	{
+		n.xy = (1.0 - abs(p.yx)) * vec2(p.x >= 0.0 ? 1.0 : -1.0, p.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(n);
+}
+
+void main() 
+{
+	vec3 normal = octDecode(inNormal);
+	vec3 tangent = octDecode(inTangent.xy);
+	vec3 bitangent = cross(normal, tangent) * (inTangent.z < 0.0 ? -1.0 : 1.0);
+
+    gl_Position = scene.proj * scene.view * pushConsts.model * vec4(inPosition, 1.0);
+	fragPosition= (scene.view * pushConsts.model * vec4(inPosition, 1.0)).xyz;
+	
+	fragNormal = normalize(scene.view * pushConsts.model * vec4(normal, 0.0f)).xyz;
+    fragTangent = normalize((scene.view * pushConsts.model * vec4(tangent, 0.0))).xyz;
+    fragBitangent = normalize((scene.view * pushConsts.model * vec4(bitangent, 0.0))).xyz;
+
+	fragColor = vec3(1.0);
+	fragTexCoord=inTexCoord;
+}
@@ -0,0 +1,51 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//VertexQTangent input, see VertexFormat.h
+
+//projection and view are per frame in scene UBO
+layout(push_constant) uniform PushConsts 
+{
+	mat4 model;
+} pushConsts;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec4 inQTangent;
+
+layout( set =1, binding = 0) uniform SceneUBO
+{
+	mat4 proj;
+	mat4 view;
+	vec3 cameraPos;
+	vec3 lightPos;
+	vec3 lightColor;
+	uint lightCount;
+} scene;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragPosition;
+layout(location = 3) out vec3 fragNormal;
+layout(location = 4) out vec3 fragTangent;
+layout(location = 5) out vec3 fragBitangent;
+
+void main() 
+{
+	vec4 q = normalize(inQTangent);
+
+	//first and third column of rotation matrix, sign of w is bitangent sign
+	vec3 tangent = vec3(1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y));
+	vec3 normal = vec3(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+	vec3 bitangent = cross(normal, tangent) * (q.w < 0.0 ? -1.0 : 1.0);
+
+    gl_Position = scene.proj * scene.view * pushConsts.model * vec4(inPosition, 1.0);
+	fragPosition= (scene.view * pushConsts.model * vec4(inPosition, 1.0)).xyz;
+	
+	fragNormal = normalize(scene.view * pushConsts.model * vec4(normal, 0.0f)).xyz;
+    fragTangent = normalize((scene.view * pushConsts.model * vec4(tangent, 0.0))).xyz;
+    fragBitangent = normalize((scene.view * pushConsts.model * vec4(bitangent, 0.0))).xyz;
+
+	fragColor = vec3(1.0);
+	fragTexCoord=inTexCoord;
+}
@@ -9,12 +9,9 @@ layout(push_constant) uniform PushConsts
 	mat4 model;
 } pushConsts;
 
+//separate position stream (MeshData::positions) bound alone at binding 0, float or UNORM16 normalized to mesh bounds,
+//dequantization of UNORM16 is folded into model matrix
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec3 inNormal;
-layout(location = 4) in vec3 inTangent;
-layout(location = 5) in vec3 inBitangent;
 
 
 void main() 
@@ -0,0 +1,144 @@
+
+#include "ComputeScheduler.h"
+
+#include <assert.h>
+
+using namespace std;
+
+
+	ComputeScheduler::ComputeScheduler(VkDevice device, VkQueue queue, uint32_t queueFamilyIndex) : m_Device(device), m_Queue(queue), m_QueueFamilyIndex(queueFamilyIndex)
+	{
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = m_QueueFamilyIndex;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		auto res = vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_CommandPool);
+		assert(res == VK_SUCCESS);
+
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		for (uint32_t i = 0; i < SLOT_CNT; ++i)
+		{
+			res = vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_ComputeSemaphores[i].semaphore);
+			assert(res == VK_SUCCESS);
+			m_ComputeSemaphores[i].pending = false;
+
+			res = vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_GraphicsSemaphores[i].semaphore);
+			assert(res == VK_SUCCESS);
+			m_GraphicsSemaphores[i].pending = false;
+		}
+	}
+
+	ComputeScheduler::~ComputeScheduler()
+	{
+		vkQueueWaitIdle(m_Queue);
+
+		for (uint32_t i = 0; i < SLOT_CNT; ++i)
+		{
+			vkDestroySemaphore(m_Device, m_ComputeSemaphores[i].semaphore, nullptr);
+			vkDestroySemaphore(m_Device, m_GraphicsSemaphores[i].semaphore, nullptr);
+		}
+
+		vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+	}
+
+	uint32_t ComputeScheduler::getQueueFamilyIndex() const
+	{
+		return m_QueueFamilyIndex;
+	}
+
+	vector<VkCommandBuffer> ComputeScheduler::allocateCommandBuffers(uint32_t count)
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = m_CommandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = count;
+
+		vector<VkCommandBuffer> commandBuffers(count);
+		auto res = vkAllocateCommandBuffers(m_Device, &allocInfo, &commandBuffers[0]);
+		assert(res == VK_SUCCESS);
+
+		return commandBuffers;
+	}
+
+	void ComputeScheduler::submit(VkCommandBuffer commandBuffer, uint32_t outputCopies)
+	{
+		assert(outputCopies >= 1 && outputCopies <= MAX_OUTPUT_COPIES);
+
+		FrameSemaphore& computeSemaphore = m_ComputeSemaphores[m_FrameCnt % SLOT_CNT];
+		assert(!computeSemaphore.pending && "Only one compute submission per frame!");
+
+		//frames newer than m_FrameCnt - outputCopies read other copy of outputs, their signals are left for later compute
+		vector<VkSemaphore> waitSemaphores;
+		for (uint64_t frame = m_FrameCnt >= SLOT_CNT ? m_FrameCnt - SLOT_CNT + 1 : 0; frame + outputCopies <= m_FrameCnt; ++frame)
+		{
+			FrameSemaphore& graphicsSemaphore = m_GraphicsSemaphores[frame % SLOT_CNT];
+			if (!graphicsSemaphore.pending) continue;
+
+			waitSemaphores.push_back(graphicsSemaphore.semaphore);
+			graphicsSemaphore.pending = false;
+		}
+
+		vector<VkPipelineStageFlags> waitStages(waitSemaphores.size(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+		submitInfo.pWaitSemaphores = waitSemaphores.empty() ? nullptr : &waitSemaphores[0];
+		submitInfo.pWaitDstStageMask = waitStages.empty() ? nullptr : &waitStages[0];
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &computeSemaphore.semaphore;
+
+		auto res = vkQueueSubmit(m_Queue, 1, &submitInfo, VK_NULL_HANDLE);
+		assert(res == VK_SUCCESS);
+
+		computeSemaphore.pending = true;
+		m_Used = true;
+	}
+
+	void ComputeScheduler::getFrameSemaphores(vector<VkSemaphore>& outWaitSemaphores, vector<VkPipelineStageFlags>& outWaitStages, vector<VkSemaphore>& outSignalSemaphores)
+	{
+		uint32_t const slot = static_cast<uint32_t>(m_FrameCnt % SLOT_CNT);
+
+		FrameSemaphore& computeSemaphore = m_ComputeSemaphores[slot];
+		if (computeSemaphore.pending)
+		{
+			//compute outputs are read from vertex shader on (particles) or in fragment shader (ray tracer image)
+			outWaitSemaphores.push_back(computeSemaphore.semaphore);
+			outWaitStages.push_back(VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+			computeSemaphore.pending = false;
+		}
+
+		if (m_Used)
+		{
+			FrameSemaphore& graphicsSemaphore = m_GraphicsSemaphores[slot];
+			if (graphicsSemaphore.pending) consumeGraphicsSemaphore(graphicsSemaphore);
+
+			outSignalSemaphores.push_back(graphicsSemaphore.semaphore);
+			graphicsSemaphore.pending = true;
+		}
+
+		++m_FrameCnt;
+	}
+
+	void ComputeScheduler::consumeGraphicsSemaphore(FrameSemaphore& frameSemaphore)
+	{
+		//no compute waited for this frame (e.g. compute was skipped), binary semaphore has to be unsignaled before reuse
+		VkPipelineStageFlags const waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &frameSemaphore.semaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+
+		auto res = vkQueueSubmit(m_Queue, 1, &submitInfo, VK_NULL_HANDLE);
+		assert(res == VK_SUCCESS);
+
+		frameSemaphore.pending = false;
+	}
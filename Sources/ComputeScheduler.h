@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+using namespace std;
+
+//Compute work submitted to its own queue without CPU waits, ordering with graphics frames is done by semaphores only.
+//Compute of frame N waits for graphics frame which last read its outputs, graphics frame N waits for compute of frame N.
+//With outputs in two copies (ping-pong) compute of frame N+1 runs while frame N is rendered.
+class ComputeScheduler
+{
+public:
+	ComputeScheduler(VkDevice device, VkQueue queue, uint32_t queueFamilyIndex);
+	~ComputeScheduler();
+	ComputeScheduler(ComputeScheduler const&) = delete;
+	ComputeScheduler& operator=(ComputeScheduler const&) = delete;
+
+	uint32_t getQueueFamilyIndex() const;
+	vector<VkCommandBuffer> allocateCommandBuffers(uint32_t count);
+
+	//compute of frame which is submitted next, at most one per frame
+	//outputCopies: 1 - results are overwritten in place, waits for previous frame; 2 - ping-pong, waits for frame before it
+	void submit(VkCommandBuffer commandBuffer, uint32_t outputCopies = 1);
+
+	//semaphores of next graphics submission, called once per frame by VulcanInstance::drawFrame
+	void getFrameSemaphores(vector<VkSemaphore>& outWaitSemaphores, vector<VkPipelineStageFlags>& outWaitStages, vector<VkSemaphore>& outSignalSemaphores);
+
+	static const uint32_t MAX_OUTPUT_COPIES = 2;
+
+private:
+	//binary semaphore with its signal not consumed by wait yet
+	struct FrameSemaphore
+	{
+		VkSemaphore semaphore;
+		bool pending;
+	};
+
+	//graphics semaphore is reused after MAX_OUTPUT_COPIES frames, one more slot for frame being recorded
+	static const uint32_t SLOT_CNT = MAX_OUTPUT_COPIES + 1;
+
+	void consumeGraphicsSemaphore(FrameSemaphore& frameSemaphore);
+
+	VkDevice m_Device;
+	VkQueue m_Queue;
+	uint32_t m_QueueFamilyIndex;
+	VkCommandPool m_CommandPool;
+
+	FrameSemaphore m_ComputeSemaphores[SLOT_CNT]; //signaled by compute of frame, waited by graphics of the same frame
+	FrameSemaphore m_GraphicsSemaphores[SLOT_CNT]; //signaled by graphics of frame, waited by later compute
+	uint64_t m_FrameCnt = 0; //frame which is recorded now
+	bool m_Used = false; //graphics frames signal semaphores only when there is compute to wait for them
+};
@@ -0,0 +1,194 @@
+
+#include "CpuProfiler.h"
+
+#include <assert.h>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+
+	CpuProfiler& CpuProfiler::get()
+	{
+		static CpuProfiler profiler;
+		return profiler;
+	}
+
+	CpuProfiler::CpuProfiler() : m_Start(chrono::steady_clock::now())
+	{
+	}
+
+	CpuProfiler::~CpuProfiler()
+	{
+		for (auto& thread : m_Threads)
+			for (auto& chunk : thread->chunks)
+				delete[] chunk.load();
+	}
+
+	int64_t CpuProfiler::now() const
+	{
+		return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - m_Start).count();
+	}
+
+	void CpuProfiler::addScope(char const* name, int64_t begin, int64_t end)
+	{
+		push({ name, begin, end, 0.0, false });
+	}
+
+	void CpuProfiler::addCounter(char const* name, double value)
+	{
+		int64_t const time = now();
+		push({ name, time, time, value, true });
+	}
+
+	void CpuProfiler::setThreadName(string const& name)
+	{
+		ThreadBuffer& buffer = getThreadBuffer();
+
+		lock_guard<mutex> lock(m_Mutex);
+		buffer.name = name;
+	}
+
+	char const* CpuProfiler::intern(string const& name)
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		return m_Names.insert(name).first->c_str();
+	}
+
+	CpuProfiler::ThreadBuffer& CpuProfiler::getThreadBuffer()
+	{
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (buffer) return *buffer;
+
+		lock_guard<mutex> lock(m_Mutex);
+
+		m_Threads.push_back(make_unique<ThreadBuffer>());
+		buffer = m_Threads.back().get();
+		buffer->threadId = static_cast<uint32_t>(m_Threads.size());
+		buffer->name = "thread " + to_string(buffer->threadId);
+		for (auto& chunk : buffer->chunks) chunk.store(nullptr, memory_order_relaxed);
+		buffer->eventCnt.store(0, memory_order_relaxed);
+		buffer->droppedCnt.store(0, memory_order_relaxed);
+
+		return *buffer;
+	}
+
+	void CpuProfiler::push(Event const& event)
+	{
+		ThreadBuffer& buffer = getThreadBuffer();
+
+		//only owning thread writes, readers see events up to published count
+		size_t const idx = buffer.eventCnt.load(memory_order_relaxed);
+		if (idx == MAX_EVENTS_PER_THREAD)
+		{
+			buffer.droppedCnt.fetch_add(1, memory_order_relaxed);
+			return;
+		}
+
+		atomic<Event*>& chunkPtr = buffer.chunks[idx / CHUNK_SIZE];
+		Event* chunk = chunkPtr.load(memory_order_relaxed);
+		if (!chunk)
+		{
+			chunk = new Event[CHUNK_SIZE];
+			chunkPtr.store(chunk, memory_order_relaxed);
+		}
+
+		chunk[idx % CHUNK_SIZE] = event;
+		buffer.eventCnt.store(idx + 1, memory_order_release);
+	}
+
+	string CpuProfiler::escape(char const* text)
+	{
+		string escaped;
+		for (char const* c = text; *c; ++c)
+		{
+			unsigned char const ch = static_cast<unsigned char>(*c);
+			if (ch == '"' || ch == '\\')
+			{
+				escaped += '\\';
+				escaped += *c;
+			}
+			else if (ch < 0x20)
+			{
+				char code[8];
+				snprintf(code, sizeof(code), "\\u%04x", ch);
+				escaped += code;
+			}
+			else
+			{
+				escaped += *c;
+			}
+		}
+
+		return escaped;
+	}
+
+	bool CpuProfiler::writeTrace(string const& path)
+	{
+		ofstream file(path);
+		if (!file)
+		{
+			cout << "Failed to write CPU trace " << path << endl;
+			return false;
+		}
+
+		lock_guard<mutex> lock(m_Mutex);
+
+		size_t eventCnt = 0;
+		bool first = true;
+		auto separator = [&]() -> ostream&
+		{
+			if (!first) file << ",\n";
+			first = false;
+			return file;
+		};
+
+		//timestamps in us
+		file << fixed << setprecision(3);
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		for (auto const& thread : m_Threads)
+		{
+			separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->threadId << ",\"args\":{\"name\":\"" << escape(thread->name.c_str()) << "\"}}";
+
+			size_t const cnt = thread->eventCnt.load(memory_order_acquire);
+			for (size_t i = 0; i < cnt; ++i)
+			{
+				Event const& event = thread->chunks[i / CHUNK_SIZE].load(memory_order_relaxed)[i % CHUNK_SIZE];
+
+				if (event.counter)
+				{
+					separator() << "{\"name\":\"" << escape(event.name) << "\",\"ph\":\"C\",\"pid\":1,\"tid\":" << thread->threadId
+						<< ",\"ts\":" << event.begin / 1000.0 << ",\"args\":{\"value\":" << event.value << "}}";
+				}
+				else
+				{
+					separator() << "{\"name\":\"" << escape(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->threadId
+						<< ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+				}
+			}
+
+			eventCnt += cnt;
+		}
+
+		file << "\n]}\n";
+
+		cout << "CPU trace written to " << path << " (" << eventCnt << " events)" << endl;
+		return true;
+	}
+
+	void CpuProfiler::printStatistics()
+	{
+		lock_guard<mutex> lock(m_Mutex);
+
+		cout << "CPU profiler threads: " << m_Threads.size() << endl;
+		for (auto const& thread : m_Threads)
+		{
+			cout << "  " << thread->name << ": " << thread->eventCnt.load(memory_order_relaxed) << " events";
+			size_t const droppedCnt = thread->droppedCnt.load(memory_order_relaxed);
+			if (droppedCnt > 0) cout << ", " << droppedCnt << " dropped";
+			cout << endl;
+		}
+	}
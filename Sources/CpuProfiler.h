@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+//compile-time switch, PHOENIX_CPU_PROFILER=0 (cmake option PHOENIX_CPU_PROFILER) removes all instrumentation
+#ifndef PHOENIX_CPU_PROFILER
+#define PHOENIX_CPU_PROFILER 1
+#endif
+
+//CPU time of named scopes of every thread, exported as Chrome / Perfetto trace JSON (chrome://tracing, ui.perfetto.dev).
+//Every thread appends events to own buffer without locking, buffer is registered on first event of thread. Buffers grow
+//by chunks up to MAX_EVENTS_PER_THREAD, later events are dropped. Names have to outlive profiler (string literals or intern()).
+class CpuProfiler
+{
+public:
+	static CpuProfiler& get();
+
+	CpuProfiler(CpuProfiler const&) = delete;
+	CpuProfiler& operator=(CpuProfiler const&) = delete;
+
+	//ns since profiler start
+	int64_t now() const;
+
+	void addScope(char const* name, int64_t begin, int64_t end);
+	//value of named track at current time, e.g. GPU timings
+	void addCounter(char const* name, double value);
+
+	//name of calling thread in trace
+	void setThreadName(string const& name);
+
+	//copy with profiler lifetime, for names built at runtime; locks, setup time only
+	char const* intern(string const& name);
+
+	//events recorded so far, can be called while other threads record
+	bool writeTrace(string const& path);
+	void printStatistics();
+
+	static const size_t CHUNK_SIZE = 4096;
+	static const size_t MAX_CHUNKS = 256;
+	static const size_t MAX_EVENTS_PER_THREAD = CHUNK_SIZE * MAX_CHUNKS;
+
+private:
+	struct Event
+	{
+		char const* name;
+		int64_t begin; //ns
+		int64_t end; //ns, unused by counters
+		double value; //counters only
+		bool counter;
+	};
+
+	struct ThreadBuffer
+	{
+		uint32_t threadId;
+		string name; //guarded by m_Mutex
+		atomic<Event*> chunks[MAX_CHUNKS];
+		atomic<size_t> eventCnt; //published after event is written, written by owning thread only
+		atomic<size_t> droppedCnt;
+	};
+
+	CpuProfiler();
+	~CpuProfiler();
+
+	ThreadBuffer& getThreadBuffer();
+	void push(Event const& event);
+
+	//JSON string content, names can be file paths with backslashes
+	static string escape(char const* text);
+
+	chrono::steady_clock::time_point m_Start;
+
+	mutex m_Mutex; //registration of threads, names, export
+	vector<unique_ptr<ThreadBuffer>> m_Threads;
+	unordered_set<string> m_Names;
+};
+
+//profiled scope bound to C++ scope
+class CpuScope
+{
+public:
+	CpuScope(char const* name) : m_Name(name), m_Begin(CpuProfiler::get().now())
+	{
+	}
+
+	~CpuScope()
+	{
+		CpuProfiler& profiler = CpuProfiler::get();
+		profiler.addScope(m_Name, m_Begin, profiler.now());
+	}
+
+	CpuScope(CpuScope const&) = delete;
+	CpuScope& operator=(CpuScope const&) = delete;
+
+private:
+	char const* m_Name;
+	int64_t m_Begin;
+};
+
+#define PHOENIX_PROFILE_CONCAT_IMPL(a, b) a##b
+#define PHOENIX_PROFILE_CONCAT(a, b) PHOENIX_PROFILE_CONCAT_IMPL(a, b)
+
+#if PHOENIX_CPU_PROFILER
+#define PROFILE_SCOPE(name) CpuScope PHOENIX_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_COUNTER(name, value) CpuProfiler::get().addCounter(name, value)
+#define PROFILE_THREAD_NAME(name) CpuProfiler::get().setThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
@@ -2,7 +2,11 @@
 
 #include "VulkanHelper.h"
 #include "MaterialManager.h"
+#include "VertexFormat.h"
+#include "UniformRing.h"
+#include "RenderGraph.h"
 #include <memory>
+#include <future>
 
 using namespace std;
 
@@ -17,12 +21,18 @@ class DeferredRender
 {
 
 public:
-	DeferredRender(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent, VkFormat swapChainImageFormat, VkImageView shadowMapView, VkRenderPass dstRenderPass, shared_ptr<DescriptorSetLayout> materialDescriptorSetlayout);
+	DeferredRender(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent, VkFormat swapChainImageFormat, RenderGraph& renderGraph, RenderGraph::ResourceId shadowMap, VkRenderPass dstRenderPass, shared_ptr<DescriptorSetLayout> materialDescriptorSetlayout, VertexFormatType vertexFormat, UniformRing& uniformRing);
+
+	//2nd pass samples G-buffer and shadow map, views exist once graph is compiled
+	void bindAttachments(RenderGraph const& renderGraph);
 
 private:
-	void create1stPass();
+	void create1stPass(RenderGraph& renderGraph);
 	void create2ndPass();
 
+	future<void> m_1stPassPipelineJob; //both pipelines compile on worker threads, joined at end of constructor
+	future<void> m_2ndPassPipelineJob;
+
 	static const int s_ColorAttachmentCnt = 4;
 	static const VkFormat s_ImageFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
 
@@ -31,14 +41,15 @@ public:
 	VkDevice m_Device;
 	VkPhysicalDevice m_PhysicalDevice;
 	VkFormat m_SwapChainImageFormat;
+	VertexFormatType m_VertexFormat;
+	UniformRing& m_UniformRing;
 
 	shared_ptr<DescriptorSetLayout> m_1stPassDescriptorSetLayout;
 	shared_ptr<DescriptorSetLayout> m_1stPassDescriptorSetLayout2;
 
-	VkRenderPass m_1stRenderPass;
-	VkFramebuffer m_1stFramebuffer;
-	vector<AttachmentData> m_1stColorAttachments;
-	AttachmentData m_1stDepthAttachment;
+	VkRenderPass m_1stRenderPass; //compatible with graph pass writing G-buffer, only for pipeline creation
+	vector<RenderGraph::ResourceId> m_GBuffer; //albedo, pos, normal, metalicRoughnessAo
+	RenderGraph::ResourceId m_GBufferDepth;
 	VkPipelineLayout m_1stPassPipelineLayout;
 	VkPipeline m_1stPassPipeline;
 
@@ -48,9 +59,7 @@ public:
 	VkPipelineLayout m_2ndPassPipelineLayout;
 	VkPipeline m_2ndPassPipeline;
 
-	VkImageView m_ShadowMapView;
-
-	unique_ptr<Buffer> m_lightParamBuffer; //TODO
+	RenderGraph::ResourceId m_ShadowMap;
 
 	VkRenderPass m_DstRenderPass;
 };
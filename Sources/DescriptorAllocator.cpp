@@ -0,0 +1,181 @@
+
+#include "DescriptorAllocator.h"
+#include "CpuProfiler.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+unordered_map<VkDevice, DescriptorAllocator*> DescriptorAllocator::s_Allocators;
+
+
+	DescriptorAllocator::DescriptorAllocator(VkDevice device, uint32_t frameCnt) : m_Device(device), m_TransientPools(frameCnt)
+	{
+		assert(s_Allocators.count(m_Device) == 0 && "Only one DescriptorAllocator per device!");
+		s_Allocators[m_Device] = this;
+	}
+
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		for (auto& pools : m_Pools)
+		{
+			for (auto& pool : pools.second)
+			{
+				if (pool->freeCnt != pool->capacity) cout << "DescriptorAllocator: " << pool->capacity - pool->freeCnt << " descriptor sets were not freed" << endl;
+				vkDestroyDescriptorPool(m_Device, pool->pool, nullptr);
+			}
+		}
+
+		for (auto& framePools : m_TransientPools)
+		{
+			for (auto& pools : framePools)
+			{
+				for (auto& pool : pools.second) vkDestroyDescriptorPool(m_Device, pool->pool, nullptr);
+			}
+		}
+
+		s_Allocators.erase(m_Device);
+	}
+
+	DescriptorAllocator& DescriptorAllocator::get(VkDevice device)
+	{
+		auto it = s_Allocators.find(device);
+		assert(it != end(s_Allocators) && "No DescriptorAllocator created for device!");
+
+		return *it->second;
+	}
+
+	DescriptorAllocator::Pool& DescriptorAllocator::findPool(PoolList& pools, PoolSizes const& poolSizes, bool freeable)
+	{
+		for (auto& pool : pools)
+		{
+			if (pool->freeCnt > 0) return *pool;
+		}
+
+		//every new pool of the same composition is twice as big
+		uint32_t const setCnt = pools.empty() ? MIN_SETS_PER_POOL : min(pools.back()->capacity * 2, MAX_SETS_PER_POOL);
+
+		vector<VkDescriptorPoolSize> sizes;
+		for (auto const& poolSize : poolSizes) sizes.push_back({ poolSize.first, poolSize.second * setCnt });
+
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = freeable ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(sizes.size());
+		poolInfo.pPoolSizes = sizes.empty() ? nullptr : &sizes[0];
+		poolInfo.maxSets = setCnt;
+
+		unique_ptr<Pool> pool = make_unique<Pool>();
+		pool->capacity = pool->freeCnt = setCnt;
+
+		auto res = vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &pool->pool);
+		assert(res == VK_SUCCESS);
+
+		pools.push_back(move(pool));
+
+		return *pools.back();
+	}
+
+	VkDescriptorSet DescriptorAllocator::allocateSet(Pool& pool, VkDescriptorSetLayout layout)
+	{
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = pool.pool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &layout;
+
+		VkDescriptorSet set;
+		auto res = vkAllocateDescriptorSets(m_Device, &allocInfo, &set);
+		assert(res == VK_SUCCESS);
+
+		--pool.freeCnt;
+
+		return set;
+	}
+
+	DescriptorAllocation DescriptorAllocator::allocate(VkDescriptorSetLayout layout, PoolSizes const& poolSizes)
+	{
+		PROFILE_FUNCTION();
+
+		PoolList& pools = m_Pools[poolSizes];
+		size_t const poolCnt = pools.size();
+
+		Pool& pool = findPool(pools, poolSizes, true);
+		if (pools.size() != poolCnt) m_PoolByHandle[pool.pool] = &pool;
+
+		DescriptorAllocation allocation;
+		allocation.pool = pool.pool;
+		allocation.set = allocateSet(pool, layout);
+
+		return allocation;
+	}
+
+	void DescriptorAllocator::free(DescriptorAllocation const& allocation)
+	{
+		if (allocation.pool == VK_NULL_HANDLE) return;
+
+		auto it = m_PoolByHandle.find(allocation.pool);
+		assert(it != end(m_PoolByHandle));
+
+		auto res = vkFreeDescriptorSets(m_Device, allocation.pool, 1, &allocation.set);
+		assert(res == VK_SUCCESS);
+
+		++it->second->freeCnt;
+	}
+
+	VkDescriptorSet DescriptorAllocator::allocateTransient(VkDescriptorSetLayout layout, PoolSizes const& poolSizes)
+	{
+		Pool& pool = findPool(m_TransientPools[m_FrameIdx][poolSizes], poolSizes, false);
+
+		return allocateSet(pool, layout);
+	}
+
+	void DescriptorAllocator::beginFrame(uint32_t frameIdx)
+	{
+		m_FrameIdx = frameIdx;
+
+		for (auto& pools : m_TransientPools[m_FrameIdx])
+		{
+			for (auto& pool : pools.second)
+			{
+				if (pool->freeCnt == pool->capacity) continue;
+
+				auto res = vkResetDescriptorPool(m_Device, pool->pool, 0);
+				assert(res == VK_SUCCESS);
+
+				pool->freeCnt = pool->capacity;
+			}
+		}
+	}
+
+	size_t DescriptorAllocator::getPoolCnt() const
+	{
+		size_t poolCnt = 0;
+
+		for (auto const& pools : m_Pools) poolCnt += pools.second.size();
+		for (auto const& framePools : m_TransientPools)
+		{
+			for (auto const& pools : framePools) poolCnt += pools.second.size();
+		}
+
+		return poolCnt;
+	}
+
+	size_t DescriptorAllocator::getSetCnt() const
+	{
+		size_t setCnt = 0;
+
+		for (auto const& pools : m_Pools)
+		{
+			for (auto const& pool : pools.second) setCnt += pool->capacity - pool->freeCnt;
+		}
+
+		return setCnt;
+	}
+
+	void DescriptorAllocator::printStatistics() const
+	{
+		cout << "Descriptor pools: " << getPoolCnt() << " (" << m_Pools.size() << " layout compositions), persistent sets: " << getSetCnt() << endl;
+	}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//Set allocated from shared pool, pool is needed to free it again
+struct DescriptorAllocation
+{
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+};
+
+//Shared VkDescriptorPools grouped by descriptor composition of layout, so sets of one layout never fragment a pool.
+//Persistent sets can be freed one by one, transient sets live until the frame slot is reused.
+class DescriptorAllocator
+{
+public:
+	using PoolSizes = vector<pair<VkDescriptorType, uint32_t>>; //descriptor counts of one set, sorted by type
+
+	DescriptorAllocator(VkDevice device, uint32_t frameCnt);
+	~DescriptorAllocator();
+	DescriptorAllocator(DescriptorAllocator const&) = delete;
+	DescriptorAllocator& operator=(DescriptorAllocator const&) = delete;
+
+	//allocator registered for device, DescriptorSet only knows VkDevice of its layout
+	static DescriptorAllocator& get(VkDevice device);
+
+	DescriptorAllocation allocate(VkDescriptorSetLayout layout, PoolSizes const& poolSizes);
+	void free(DescriptorAllocation const& allocation);
+
+	//set valid until beginFrame is called with the same frame slot again
+	VkDescriptorSet allocateTransient(VkDescriptorSetLayout layout, PoolSizes const& poolSizes);
+
+	//resets transient pools of frameIdx, fence of frame which used them last has to be already waited
+	void beginFrame(uint32_t frameIdx);
+
+	size_t getPoolCnt() const;
+	size_t getSetCnt() const;
+	void printStatistics() const;
+
+	static const uint32_t MIN_SETS_PER_POOL = 16;
+	static const uint32_t MAX_SETS_PER_POOL = 256;
+
+private:
+	struct Pool
+	{
+		VkDescriptorPool pool;
+		uint32_t capacity;
+		uint32_t freeCnt;
+	};
+
+	using PoolList = vector<unique_ptr<Pool>>;
+
+	Pool& findPool(PoolList& pools, PoolSizes const& poolSizes, bool freeable);
+	VkDescriptorSet allocateSet(Pool& pool, VkDescriptorSetLayout layout);
+
+	VkDevice m_Device;
+
+	map<PoolSizes, PoolList> m_Pools;
+	unordered_map<VkDescriptorPool, Pool*> m_PoolByHandle;
+
+	vector<map<PoolSizes, PoolList>> m_TransientPools; //per frame slot
+	uint32_t m_FrameIdx = 0;
+
+	static unordered_map<VkDevice, DescriptorAllocator*> s_Allocators;
+};
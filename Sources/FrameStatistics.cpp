@@ -0,0 +1,55 @@
+
+#include "FrameStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+
+	void FrameStatistics::addFrame(double intervalMs, double fenceWaitMs, double acquireMs, double latencyMs)
+	{
+		m_Intervals[m_FrameCnt % SAMPLE_CNT] = intervalMs;
+		++m_FrameCnt;
+
+		m_IntervalSum += intervalMs;
+		m_IntervalSqSum += intervalMs * intervalMs;
+		m_IntervalMax = max(m_IntervalMax, intervalMs);
+		m_FenceWaitSum += fenceWaitMs;
+		m_AcquireSum += acquireMs;
+		m_LatencySum += latencyMs;
+	}
+
+	void FrameStatistics::addInputLatency(double toSubmitMs, double toPresentMs)
+	{
+		++m_InputCnt;
+		m_InputToSubmitSum += toSubmitMs;
+		m_InputToSubmitMax = max(m_InputToSubmitMax, toSubmitMs);
+		m_InputToPresentSum += toPresentMs;
+		m_InputToPresentMax = max(m_InputToPresentMax, toPresentMs);
+	}
+
+	void FrameStatistics::printStatistics(string const& title) const
+	{
+		cout << title << endl;
+		if (m_FrameCnt == 0) return;
+
+		double const average = m_IntervalSum / m_FrameCnt;
+		double const deviation = sqrt(max(0.0, m_IntervalSqSum / m_FrameCnt - average * average));
+
+		vector<double> intervals(begin(m_Intervals), begin(m_Intervals) + min<uint64_t>(m_FrameCnt, SAMPLE_CNT));
+		sort(begin(intervals), end(intervals));
+		double const percentile99 = intervals[(intervals.size() - 1) * 99 / 100];
+
+		cout << "  frames: " << m_FrameCnt << ", " << 1000.0 / average << " fps" << endl;
+		cout << "  frame interval: " << average << " ms average, " << deviation << " ms deviation, " << percentile99 << " ms 99th percentile (last " << intervals.size() << "), " << m_IntervalMax << " ms max" << endl;
+		cout << "  blocked on frame fence: " << m_FenceWaitSum / m_FrameCnt << " ms, on image acquire: " << m_AcquireSum / m_FrameCnt << " ms" << endl;
+		cout << "  submit to frame fence: " << m_LatencySum / m_FrameCnt << " ms" << endl;
+
+		if (m_InputCnt == 0) return;
+
+		cout << "  input to submit: " << m_InputToSubmitSum / m_InputCnt << " ms average, " << m_InputToSubmitMax << " ms max (" << m_InputCnt << " frames with input)" << endl;
+		cout << "  input to present: " << m_InputToPresentSum / m_InputCnt << " ms average, " << m_InputToPresentMax << " ms max" << endl;
+	}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+using namespace std;
+
+//CPU side frame pacing of VulcanInstance::drawFrame: interval between frames, time blocked by frame fence and image acquire,
+//and latency from submission to signaled frame fence. Fence is checked when its frame slot is reused, so latency is upper
+//bound when CPU did not have to wait for it. Input latency is measured from arrival of oldest input applied to frame
+//to its vkQueueSubmit and to return of its vkQueuePresentKHR, scanout is not visible to application.
+class FrameStatistics
+{
+public:
+	void addFrame(double intervalMs, double fenceWaitMs, double acquireMs, double latencyMs);
+	void addInputLatency(double toSubmitMs, double toPresentMs);
+
+	void printStatistics(string const& title) const;
+
+	static const uint32_t SAMPLE_CNT = 1024; //intervals kept for percentiles
+
+private:
+	array<double, SAMPLE_CNT> m_Intervals; //ms, ring
+	uint64_t m_FrameCnt = 0;
+	double m_IntervalSum = 0.0;
+	double m_IntervalSqSum = 0.0;
+	double m_IntervalMax = 0.0;
+	double m_FenceWaitSum = 0.0;
+	double m_AcquireSum = 0.0;
+	double m_LatencySum = 0.0;
+
+	uint64_t m_InputCnt = 0; //frames with input
+	double m_InputToSubmitSum = 0.0;
+	double m_InputToSubmitMax = 0.0;
+	double m_InputToPresentSum = 0.0;
+	double m_InputToPresentMax = 0.0;
+};
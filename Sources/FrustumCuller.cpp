@@ -0,0 +1,188 @@
+
+#include "FrustumCuller.h"
+#include "VisualComponent.h"
+#include "CpuProfiler.h"
+#include "FrustumCullerAvx.h"
+
+#include <assert.h>
+#include <iostream>
+#include <immintrin.h>
+#include <intrin.h>
+
+using namespace std;
+
+
+	void FrustumCuller::cull(SceneObjectManager& sceneObjectManager, vector<glm::mat4> const& viewProjections)
+	{
+		PROFILE_FUNCTION();
+		assert(viewProjections.size() <= MAX_VIEWS);
+
+		gatherBounds(sceneObjectManager);
+
+		size_t const rowSize = m_CenterX.size();
+		m_ViewCnt = viewProjections.size();
+		m_Visibility.resize(m_ViewCnt * rowSize);
+
+		uint64_t culledCnt = 0;
+		for (size_t view = 0; view < m_ViewCnt; ++view)
+		{
+			uint8_t* visibility = m_Visibility.data() + view * rowSize;
+			testView(extractPlanes(viewProjections[view]), visibility);
+
+			uint64_t visibleCnt = 0;
+			for (size_t i = 0; i < m_InstanceCnt; ++i) visibleCnt += visibility[i];
+
+			Statistics& statistics = m_Statistics[view];
+			++statistics.frameCnt;
+			statistics.testedCnt += m_InstanceCnt;
+			statistics.visibleCnt += visibleCnt;
+			culledCnt += m_InstanceCnt - visibleCnt;
+		}
+
+		PROFILE_COUNTER("culled meshes", static_cast<double>(culledCnt));
+	}
+
+	uint8_t const* FrustumCuller::getMeshVisibility(size_t view, size_t objectIdx) const
+	{
+		if (view >= m_ViewCnt || objectIdx >= m_FirstInstance.size()) return nullptr;
+
+		return m_Visibility.data() + view * m_CenterX.size() + m_FirstInstance[objectIdx];
+	}
+
+	size_t FrustumCuller::getViewCnt() const
+	{
+		return m_ViewCnt;
+	}
+
+	FrustumCuller::Statistics const& FrustumCuller::getStatistics(size_t view) const
+	{
+		return m_Statistics[view];
+	}
+
+	void FrustumCuller::printStatistics() const
+	{
+		cout << "Frustum culling (visible / tested mesh instances per frame):" << endl;
+		for (size_t view = 0; view < MAX_VIEWS; ++view)
+		{
+			Statistics const& statistics = m_Statistics[view];
+			if (statistics.frameCnt == 0) continue;
+
+			double const tested = static_cast<double>(statistics.testedCnt) / statistics.frameCnt;
+			double const visible = static_cast<double>(statistics.visibleCnt) / statistics.frameCnt;
+			cout << "  view " << view << ": " << visible << " / " << tested << " (" << (tested > 0.0 ? 100.0 * (1.0 - visible / tested) : 0.0) << " % culled)" << endl;
+		}
+	}
+
+	FrustumCuller::Frustum FrustumCuller::extractPlanes(glm::mat4 const& viewProjection)
+	{
+		//clip space is -w <= x, y <= w and 0 <= z <= w (GLM_FORCE_DEPTH_ZERO_TO_ONE)
+		auto const row = [&viewProjection](int i) { return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]); };
+
+		Frustum frustum = { row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(2), row(3) - row(2) };
+		for (auto& plane : frustum) plane /= glm::length(glm::vec3(plane));
+
+		return frustum;
+	}
+
+	void FrustumCuller::gatherBounds(SceneObjectManager& sceneObjectManager)
+	{
+		m_FirstInstance.clear();
+		m_InstanceCnt = 0;
+
+		sceneObjectManager.enumerate([this](SceneObject* sceneObj)
+			{
+				m_FirstInstance.push_back(m_InstanceCnt);
+
+				VisualComponent const* visualComp = sceneObj->findComponent<VisualComponent>();
+				if (visualComp) m_InstanceCnt += visualComp->m_ModelData->meshes.size();
+			});
+
+		//padding lanes are tested too, their results are never read
+		size_t const paddedCnt = (m_InstanceCnt + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+		for (auto soa : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ, &m_Radius }) soa->resize(paddedCnt);
+
+		size_t instance = 0;
+		sceneObjectManager.enumerate([this, &instance](SceneObject* sceneObj)
+			{
+				VisualComponent const* visualComp = sceneObj->findComponent<VisualComponent>();
+				if (!visualComp) return;
+
+				glm::mat4 const& model = sceneObj->getMatrix();
+				float const scale = max(glm::length(glm::vec3(model[0])), max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+
+				for (auto const& mesh : visualComp->m_ModelData->meshes)
+				{
+					glm::vec3 const center = glm::vec3(model * glm::vec4((mesh.boundsMin + mesh.boundsMax) * 0.5f, 1.0f));
+					glm::vec3 const halfSize = (mesh.boundsMax - mesh.boundsMin) * 0.5f;
+
+					//AABB enclosing transformed AABB
+					glm::vec3 const extent = glm::abs(glm::vec3(model[0])) * halfSize.x + glm::abs(glm::vec3(model[1])) * halfSize.y + glm::abs(glm::vec3(model[2])) * halfSize.z;
+
+					m_CenterX[instance] = center.x;
+					m_CenterY[instance] = center.y;
+					m_CenterZ[instance] = center.z;
+					m_ExtentX[instance] = extent.x;
+					m_ExtentY[instance] = extent.y;
+					m_ExtentZ[instance] = extent.z;
+					m_Radius[instance] = mesh.boundingSphere.w * scale;
+					++instance;
+				}
+			});
+	}
+
+	bool FrustumCuller::hasAvx()
+	{
+		//CPUID.1:ECX has AVX (bit 28) and OSXSAVE (bit 27), OS has to save YMM state too (XCR0 bits 1 and 2)
+		int info[4];
+		__cpuid(info, 1);
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+
+		return (_xgetbv(0) & 6) == 6;
+	}
+
+	void FrustumCuller::testView(Frustum const& frustum, uint8_t* visibility) const
+	{
+		//signed distance of center has to be at least -r, r is the smaller of sphere radius and AABB projected on plane normal
+		size_t const cnt = m_CenterX.size();
+
+		static bool const avx = hasAvx();
+		if (avx)
+		{
+			float const* const bounds[7] = { m_CenterX.data(), m_CenterY.data(), m_CenterZ.data(), m_ExtentX.data(), m_ExtentY.data(), m_ExtentZ.data(), m_Radius.data() };
+			float planes[6][4];
+			for (size_t p = 0; p < 6; ++p) for (int c = 0; c < 4; ++c) planes[p][c] = frustum[p][c];
+
+			testFrustumAvx(bounds, planes, cnt, visibility);
+			return;
+		}
+
+		__m128 const zero = _mm_setzero_ps();
+		__m128 const signMask = _mm_set1_ps(-0.0f);
+
+		for (size_t i = 0; i < cnt; i += 4)
+		{
+			__m128 const cx = _mm_loadu_ps(&m_CenterX[i]);
+			__m128 const cy = _mm_loadu_ps(&m_CenterY[i]);
+			__m128 const cz = _mm_loadu_ps(&m_CenterZ[i]);
+			__m128 const ex = _mm_loadu_ps(&m_ExtentX[i]);
+			__m128 const ey = _mm_loadu_ps(&m_ExtentY[i]);
+			__m128 const ez = _mm_loadu_ps(&m_ExtentZ[i]);
+			__m128 const radius = _mm_loadu_ps(&m_Radius[i]);
+
+			__m128 inside = _mm_cmpeq_ps(zero, zero);
+			for (auto const& plane : frustum)
+			{
+				__m128 const nx = _mm_set1_ps(plane.x);
+				__m128 const ny = _mm_set1_ps(plane.y);
+				__m128 const nz = _mm_set1_ps(plane.z);
+
+				__m128 const distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, nx), _mm_mul_ps(cy, ny)), _mm_add_ps(_mm_mul_ps(cz, nz), _mm_set1_ps(plane.w)));
+				__m128 const boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_andnot_ps(signMask, nx)), _mm_mul_ps(ey, _mm_andnot_ps(signMask, ny))), _mm_mul_ps(ez, _mm_andnot_ps(signMask, nz)));
+
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, _mm_min_ps(radius, boxRadius)), zero));
+			}
+
+			int const mask = _mm_movemask_ps(inside);
+			for (size_t lane = 0; lane < 4; ++lane) visibility[i + lane] = (mask >> lane) & 1;
+		}
+	}
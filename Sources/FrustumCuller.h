@@ -0,0 +1,67 @@
+#pragma once
+
+#include "SceneObjectManager.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <array>
+#include <vector>
+
+using namespace std;
+
+//Visibility of every mesh of scene objects in views given by view projection matrices (camera, lights). World bounds are
+//gathered once per frame into SoA arrays and tested against planes of all views, AVX tests 8 meshes at once when CPU supports it
+//(checked at runtime, FrustumCullerAvx.cpp), SSE 4 otherwise.
+//Mesh is culled when its bounding sphere or AABB is completely behind any plane of view frustum.
+class FrustumCuller
+{
+public:
+	struct Statistics
+	{
+		uint64_t frameCnt = 0;
+		uint64_t testedCnt = 0; //mesh instances, per view
+		uint64_t visibleCnt = 0;
+	};
+
+	//objects have to keep enumeration order until next cull
+	void cull(SceneObjectManager& sceneObjectManager, vector<glm::mat4> const& viewProjections);
+
+	//per mesh flags of objectIdx-th object in enumeration order, nullptr when not culled (draw everything)
+	uint8_t const* getMeshVisibility(size_t view, size_t objectIdx) const;
+
+	size_t getViewCnt() const;
+	Statistics const& getStatistics(size_t view) const;
+	void printStatistics() const;
+
+	using Plane = glm::vec4; //xyz normal, w distance, inside when dot(normal, pos) + w >= 0
+	using Frustum = array<Plane, 6>;
+
+	//normalized planes of clip volume of viewProjection
+	static Frustum extractPlanes(glm::mat4 const& viewProjection);
+
+	static const size_t MAX_VIEWS = 8;
+	static const size_t BATCH_SIZE = 8; //SoA arrays are padded to it
+
+private:
+	void gatherBounds(SceneObjectManager& sceneObjectManager);
+	void testView(Frustum const& frustum, uint8_t* visibility) const;
+	static bool hasAvx();
+
+	//world space bounds of mesh instances, sphere shares center with AABB
+	vector<float> m_CenterX;
+	vector<float> m_CenterY;
+	vector<float> m_CenterZ;
+	vector<float> m_ExtentX; //AABB half size
+	vector<float> m_ExtentY;
+	vector<float> m_ExtentZ;
+	vector<float> m_Radius;
+
+	size_t m_InstanceCnt = 0;
+	vector<size_t> m_FirstInstance; //per object
+	vector<uint8_t> m_Visibility; //[view][instance], padded rows
+	size_t m_ViewCnt = 0;
+
+	array<Statistics, MAX_VIEWS> m_Statistics;
+};
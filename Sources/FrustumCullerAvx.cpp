@@ -0,0 +1,38 @@
+
+#include "FrustumCullerAvx.h"
+
+#include <immintrin.h>
+
+
+	void testFrustumAvx(float const* const bounds[7], float const planes[6][4], size_t cnt, uint8_t* visibility)
+	{
+		__m256 const zero = _mm256_setzero_ps();
+		__m256 const signMask = _mm256_set1_ps(-0.0f);
+
+		for (size_t i = 0; i < cnt; i += 8)
+		{
+			__m256 const cx = _mm256_loadu_ps(bounds[0] + i);
+			__m256 const cy = _mm256_loadu_ps(bounds[1] + i);
+			__m256 const cz = _mm256_loadu_ps(bounds[2] + i);
+			__m256 const ex = _mm256_loadu_ps(bounds[3] + i);
+			__m256 const ey = _mm256_loadu_ps(bounds[4] + i);
+			__m256 const ez = _mm256_loadu_ps(bounds[5] + i);
+			__m256 const radius = _mm256_loadu_ps(bounds[6] + i);
+
+			__m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+			for (size_t p = 0; p < 6; ++p)
+			{
+				__m256 const nx = _mm256_set1_ps(planes[p][0]);
+				__m256 const ny = _mm256_set1_ps(planes[p][1]);
+				__m256 const nz = _mm256_set1_ps(planes[p][2]);
+
+				__m256 const distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, nx), _mm256_mul_ps(cy, ny)), _mm256_add_ps(_mm256_mul_ps(cz, nz), _mm256_set1_ps(planes[p][3])));
+				__m256 const boxRadius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, _mm256_andnot_ps(signMask, nx)), _mm256_mul_ps(ey, _mm256_andnot_ps(signMask, ny))), _mm256_mul_ps(ez, _mm256_andnot_ps(signMask, nz)));
+
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, _mm256_min_ps(radius, boxRadius)), zero, _CMP_GE_OQ));
+			}
+
+			int const mask = _mm256_movemask_ps(inside);
+			for (size_t lane = 0; lane < 8; ++lane) visibility[i + lane] = (mask >> lane) & 1;
+		}
+	}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//8 wide frustum test of FrustumCuller, FrustumCullerAvx.cpp is the only file compiled with /arch:AVX (CMakeLists.txt).
+//Call only when CPU and OS support AVX (FrustumCuller checks it once at runtime). Takes plain arrays and includes no shared
+//headers, so no inline function used by other files gets compiled with AVX encoding.
+//bounds: centerX, centerY, centerZ, extentX, extentY, extentZ, radius padded to multiple of 8, planes: xyz normal, w distance
+void testFrustumAvx(float const* const bounds[7], float const planes[6][4], size_t cnt, uint8_t* visibility);
@@ -0,0 +1,340 @@
+
+#include "GeometryPool.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+
+	GeometryPool::GeometryPool(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing) :
+		m_PhysicalDevice(physicalDevice), m_Device(device), m_StagingRing(stagingRing)
+	{
+		m_Strides.fill(0);
+	}
+
+	GeometryPool::~GeometryPool()
+	{
+		for (auto& blocks : m_Blocks)
+		{
+			for (auto& block : blocks)
+			{
+				vkDestroyBuffer(m_Device, block.buffer, nullptr);
+				MemoryAllocator::get(m_Device).free(block.memory);
+			}
+		}
+	}
+
+	uint32_t GeometryPool::createBlock(GeometryStream stream, uint32_t minCapacity)
+	{
+		size_t const streamIdx = static_cast<size_t>(stream);
+
+		Block block;
+		block.capacity = max(static_cast<uint32_t>(BLOCK_SIZE / m_Strides[streamIdx]), minCapacity);
+		block.freeRanges[0] = block.capacity;
+
+		VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		usage |= (stream == GeometryStream::INDEX16 || stream == GeometryStream::INDEX32) ? VK_BUFFER_USAGE_INDEX_BUFFER_BIT : VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+
+		VulkanHelpers::allocateBuffer(block.buffer, block.memory, m_PhysicalDevice, m_Device, static_cast<VkDeviceSize>(block.capacity) * m_Strides[streamIdx], usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		//block indices are stored in ranges, so released slots are reused instead of erased
+		auto& blocks = m_Blocks[streamIdx];
+		auto it = find_if(begin(blocks), end(blocks), [](Block const& candidate) { return candidate.buffer == VK_NULL_HANDLE; });
+		if (it != end(blocks))
+		{
+			*it = move(block);
+			return static_cast<uint32_t>(it - begin(blocks));
+		}
+
+		blocks.push_back(move(block));
+		return static_cast<uint32_t>(blocks.size() - 1);
+	}
+
+	void GeometryPool::releaseBlock(Block& block)
+	{
+		vkDestroyBuffer(m_Device, block.buffer, nullptr);
+		MemoryAllocator::get(m_Device).free(block.memory);
+
+		block.buffer = VK_NULL_HANDLE;
+		block.memory = MemoryAllocation();
+		block.capacity = 0;
+		block.freeRanges.clear();
+		block.evacuating = false;
+	}
+
+	bool GeometryPool::allocateRange(GeometryStream stream, uint32_t count, GeometryRange& outRange)
+	{
+		size_t const streamIdx = static_cast<size_t>(stream);
+
+		//first fit
+		for (uint32_t blockIdx = 0; blockIdx < m_Blocks[streamIdx].size(); ++blockIdx)
+		{
+			auto& block = m_Blocks[streamIdx][blockIdx];
+			if (block.buffer == VK_NULL_HANDLE || block.evacuating) continue;
+
+			auto it = find_if(begin(block.freeRanges), end(block.freeRanges), [count](auto const& freeRange) { return freeRange.second >= count; });
+			if (it != end(block.freeRanges))
+			{
+				outRange.buffer = block.buffer;
+				outRange.stream = stream;
+				outRange.block = blockIdx;
+				outRange.offset = it->first;
+				outRange.count = count;
+				outRange.stride = m_Strides[streamIdx];
+
+				if (it->second > count) block.freeRanges[it->first + count] = it->second - count;
+				block.freeRanges.erase(it);
+
+				block.usedRanges[outRange.offset] = count;
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	GeometryRange GeometryPool::allocate(GeometryStream stream, void const* data, uint32_t count, uint32_t stride)
+	{
+		size_t const streamIdx = static_cast<size_t>(stream);
+
+		assert(count > 0);
+		assert((m_Strides[streamIdx] == 0 || m_Strides[streamIdx] == stride) && "All allocations from one stream need the same stride!");
+		m_Strides[streamIdx] = stride;
+
+		GeometryRange range;
+		if (!allocateRange(stream, count, range))
+		{
+			createBlock(stream, count);
+
+			bool const allocated = allocateRange(stream, count, range);
+			assert(allocated);
+		}
+
+		m_StagingRing.copyToBuffer(range.buffer, static_cast<VkDeviceSize>(range.offset) * stride, data, static_cast<VkDeviceSize>(count) * stride);
+
+		return range;
+	}
+
+	void GeometryPool::retire(GeometryRange const& range)
+	{
+		if (range.count == 0) return;
+
+		//dead range is not moved by defragmentation, it is freed by defragment once frames in flight are finished
+		m_Blocks[static_cast<size_t>(range.stream)][range.block].usedRanges.erase(range.offset);
+		m_RetiredRanges.push_back({ range, m_Frame });
+	}
+
+	void GeometryPool::free(GeometryRange const& range)
+	{
+		if (range.count == 0) return;
+
+		auto& block = m_Blocks[static_cast<size_t>(range.stream)][range.block];
+		auto& freeRanges = block.freeRanges;
+
+		//moved ranges were already removed from usedRanges when they were retired
+		block.usedRanges.erase(range.offset);
+
+		uint32_t offset = range.offset;
+		uint32_t count = range.count;
+
+		//merge with neighbours
+		auto next = freeRanges.lower_bound(offset);
+		if (next != end(freeRanges) && next->first == offset + count)
+		{
+			count += next->second;
+			next = freeRanges.erase(next);
+		}
+
+		if (next != begin(freeRanges))
+		{
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset)
+			{
+				offset = prev->first;
+				count += prev->second;
+				freeRanges.erase(prev);
+			}
+		}
+
+		freeRanges[offset] = count;
+	}
+
+	bool GeometryPool::selectEvacuatedBlock(GeometryStream stream, uint32_t& outBlockIdx)
+	{
+		size_t const streamIdx = static_cast<size_t>(stream);
+		auto& blocks = m_Blocks[streamIdx];
+
+		for (uint32_t blockIdx = 0; blockIdx < blocks.size(); ++blockIdx)
+		{
+			if (blocks[blockIdx].evacuating)
+			{
+				outBlockIdx = blockIdx;
+				return true;
+			}
+		}
+
+		//sparsest block, its ranges have to fit into free space of the others
+		uint32_t liveBlockCnt = 0;
+		uint64_t freeCnt = 0;
+		uint64_t minUsedCnt = numeric_limits<uint64_t>::max();
+
+		for (uint32_t blockIdx = 0; blockIdx < blocks.size(); ++blockIdx)
+		{
+			auto const& block = blocks[blockIdx];
+			if (block.buffer == VK_NULL_HANDLE) continue;
+
+			uint64_t blockFreeCnt = 0;
+			for (auto const& freeRange : block.freeRanges) blockFreeCnt += freeRange.second;
+
+			uint64_t const usedCnt = block.capacity - blockFreeCnt;
+
+			++liveBlockCnt;
+			freeCnt += blockFreeCnt;
+
+			if (usedCnt < minUsedCnt && usedCnt < block.capacity * DEFRAG_MAX_USAGE)
+			{
+				minUsedCnt = usedCnt;
+				outBlockIdx = blockIdx;
+			}
+		}
+
+		if (liveBlockCnt < 2 || minUsedCnt == numeric_limits<uint64_t>::max()) return false;
+
+		uint64_t const candidateFreeCnt = blocks[outBlockIdx].capacity - minUsedCnt;
+		if (freeCnt - candidateFreeCnt < minUsedCnt) return false;
+
+		blocks[outBlockIdx].evacuating = true;
+
+		return true;
+	}
+
+	vector<GeometryRelocation> GeometryPool::defragment(VkDeviceSize maxBytes)
+	{
+		++m_Frame;
+
+		//ranges moved away RETIRE_FRAMES ago are not referenced by any command buffer anymore
+		while (!m_RetiredRanges.empty() && m_RetiredRanges.front().frame + RETIRE_FRAMES <= m_Frame)
+		{
+			free(m_RetiredRanges.front().range);
+			m_RetiredRanges.pop_front();
+		}
+
+		for (size_t streamIdx = 0; streamIdx < m_Blocks.size(); ++streamIdx)
+		{
+			for (uint32_t blockIdx = 0; blockIdx < m_Blocks[streamIdx].size(); ++blockIdx)
+			{
+				auto& block = m_Blocks[streamIdx][blockIdx];
+				if (!block.evacuating || !block.usedRanges.empty()) continue;
+
+				bool const retiring = any_of(begin(m_RetiredRanges), end(m_RetiredRanges), [streamIdx, blockIdx](RetiredRange const& retired)
+					{
+						return static_cast<size_t>(retired.range.stream) == streamIdx && retired.range.block == blockIdx;
+					});
+
+				if (!retiring) releaseBlock(block);
+			}
+		}
+
+		vector<GeometryRelocation> relocations;
+		VkDeviceSize copiedBytes = 0;
+
+		for (size_t streamIdx = 0; streamIdx < m_Blocks.size() && copiedBytes < maxBytes; ++streamIdx)
+		{
+			GeometryStream const stream = static_cast<GeometryStream>(streamIdx);
+
+			uint32_t blockIdx;
+			if (!selectEvacuatedBlock(stream, blockIdx)) continue;
+
+			auto& usedRanges = m_Blocks[streamIdx][blockIdx].usedRanges;
+
+			while (!usedRanges.empty())
+			{
+				GeometryRelocation relocation;
+				relocation.from.buffer = m_Blocks[streamIdx][blockIdx].buffer;
+				relocation.from.stream = stream;
+				relocation.from.block = blockIdx;
+				relocation.from.offset = begin(usedRanges)->first;
+				relocation.from.count = begin(usedRanges)->second;
+				relocation.from.stride = m_Strides[streamIdx];
+
+				VkDeviceSize const size = static_cast<VkDeviceSize>(relocation.from.count) * relocation.from.stride;
+				if (copiedBytes > 0 && copiedBytes + size > maxBytes) break;
+
+				//free space of other blocks is too fragmented, keep block
+				if (!allocateRange(stream, relocation.from.count, relocation.to))
+				{
+					m_Blocks[streamIdx][blockIdx].evacuating = false;
+					break;
+				}
+
+				m_StagingRing.copyBuffer(relocation.from.buffer, static_cast<VkDeviceSize>(relocation.from.offset) * relocation.from.stride,
+					relocation.to.buffer, static_cast<VkDeviceSize>(relocation.to.offset) * relocation.to.stride, size);
+
+				usedRanges.erase(begin(usedRanges));
+				m_RetiredRanges.push_back({ relocation.from, m_Frame });
+				relocations.push_back(relocation);
+
+				copiedBytes += size;
+			}
+		}
+
+		return relocations;
+	}
+
+	float GeometryPool::getFragmentation() const
+	{
+		VkDeviceSize freeSize = 0;
+		VkDeviceSize fragmentedSize = 0;
+
+		for (size_t streamIdx = 0; streamIdx < m_Blocks.size(); ++streamIdx)
+		{
+			VkDeviceSize streamFreeSize = 0;
+			VkDeviceSize largestFreeSize = 0;
+
+			for (auto const& block : m_Blocks[streamIdx])
+			{
+				for (auto const& freeRange : block.freeRanges)
+				{
+					VkDeviceSize const size = static_cast<VkDeviceSize>(freeRange.second) * m_Strides[streamIdx];
+					streamFreeSize += size;
+					largestFreeSize = max(largestFreeSize, size);
+				}
+			}
+
+			freeSize += streamFreeSize;
+			fragmentedSize += streamFreeSize - largestFreeSize;
+		}
+
+		return freeSize == 0 ? 0.0f : static_cast<float>(fragmentedSize) / freeSize;
+	}
+
+	void GeometryPool::read(GeometryRange const& range, void* outData) const
+	{
+		m_StagingRing.copyFromBuffer(range.buffer, static_cast<VkDeviceSize>(range.offset) * range.stride, outData, static_cast<VkDeviceSize>(range.count) * range.stride);
+	}
+
+	size_t GeometryPool::getBlockCnt() const
+	{
+		size_t blockCnt = 0;
+		for (auto const& blocks : m_Blocks) blockCnt += count_if(begin(blocks), end(blocks), [](Block const& block) { return block.buffer != VK_NULL_HANDLE; });
+
+		return blockCnt;
+	}
+
+	VkDeviceSize GeometryPool::getFreeSize() const
+	{
+		VkDeviceSize freeSize = 0;
+
+		for (size_t streamIdx = 0; streamIdx < m_Blocks.size(); ++streamIdx)
+		{
+			for (auto const& block : m_Blocks[streamIdx])
+			{
+				for (auto const& freeRange : block.freeRanges) freeSize += static_cast<VkDeviceSize>(freeRange.second) * m_Strides[streamIdx];
+			}
+		}
+
+		return freeSize;
+	}
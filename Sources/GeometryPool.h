@@ -0,0 +1,134 @@
+#pragma once
+
+#include "VulkanHelper.h"
+#include "StagingRing.h"
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <deque>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+enum class GeometryStream
+{
+	VERTEX,
+	POSITION,
+	INDEX16,
+	INDEX32,
+	COUNT
+};
+
+//Sub-allocated range of pool buffer, offset and count are in elements so they can be used directly as vertexOffset / firstIndex
+struct GeometryRange
+{
+	VkBuffer buffer = VK_NULL_HANDLE;
+	GeometryStream stream = GeometryStream::VERTEX;
+	uint32_t block = 0;
+	uint32_t offset = 0;
+	uint32_t count = 0;
+	uint32_t stride = 0;
+};
+
+//Live range moved by defragmentation, handles equal to from have to be replaced by to
+struct GeometryRelocation
+{
+	GeometryRange from;
+	GeometryRange to;
+};
+
+//Currently bound geometry buffers of command buffer, consecutive draws from the same pool blocks skip rebinding
+struct GeometryBindings
+{
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	VkIndexType indexType = VK_INDEX_TYPE_MAX_ENUM;
+
+	void bind(VkCommandBuffer commandBuffer, VkBuffer newVertexBuffer, VkBuffer newIndexBuffer, VkIndexType newIndexType)
+	{
+		if (newVertexBuffer != vertexBuffer)
+		{
+			VkDeviceSize offsets[] = { 0 };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &newVertexBuffer, offsets);
+			vertexBuffer = newVertexBuffer;
+		}
+
+		if (newIndexBuffer != indexBuffer || newIndexType != indexType)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, newIndexBuffer, 0, newIndexType);
+			indexBuffer = newIndexBuffer;
+			indexType = newIndexType;
+		}
+	}
+};
+
+//Few large device local buffers per stream, meshes get ranges of them instead of own buffers and memory
+class GeometryPool
+{
+public:
+	GeometryPool(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing);
+	~GeometryPool();
+
+	//queues upload of data into pool, every allocation from one stream has to use the same stride
+	GeometryRange allocate(GeometryStream stream, void const* data, uint32_t count, uint32_t stride);
+	void free(GeometryRange const& range);
+
+	//free of range which frames in flight can still read, space is reused after RETIRE_FRAMES calls of defragment
+	void retire(GeometryRange const& range);
+
+	//copies content of range back to CPU, outData has to hold count * stride bytes
+	void read(GeometryRange const& range, void* outData) const;
+
+	template<typename T> GeometryRange allocate(GeometryStream stream, vector<T> const& data)
+	{
+		return allocate(stream, &data[0], static_cast<uint32_t>(data.size()), sizeof(T));
+	}
+
+	//moves ranges out of sparse blocks into denser ones and releases emptied blocks, has to be called once per frame
+	//before recording, copies at most maxBytes (at least one range) and returned relocations have to be applied to handles
+	vector<GeometryRelocation> defragment(VkDeviceSize maxBytes);
+
+	//1 - largest free range / all free space, 0 when free space of every stream is contiguous
+	float getFragmentation() const;
+
+	size_t getBlockCnt() const;
+	VkDeviceSize getFreeSize() const;
+
+private:
+	struct Block
+	{
+		VkBuffer buffer; //VK_NULL_HANDLE when block was released, slot is reused by next block of stream
+		MemoryAllocation memory;
+		uint32_t capacity; //in elements
+		map<uint32_t, uint32_t> freeRanges; //offset -> count
+		map<uint32_t, uint32_t> usedRanges; //offset -> count
+		bool evacuating = false; //no new allocations, released when last range is moved out
+	};
+
+	//moved away or unloaded range, GPU can still read it until frames in flight are finished
+	struct RetiredRange
+	{
+		GeometryRange range;
+		uint64_t frame;
+	};
+
+	static const VkDeviceSize BLOCK_SIZE = 16 * 1024 * 1024;
+	static constexpr float DEFRAG_MAX_USAGE = 0.5f; //only blocks used less than this are evacuated
+	static const uint64_t RETIRE_FRAMES = 3; //frames in flight + frame being recorded
+
+	uint32_t createBlock(GeometryStream stream, uint32_t minCapacity);
+	void releaseBlock(Block& block);
+	bool allocateRange(GeometryStream stream, uint32_t count, GeometryRange& outRange);
+	bool selectEvacuatedBlock(GeometryStream stream, uint32_t& outBlockIdx);
+
+	VkPhysicalDevice m_PhysicalDevice;
+	VkDevice m_Device;
+	StagingRing& m_StagingRing;
+
+	array<vector<Block>, static_cast<size_t>(GeometryStream::COUNT)> m_Blocks;
+	array<uint32_t, static_cast<size_t>(GeometryStream::COUNT)> m_Strides;
+
+	deque<RetiredRange> m_RetiredRanges;
+	uint64_t m_Frame = 0;
+};
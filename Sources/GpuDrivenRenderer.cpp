@@ -0,0 +1,450 @@
+
+#include "GpuDrivenRenderer.h"
+#include "FrustumCuller.h"
+#include "VisualComponent.h"
+#include "CpuProfiler.h"
+
+#include <assert.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+
+using namespace std;
+
+
+	GpuDrivenRenderer::GpuDrivenRenderer(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing, UniformRing& uniformRing, GpuProfiler& gpuProfiler, HiZPyramid& hiZPyramid, uint32_t frameCnt,
+		bool drawIndirectCount, VkRenderPass gBufferRenderPass, VkExtent2D extent, shared_ptr<DescriptorSetLayout> materialDescriptorSetLayout, shared_ptr<DescriptorSetLayout> sceneDescriptorSetLayout)
+		: m_PhysicalDevice(physicalDevice), m_Device(device), m_StagingRing(stagingRing), m_UniformRing(uniformRing), m_GpuProfiler(gpuProfiler), m_HiZPyramid(hiZPyramid)
+	{
+		assert(isSupported(physicalDevice));
+
+		if (drawIndirectCount)
+		{
+			m_DrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(m_Device, "vkCmdDrawIndexedIndirectCountKHR"));
+		}
+
+		m_CullScope = m_GpuProfiler.createScope("gpu culling");
+		m_Frames.resize(frameCnt);
+
+		createCullPipeline();
+		createDrawPipeline(gBufferRenderPass, extent, materialDescriptorSetLayout, sceneDescriptorSetLayout);
+	}
+
+	GpuDrivenRenderer::~GpuDrivenRenderer()
+	{
+		vkDestroyPipeline(m_Device, m_CullPipeline, nullptr);
+		vkDestroyPipelineLayout(m_Device, m_CullPipelineLayout, nullptr);
+	}
+
+	bool GpuDrivenRenderer::isSupported(VkPhysicalDevice physicalDevice)
+	{
+		VkPhysicalDeviceFeatures features;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+
+		if (features.drawIndirectFirstInstance != VK_TRUE || features.multiDrawIndirect != VK_TRUE)
+			return false;
+
+		//shaders of culling, indirect G-buffer and Hi-Z pass, missing binary falls back to recording on CPU
+		for (auto path : { "./../Shaders/cullDrawsCompute.spv", "./../Shaders/vertIndirect.spv", "./../Shaders/hiZFrag.spv" })
+		{
+			if (!ifstream(path, ifstream::binary))
+			{
+				cout << "GPU driven rendering disabled, " << path << " not found" << endl;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void GpuDrivenRenderer::build(SceneObjectManager& sceneObjectManager)
+	{
+		PROFILE_FUNCTION();
+
+		m_Meshes.clear();
+		m_MeshSources.clear();
+
+		unordered_map<MeshData const*, uint32_t> meshIndices;
+		vector<GpuDraw> draws;
+		vector<VkDescriptorSet> materials;
+
+		sceneObjectManager.enumerate([&](SceneObject* sceneObj)
+			{
+				VisualComponent const* visualComp = sceneObj->findComponent<VisualComponent>();
+				if (!visualComp) return;
+
+				glm::mat4 const& model = sceneObj->getMatrix();
+				float const scale = max(glm::length(glm::vec3(model[0])), max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+
+				ModelData const& modelData = *visualComp->m_ModelData;
+				for (size_t i = 0; i < modelData.meshes.size(); ++i)
+				{
+					MeshData const& mesh = modelData.meshes[i];
+					assert(mesh.vertexFormat == VertexFormatType::FULL);
+
+					auto meshIt = meshIndices.find(&mesh);
+					if (meshIt == meshIndices.end())
+					{
+						meshIt = meshIndices.emplace(&mesh, static_cast<uint32_t>(m_Meshes.size())).first;
+
+						GpuMesh gpuMesh = {};
+						gpuMesh.boundingSphere = mesh.boundingSphere;
+						gpuMesh.halfSize = glm::vec4((mesh.boundsMax - mesh.boundsMin) * 0.5f, 0.0f);
+						gpuMesh.lodCnt = static_cast<uint32_t>(min<size_t>(mesh.lods.size(), MAX_LOD_CNT));
+						for (uint32_t lod = 0; lod < gpuMesh.lodCnt; ++lod) gpuMesh.lodError[lod] = mesh.lods[lod].error;
+						writeGeometryRanges(gpuMesh, mesh);
+
+						m_Meshes.push_back(gpuMesh);
+						m_MeshSources.push_back(&mesh);
+					}
+
+					GpuDraw draw = {};
+					draw.model = model;
+					draw.mesh = meshIt->second;
+					draw.scale = scale;
+					draws.push_back(draw);
+					materials.push_back(modelData.materials[i]->m_ShaderParams.getDescriptorSet());
+				}
+			});
+
+		createBatches(move(draws), materials);
+		++m_MeshVersion;
+	}
+
+	void GpuDrivenRenderer::relocate()
+	{
+		PROFILE_FUNCTION();
+
+		bool meshesMoved = false;
+		for (size_t i = 0; i < m_Meshes.size(); ++i)
+		{
+			GpuMesh gpuMesh = m_Meshes[i];
+			writeGeometryRanges(gpuMesh, *m_MeshSources[i]);
+			if (memcmp(&gpuMesh, &m_Meshes[i], sizeof(GpuMesh)) == 0) continue;
+
+			m_Meshes[i] = gpuMesh;
+			meshesMoved = true;
+		}
+
+		//ranges moved into other pool blocks, batch keeps its draws while all of them use the same buffers
+		bool regroup = false;
+		for (Batch& batch : m_Batches)
+		{
+			MeshData const& first = *m_MeshSources[m_Draws[batch.firstCommand].mesh];
+			for (uint32_t i = batch.firstCommand; i < batch.firstCommand + batch.commandCnt && !regroup; ++i)
+			{
+				MeshData const& mesh = *m_MeshSources[m_Draws[i].mesh];
+				regroup = mesh.vertices.buffer != first.vertices.buffer || mesh.indices.buffer != first.indices.buffer;
+			}
+
+			batch.vertexBuffer = first.vertices.buffer;
+			batch.indexBuffer = first.indices.buffer;
+		}
+
+		if (regroup)
+		{
+			vector<VkDescriptorSet> materials;
+			for (GpuDraw const& draw : m_Draws) materials.push_back(m_Batches[draw.batch].material);
+
+			createBatches(m_Draws, materials);
+		}
+
+		if (meshesMoved) ++m_MeshVersion;
+	}
+
+	void GpuDrivenRenderer::createBatches(vector<GpuDraw> draws, vector<VkDescriptorSet> const& materials)
+	{
+		m_Draws.clear();
+		m_Batches.clear();
+		m_BatchFirstCommands.clear();
+
+		map<tuple<VkDescriptorSet, VkBuffer, VkBuffer, VkIndexType>, uint32_t> batchIndices;
+		vector<vector<GpuDraw>> batchDraws;
+
+		for (size_t i = 0; i < draws.size(); ++i)
+		{
+			MeshData const& mesh = *m_MeshSources[draws[i].mesh];
+
+			auto const key = make_tuple(materials[i], mesh.vertices.buffer, mesh.indices.buffer, mesh.getIndexType());
+			auto batchIt = batchIndices.find(key);
+			if (batchIt == batchIndices.end())
+			{
+				batchIt = batchIndices.emplace(key, static_cast<uint32_t>(m_Batches.size())).first;
+				m_Batches.push_back({ get<0>(key), get<1>(key), get<2>(key), get<3>(key), 0, 0 });
+				batchDraws.emplace_back();
+			}
+
+			draws[i].batch = batchIt->second;
+			batchDraws[batchIt->second].push_back(draws[i]);
+		}
+
+		//draws are sorted by batch, without compaction command of draw is at draw index
+		for (size_t batch = 0; batch < m_Batches.size(); ++batch)
+		{
+			m_Batches[batch].firstCommand = static_cast<uint32_t>(m_Draws.size());
+			m_Batches[batch].commandCnt = static_cast<uint32_t>(batchDraws[batch].size());
+			m_BatchFirstCommands.push_back(m_Batches[batch].firstCommand);
+			m_Draws.insert(m_Draws.end(), batchDraws[batch].begin(), batchDraws[batch].end());
+		}
+
+		++m_Version;
+	}
+
+	void GpuDrivenRenderer::cull(VkCommandBuffer commandBuffer, uint32_t frame, glm::mat4 const& projection, glm::mat4 const& cameraMatrix, float viewportHeight, float lodPixelThreshold)
+	{
+		PROFILE_FUNCTION();
+
+		if (m_Draws.empty()) return;
+
+		FrameData& frameData = m_Frames[frame];
+
+		//fence of this frame slot was waited, counts of its previous culling are available
+		if (frameData.readbackPending)
+		{
+			vector<uint32_t> counts(frameData.readback->count);
+			frameData.readback->read(counts.data(), 0, counts.size());
+
+			uint64_t const visibleCnt = accumulate(counts.begin(), counts.end(), uint64_t(0));
+			m_VisibleDrawSum += visibleCnt;
+			++m_CulledFrameCnt;
+
+			PROFILE_COUNTER("GPU visible draws", static_cast<double>(visibleCnt));
+		}
+
+		updateFrameData(frameData);
+
+		m_Projection = projection;
+		m_ViewportHeight = viewportHeight;
+		m_LodPixelThreshold = lodPixelThreshold;
+		m_CullHiZViewProjection = m_BuildHiZViewProjection;
+		m_BuildHiZViewProjection = projection * glm::inverse(cameraMatrix);
+		m_CullHiZLevelCnt = m_HiZPyramid.isBuilt() ? m_HiZPyramid.getLevelCnt() : 0;
+
+		CullParamsUBO params;
+		writeCullParams(params, cameraMatrix);
+		uint32_t const paramsOffset = m_UniformRing.push(params);
+		m_LatchedParams.push_back(static_cast<CullParamsUBO*>(m_UniformRing.getMappedData(paramsOffset)));
+
+		GpuScope gpuScope(m_GpuProfiler, commandBuffer, m_CullScope);
+
+		vkCmdFillBuffer(commandBuffer, frameData.counts->buffer, 0, VK_WHOLE_SIZE, 0);
+
+		//Hi-Z pyramid was rendered by previous frame, counts are cleared
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipeline);
+
+		VkDescriptorSet descriptorSet = frameData.cullDescriptorSet->getDescriptorSet();
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipelineLayout, 0, 1, &descriptorSet, 1, &paramsOffset);
+		vkCmdDispatch(commandBuffer, (static_cast<uint32_t>(m_Draws.size()) + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+		//commands and counts are read by indirect draws, counts are copied for statistics
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		VkBufferCopy region = { 0, 0, frameData.counts->size };
+		vkCmdCopyBuffer(commandBuffer, frameData.counts->buffer, frameData.readback->buffer, 1, &region);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		frameData.readbackPending = true;
+	}
+
+	void GpuDrivenRenderer::latch(glm::mat4 const& cameraMatrix)
+	{
+		for (auto params : m_LatchedParams) writeCullParams(*params, cameraMatrix);
+		m_LatchedParams.clear();
+
+		//G-buffer of this frame is rendered with latched camera, so is its Hi-Z pyramid
+		m_BuildHiZViewProjection = m_Projection * glm::inverse(cameraMatrix);
+	}
+
+	void GpuDrivenRenderer::draw(VkCommandBuffer commandBuffer, uint32_t frame, VkDescriptorSet sceneDescriptorSet, uint32_t sceneOffset) const
+	{
+		PROFILE_FUNCTION();
+
+		if (m_Draws.empty()) return;
+
+		FrameData const& frameData = m_Frames[frame];
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_DrawPipeline);
+
+		VkDescriptorSet descriptorSets[] = { sceneDescriptorSet, frameData.drawDescriptorSet->getDescriptorSet() };
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_DrawPipelineLayout, 1, 2, descriptorSets, 1, &sceneOffset);
+
+		GeometryBindings bindings;
+		for (uint32_t i = 0; i < m_Batches.size(); ++i)
+		{
+			Batch const& batch = m_Batches[i];
+
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_DrawPipelineLayout, 0, 1, &batch.material, 0, nullptr);
+			bindings.bind(commandBuffer, batch.vertexBuffer, batch.indexBuffer, batch.indexType);
+
+			VkDeviceSize const offset = sizeof(VkDrawIndexedIndirectCommand) * batch.firstCommand;
+			if (m_DrawIndexedIndirectCount)
+			{
+				m_DrawIndexedIndirectCount(commandBuffer, frameData.commands->buffer, offset, frameData.counts->buffer, sizeof(uint32_t) * i, batch.commandCnt, sizeof(VkDrawIndexedIndirectCommand));
+			}
+			else
+			{
+				vkCmdDrawIndexedIndirect(commandBuffer, frameData.commands->buffer, offset, batch.commandCnt, sizeof(VkDrawIndexedIndirectCommand));
+			}
+		}
+	}
+
+	void GpuDrivenRenderer::printStatistics() const
+	{
+		cout << "GPU driven rendering: " << m_Draws.size() << " draws in " << m_Batches.size() << " batches, "
+			<< (m_DrawIndexedIndirectCount ? "vkCmdDrawIndexedIndirectCountKHR" : "vkCmdDrawIndexedIndirect without compaction") << endl;
+
+		if (m_CulledFrameCnt > 0)
+		{
+			double const visible = static_cast<double>(m_VisibleDrawSum) / m_CulledFrameCnt;
+			cout << "  visible draws per frame: " << visible << " (" << (m_Draws.empty() ? 0.0 : 100.0 * (1.0 - visible / m_Draws.size())) << " % culled)" << endl;
+		}
+	}
+
+	void GpuDrivenRenderer::createCullPipeline()
+	{
+		m_CullDescriptorSetLayout = make_shared<DescriptorSetLayout>(m_Device);
+		m_CullDescriptorSetLayout->addDescriptor("cullParams", 0, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+		m_CullDescriptorSetLayout->addDescriptor("meshes", 1, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		m_CullDescriptorSetLayout->addDescriptor("draws", 2, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		m_CullDescriptorSetLayout->addDescriptor("batchFirstCommands", 3, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		m_CullDescriptorSetLayout->addDescriptor("commands", 4, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		m_CullDescriptorSetLayout->addDescriptor("counts", 5, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		m_CullDescriptorSetLayout->addDescriptor("hiZ", 6, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		m_CullDescriptorSetLayout->createDescriptorSetLayout();
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCreateInfo.setLayoutCount = 1;
+
+		auto layout = m_CullDescriptorSetLayout->getLayout();
+		pipelineLayoutCreateInfo.pSetLayouts = &layout;
+
+		auto res = vkCreatePipelineLayout(m_Device, &pipelineLayoutCreateInfo, nullptr, &m_CullPipelineLayout);
+		assert(res == VK_SUCCESS);
+
+		VkPipelineShaderStageCreateInfo shaderStage = {};
+		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		shaderStage.pName = "main";
+		shaderStage.module = PipelineRegistry::get(m_Device).getShaderModule("./../Shaders/cullDrawsCompute.spv");
+
+		VkComputePipelineCreateInfo computePipelineCreateInfo{};
+		computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		computePipelineCreateInfo.layout = m_CullPipelineLayout;
+		computePipelineCreateInfo.stage = shaderStage;
+
+		res = vkCreateComputePipelines(m_Device, PipelineCache::get(m_Device).getCache(), 1, &computePipelineCreateInfo, nullptr, &m_CullPipeline);
+		assert(res == VK_SUCCESS);
+	}
+
+	void GpuDrivenRenderer::createDrawPipeline(VkRenderPass gBufferRenderPass, VkExtent2D extent, shared_ptr<DescriptorSetLayout> const& materialDescriptorSetLayout, shared_ptr<DescriptorSetLayout> const& sceneDescriptorSetLayout)
+	{
+		m_DrawDescriptorSetLayout = make_shared<DescriptorSetLayout>(m_Device);
+		m_DrawDescriptorSetLayout->addDescriptor("draws", 0, VK_SHADER_STAGE_VERTEX_BIT, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		m_DrawDescriptorSetLayout->createDescriptorSetLayout();
+
+		//G-buffer pipeline of deferred renderer, model matrix comes from draws instead of push constant
+		ShaderSet shaderData;
+		shaderData.vertexInputAttributeDescription = VertexFormat::getAttributeDescriptions(VertexFormatType::FULL);
+		shaderData.vertexInputBindingDescription = VertexFormat::getBindingDescription(VertexFormatType::FULL);
+		shaderData.vertexShaderPath = string("./../Shaders/vertIndirect.spv");
+		shaderData.fragmentShaderPath = string("./../Shaders/defferedShader1stPass.spv");
+		shaderData.descriptorSetLayout.push_back(materialDescriptorSetLayout->getLayout());
+		shaderData.descriptorSetLayout.push_back(sceneDescriptorSetLayout->getLayout());
+		shaderData.descriptorSetLayout.push_back(m_DrawDescriptorSetLayout->getLayout());
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		VulkanHelpers::createGraphicsPipeline(m_Device, gBufferRenderPass, 4, extent, shaderData, false, inputAssembly, m_DrawPipelineLayout, m_DrawPipeline);
+	}
+
+	void GpuDrivenRenderer::writeGeometryRanges(GpuMesh& gpuMesh, MeshData const& mesh)
+	{
+		for (uint32_t lod = 0; lod < gpuMesh.lodCnt; ++lod)
+		{
+			gpuMesh.lodFirstIndex[lod] = mesh.indices.offset + mesh.lods[lod].firstIndex;
+			gpuMesh.lodIndexCount[lod] = mesh.lods[lod].indexCount;
+		}
+		gpuMesh.vertexOffset = static_cast<int32_t>(mesh.vertices.offset);
+	}
+
+	void GpuDrivenRenderer::updateFrameData(FrameData& frameData)
+	{
+		//frame slot is not used by GPU anymore, its buffers can be rewritten or released
+		if (frameData.version == m_Version)
+		{
+			//only geometry ranges were patched by relocate
+			if (frameData.meshVersion != m_MeshVersion) frameData.meshes->write(m_Meshes.data(), 0, m_Meshes.size());
+			frameData.meshVersion = m_MeshVersion;
+			return;
+		}
+
+		frameData.version = m_Version;
+		frameData.meshVersion = m_MeshVersion;
+		frameData.readbackPending = false;
+
+		frameData.meshes = make_unique<Buffer>(m_PhysicalDevice, m_Device, m_Meshes.data(), m_Meshes.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		frameData.draws = make_unique<Buffer>(m_PhysicalDevice, m_Device, m_Draws.data(), m_Draws.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		frameData.batchFirstCommands = make_unique<Buffer>(m_PhysicalDevice, m_Device, m_BatchFirstCommands.data(), m_BatchFirstCommands.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+		vector<VkDrawIndexedIndirectCommand> const commands(m_Draws.size(), VkDrawIndexedIndirectCommand{});
+		vector<uint32_t> counts(m_Batches.size(), 0);
+		frameData.commands = make_unique<Buffer>(m_PhysicalDevice, m_Device, m_StagingRing, commands.data(), commands.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+		frameData.counts = make_unique<Buffer>(m_PhysicalDevice, m_Device, m_StagingRing, counts.data(), counts.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+		frameData.readback = make_unique<Buffer>(m_PhysicalDevice, m_Device, counts.data(), counts.size(), VK_BUFFER_USAGE_TRANSFER_DST_BIT, false);
+		//uploads are flushed by drawFrame before submission of frame which culls into them
+
+		frameData.cullDescriptorSet = make_unique<DescriptorSet>(m_CullDescriptorSetLayout);
+		frameData.cullDescriptorSet->createDescriptorSet();
+		frameData.cullDescriptorSet->setDynamicBuffer("cullParams", m_UniformRing.getBuffer(), sizeof(CullParamsUBO));
+		frameData.cullDescriptorSet->setStorage("meshes", *frameData.meshes);
+		frameData.cullDescriptorSet->setStorage("draws", *frameData.draws);
+		frameData.cullDescriptorSet->setStorage("batchFirstCommands", *frameData.batchFirstCommands);
+		frameData.cullDescriptorSet->setStorage("commands", *frameData.commands);
+		frameData.cullDescriptorSet->setStorage("counts", *frameData.counts);
+		frameData.cullDescriptorSet->setSampler("hiZ", m_HiZPyramid.getView(), m_HiZPyramid.getSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		frameData.cullDescriptorSet->update();
+
+		frameData.drawDescriptorSet = make_unique<DescriptorSet>(m_DrawDescriptorSetLayout);
+		frameData.drawDescriptorSet->createDescriptorSet();
+		frameData.drawDescriptorSet->setStorage("draws", *frameData.draws);
+		frameData.drawDescriptorSet->update();
+	}
+
+	void GpuDrivenRenderer::writeCullParams(CullParamsUBO& params, glm::mat4 const& cameraMatrix) const
+	{
+		FrustumCuller::Frustum const frustum = FrustumCuller::extractPlanes(m_Projection * glm::inverse(cameraMatrix));
+		for (size_t i = 0; i < frustum.size(); ++i) params.frustumPlanes[i] = frustum[i];
+
+		VkExtent2D const hiZExtent = m_HiZPyramid.getExtent();
+
+		params.hiZViewProj = m_CullHiZViewProjection;
+		params.cameraPos = cameraMatrix[3];
+		params.hiZSize = glm::vec2(static_cast<float>(hiZExtent.width), static_cast<float>(hiZExtent.height));
+		params.lodErrorScale = glm::abs(m_Projection[1][1]) * 0.5f * m_ViewportHeight;
+		params.lodPixelThreshold = m_LodPixelThreshold;
+		params.drawCnt = static_cast<uint32_t>(m_Draws.size());
+		params.hiZLevelCnt = m_CullHiZLevelCnt;
+		params.compact = m_DrawIndexedIndirectCount ? 1 : 0;
+	}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "VulkanHelper.h"
+#include "MaterialManager.h"
+#include "Model.h"
+#include "SceneObjectManager.h"
+#include "UniformRing.h"
+#include "GpuProfiler.h"
+#include "HiZPyramid.h"
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+//camera dependent, rewritten by latch right before frame is submitted
+struct CullParamsUBO
+{
+	alignas(16) glm::vec4 frustumPlanes[6];
+	alignas(16) glm::mat4 hiZViewProj; //camera which rendered depth of Hi-Z pyramid (previous frame)
+	alignas(16) glm::vec4 cameraPos;
+	alignas(8) glm::vec2 hiZSize; //level 0
+	alignas(4) float lodErrorScale; //pixels per object space unit at distance 1
+	alignas(4) float lodPixelThreshold;
+	alignas(4) uint32_t drawCnt;
+	alignas(4) uint32_t hiZLevelCnt; //0 - Hi-Z test is disabled
+	alignas(4) uint32_t compact; //commands are compacted for vkCmdDrawIndexedIndirectCountKHR
+};
+
+//G-buffer geometry culled and drawn by GPU. build() uploads draws (object x mesh) grouped into batches of equal material and
+//geometry buffers, cull() dispatches compute which tests every draw against camera frustum and Hi-Z pyramid of previous frame,
+//selects LOD and appends VkDrawIndexedIndirectCommand into command range of draw's batch. draw() issues one indirect draw per
+//batch, so CPU cost of frame depends on batch count only. Without VK_KHR_draw_indirect_count commands are not compacted, culled
+//draws get instanceCount 0 and whole command range of batch is drawn.
+class GpuDrivenRenderer
+{
+public:
+	//drawIndirectCount - VK_KHR_draw_indirect_count is enabled on device (VulcanInstance::m_DrawIndirectCount)
+	GpuDrivenRenderer(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing, UniformRing& uniformRing, GpuProfiler& gpuProfiler, HiZPyramid& hiZPyramid, uint32_t frameCnt,
+		bool drawIndirectCount, VkRenderPass gBufferRenderPass, VkExtent2D extent, shared_ptr<DescriptorSetLayout> materialDescriptorSetLayout, shared_ptr<DescriptorSetLayout> sceneDescriptorSetLayout);
+	~GpuDrivenRenderer();
+	GpuDrivenRenderer(GpuDrivenRenderer const&) = delete;
+	GpuDrivenRenderer& operator=(GpuDrivenRenderer const&) = delete;
+
+	//needs drawIndirectFirstInstance (draw index is passed as instance index) and multiDrawIndirect, vertex format FULL and compiled shaders
+	static bool isSupported(VkPhysicalDevice physicalDevice);
+
+	//has to be called again when objects or their matrices change
+	void build(SceneObjectManager& sceneObjectManager);
+
+	//after ModelManager::defragment moved geometry ranges, patches entries of moved meshes, draws are regrouped only
+	//when draws of one batch ended up in different pool blocks
+	void relocate();
+
+	//outside of render pass before draw, frame is frame in flight being recorded
+	void cull(VkCommandBuffer commandBuffer, uint32_t frame, glm::mat4 const& projection, glm::mat4 const& cameraMatrix, float viewportHeight, float lodPixelThreshold);
+
+	//rewrites culling params pushed since last latch with current camera, called right before frame is submitted
+	void latch(glm::mat4 const& cameraMatrix);
+
+	//inside G-buffer render pass, scene UBO is bound as set 1
+	void draw(VkCommandBuffer commandBuffer, uint32_t frame, VkDescriptorSet sceneDescriptorSet, uint32_t sceneOffset) const;
+
+	void printStatistics() const;
+
+	static const uint32_t MAX_LOD_CNT = 4;
+	static const uint32_t GROUP_SIZE = 64; //local_size_x of cullDraws.comp
+
+private:
+	//std430 layouts of cullDraws.comp
+	struct GpuMesh
+	{
+		glm::vec4 boundingSphere; //object space
+		glm::vec4 halfSize; //of AABB centered at sphere center
+		uint32_t lodFirstIndex[MAX_LOD_CNT]; //absolute in index buffer
+		uint32_t lodIndexCount[MAX_LOD_CNT];
+		float lodError[MAX_LOD_CNT];
+		int32_t vertexOffset;
+		uint32_t lodCnt;
+		uint32_t padding[2];
+	};
+
+	struct GpuDraw
+	{
+		glm::mat4 model; //also read by vertex shader through gl_InstanceIndex
+		uint32_t mesh;
+		uint32_t batch;
+		float scale; //largest axis scale of model
+		uint32_t padding;
+	};
+
+	//draws sharing material and geometry buffers, their commands are consecutive
+	struct Batch
+	{
+		VkDescriptorSet material;
+		VkBuffer vertexBuffer;
+		VkBuffer indexBuffer;
+		VkIndexType indexType;
+		uint32_t firstCommand;
+		uint32_t commandCnt;
+	};
+
+	//buffers of frame in flight, scene data is copied again when frame slot is reused after build
+	struct FrameData
+	{
+		uint64_t version = 0;
+		uint64_t meshVersion = 0;
+		unique_ptr<Buffer> meshes;
+		unique_ptr<Buffer> draws;
+		unique_ptr<Buffer> batchFirstCommands;
+		unique_ptr<Buffer> commands; //device local, written by culling
+		unique_ptr<Buffer> counts; //visible draws per batch
+		unique_ptr<Buffer> readback; //counts copied for statistics, read when slot is reused
+		bool readbackPending = false;
+		unique_ptr<DescriptorSet> cullDescriptorSet;
+		unique_ptr<DescriptorSet> drawDescriptorSet;
+	};
+
+	void createCullPipeline();
+	void createDrawPipeline(VkRenderPass gBufferRenderPass, VkExtent2D extent, shared_ptr<DescriptorSetLayout> const& materialDescriptorSetLayout, shared_ptr<DescriptorSetLayout> const& sceneDescriptorSetLayout);
+	void createBatches(vector<GpuDraw> draws, vector<VkDescriptorSet> const& materials);
+	void updateFrameData(FrameData& frameData);
+	static void writeGeometryRanges(GpuMesh& gpuMesh, MeshData const& mesh);
+	void writeCullParams(CullParamsUBO& params, glm::mat4 const& cameraMatrix) const;
+
+	VkPhysicalDevice m_PhysicalDevice;
+	VkDevice m_Device;
+	StagingRing& m_StagingRing;
+	UniformRing& m_UniformRing;
+	GpuProfiler& m_GpuProfiler;
+	HiZPyramid& m_HiZPyramid;
+	uint32_t m_CullScope;
+
+	PFN_vkCmdDrawIndexedIndirectCountKHR m_DrawIndexedIndirectCount = nullptr; //null when VK_KHR_draw_indirect_count is not enabled
+
+	shared_ptr<DescriptorSetLayout> m_CullDescriptorSetLayout;
+	VkPipelineLayout m_CullPipelineLayout;
+	VkPipeline m_CullPipeline;
+
+	shared_ptr<DescriptorSetLayout> m_DrawDescriptorSetLayout;
+	VkPipelineLayout m_DrawPipelineLayout;
+	VkPipeline m_DrawPipeline;
+
+	//scene data of last build
+	vector<GpuMesh> m_Meshes;
+	vector<MeshData const*> m_MeshSources; //[mesh], ranges are read again by relocate
+	vector<GpuDraw> m_Draws;
+	vector<Batch> m_Batches;
+	vector<uint32_t> m_BatchFirstCommands;
+	uint64_t m_Version = 0; //draws and batches
+	uint64_t m_MeshVersion = 0; //geometry ranges of meshes
+
+	vector<FrameData> m_Frames;
+
+	//camera of culling params recorded since last latch
+	glm::mat4 m_Projection = glm::mat4(1.0f);
+	float m_ViewportHeight = 0.0f;
+	float m_LodPixelThreshold = 0.0f;
+	glm::mat4 m_CullHiZViewProjection = glm::mat4(1.0f); //camera of Hi-Z pyramid read by culling being recorded
+	glm::mat4 m_BuildHiZViewProjection = glm::mat4(1.0f); //camera of frame being recorded, its pyramid is read by next frame
+	uint32_t m_CullHiZLevelCnt = 0; //0 until pyramid read by culling being recorded was built
+	vector<CullParamsUBO*> m_LatchedParams;
+
+	uint64_t m_CulledFrameCnt = 0; //frames with statistics read back
+	uint64_t m_VisibleDrawSum = 0;
+};
@@ -0,0 +1,149 @@
+
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "VulkanHelper.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <iostream>
+
+using namespace std;
+
+
+	GpuProfiler::GpuProfiler(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue queue, uint32_t queueFamilyIndex) : m_Device(device)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		uint32_t queueFamilyCnt = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCnt, nullptr);
+		vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCnt);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCnt, &queueFamilies[0]);
+
+		uint32_t const validBits = queueFamilies[queueFamilyIndex].timestampValidBits;
+		m_Supported = validBits != 0 && properties.limits.timestampPeriod > 0.0f;
+		if (!m_Supported) return;
+
+		m_TimestampPeriod = properties.limits.timestampPeriod;
+		m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+		VkQueryPoolCreateInfo queryPoolInfo = {};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = FRAME_CNT * MAX_SCOPES * 2;
+
+		auto res = vkCreateQueryPool(m_Device, &queryPoolInfo, nullptr, &m_QueryPool);
+		assert(res == VK_SUCCESS);
+
+		//only queries written by frame are read, reset keeps validation quiet about queries never used
+		VkCommandBuffer commandBuffer = VulkanHelpers::beginSingleTimeCommands(m_Device, commandPool);
+		vkCmdResetQueryPool(commandBuffer, m_QueryPool, 0, FRAME_CNT * MAX_SCOPES * 2);
+		VulkanHelpers::endSingleTimeCommands(m_Device, commandPool, queue, commandBuffer);
+	}
+
+	GpuProfiler::~GpuProfiler()
+	{
+		if (m_QueryPool != VK_NULL_HANDLE) vkDestroyQueryPool(m_Device, m_QueryPool, nullptr);
+	}
+
+	bool GpuProfiler::isSupported() const
+	{
+		return m_Supported;
+	}
+
+	uint32_t GpuProfiler::createScope(string const& name)
+	{
+		assert(m_Scopes.size() < MAX_SCOPES);
+
+		m_Scopes.push_back(Scope());
+		m_Scopes.back().name = name;
+		m_Scopes.back().traceName = CpuProfiler::get().intern("GPU " + name + " (ms)");
+		for (auto& written : m_Written) written.push_back(false);
+
+		return static_cast<uint32_t>(m_Scopes.size() - 1);
+	}
+
+	void GpuProfiler::begin(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (!m_Supported) return;
+
+		uint32_t const query = getQuery(m_Frame, scope);
+		vkCmdResetQueryPool(commandBuffer, m_QueryPool, query, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, query);
+		m_Written[m_Frame][scope] = true;
+	}
+
+	void GpuProfiler::end(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (!m_Supported) return;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, getQuery(m_Frame, scope) + 1);
+	}
+
+	void GpuProfiler::beginFrame(uint32_t frame)
+	{
+		assert(frame < FRAME_CNT);
+		m_Frame = frame;
+
+		if (!m_Supported || m_Scopes.empty()) return;
+
+		//begin, availability, end, availability per scope; frame which wrote them is finished, unwritten queries hold
+		//reset state or results of older frame and are skipped
+		vector<uint64_t> results(m_Scopes.size() * 4);
+		auto res = vkGetQueryPoolResults(m_Device, m_QueryPool, getQuery(frame, 0), static_cast<uint32_t>(m_Scopes.size() * 2), results.size() * sizeof(uint64_t), &results[0], 2 * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		assert(res == VK_SUCCESS || res == VK_NOT_READY);
+
+		for (size_t i = 0; i < m_Scopes.size(); ++i)
+		{
+			Scope& scope = m_Scopes[i];
+
+			if (!m_Written[frame][i]) continue;
+			m_Written[frame][i] = false;
+
+			uint64_t const* query = &results[i * 4];
+			if (query[1] == 0 || query[3] == 0) continue;
+
+			uint64_t const beginTime = query[0] & m_TimestampMask;
+			uint64_t const endTime = query[2] & m_TimestampMask;
+
+			double const ms = ((endTime - beginTime) & m_TimestampMask) * m_TimestampPeriod / 1000000.0;
+
+			uint32_t const sampleIdx = scope.sampleCnt % SAMPLE_CNT;
+			if (scope.sampleCnt >= SAMPLE_CNT) scope.sum -= scope.samples[sampleIdx];
+			scope.samples[sampleIdx] = ms;
+			scope.sum += ms;
+			++scope.sampleCnt;
+
+			//placed at read time in CPU trace, frames in flight later than GPU executed it
+			PROFILE_COUNTER(scope.traceName, ms);
+		}
+	}
+
+	vector<GpuProfiler::Timing> GpuProfiler::getTimings() const
+	{
+		vector<Timing> timings;
+
+		for (auto const& scope : m_Scopes)
+		{
+			if (scope.sampleCnt == 0) continue;
+
+			uint32_t const cnt = min(scope.sampleCnt, SAMPLE_CNT);
+			timings.push_back({ scope.name, scope.sum / cnt, scope.samples[(scope.sampleCnt - 1) % SAMPLE_CNT] });
+		}
+
+		return timings;
+	}
+
+	void GpuProfiler::printStatistics() const
+	{
+		if (!m_Supported)
+		{
+			cout << "GPU timestamps are not supported by graphics queue family" << endl;
+			return;
+		}
+
+		cout << "GPU time (average of last " << SAMPLE_CNT << " samples):" << endl;
+		for (auto const& timing : getTimings())
+			cout << "  " << timing.name << ": " << timing.averageMs << " ms" << endl;
+	}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//GPU time of named scopes measured by timestamp queries. Every frame in flight slot has own pair of queries per scope which is
+//reset in command buffer right before it is written, scopes work on any queue of timestamp capable family. Command buffers
+//have to be recorded in frame which submits them. Queries of slot are read when slot is reused, after its fence was waited,
+//so begin and end always come from the same execution. Without timestamp support scopes record nothing.
+class GpuProfiler
+{
+public:
+	struct Timing
+	{
+		string name;
+		double averageMs; //over last SAMPLE_CNT samples
+		double lastMs;
+	};
+
+	GpuProfiler(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue queue, uint32_t queueFamilyIndex);
+	~GpuProfiler();
+	GpuProfiler(GpuProfiler const&) = delete;
+	GpuProfiler& operator=(GpuProfiler const&) = delete;
+
+	bool isSupported() const;
+
+	//scope is measured at most once per frame, created at setup time only
+	uint32_t createScope(string const& name);
+
+	//outside of render pass, reset of queries is not allowed inside
+	void begin(VkCommandBuffer commandBuffer, uint32_t scope);
+	void end(VkCommandBuffer commandBuffer, uint32_t scope);
+
+	//reads scopes written by finished frame which used this slot, queries of slot are written by following begin / end,
+	//called once per frame by VulcanInstance::drawFrame after fence of frame was waited
+	void beginFrame(uint32_t frame);
+
+	vector<Timing> getTimings() const;
+	void printStatistics() const;
+
+	static const uint32_t MAX_SCOPES = 64;
+	static const uint32_t SAMPLE_CNT = 64;
+	static const uint32_t FRAME_CNT = 3; //one query range per frame in flight, VulcanInstance::MAX_FRAMES_IN_FLIGHT
+
+private:
+	struct Scope
+	{
+		string name;
+		char const* traceName; //counter in CPU trace
+		array<double, SAMPLE_CNT> samples; //ms, ring
+		uint32_t sampleCnt = 0;
+		double sum = 0.0;
+	};
+
+	uint32_t getQuery(uint32_t frame, uint32_t scope) const
+	{
+		return (frame * MAX_SCOPES + scope) * 2;
+	}
+
+	VkDevice m_Device;
+	VkQueryPool m_QueryPool = VK_NULL_HANDLE;
+	bool m_Supported = false;
+	double m_TimestampPeriod = 0.0; //ns per tick
+	uint64_t m_TimestampMask = 0;
+
+	vector<Scope> m_Scopes;
+	uint32_t m_Frame = 0; //slot of frame being recorded
+	array<vector<bool>, FRAME_CNT> m_Written; //[frame][scope], scopes recorded by last frame of slot
+};
+
+//begin / end of profiler scope bound to C++ scope
+class GpuScope
+{
+public:
+	GpuScope(GpuProfiler& profiler, VkCommandBuffer commandBuffer, uint32_t scope) : m_Profiler(profiler), m_CommandBuffer(commandBuffer), m_Scope(scope)
+	{
+		m_Profiler.begin(m_CommandBuffer, m_Scope);
+	}
+
+	~GpuScope()
+	{
+		m_Profiler.end(m_CommandBuffer, m_Scope);
+	}
+
+	GpuScope(GpuScope const&) = delete;
+	GpuScope& operator=(GpuScope const&) = delete;
+
+private:
+	GpuProfiler& m_Profiler;
+	VkCommandBuffer m_CommandBuffer;
+	uint32_t m_Scope;
+};
@@ -0,0 +1,203 @@
+
+#include "HiZPyramid.h"
+
+#include <algorithm>
+#include <assert.h>
+
+using namespace std;
+
+
+	HiZPyramid::HiZPyramid(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue queue, VkExtent2D depthExtent) : m_Device(device), m_Sampler(device)
+	{
+		m_Extent = { max(depthExtent.width / 2, 1u), max(depthExtent.height / 2, 1u) };
+
+		for (VkExtent2D extent = m_Extent; ; extent = { max(extent.width / 2, 1u), max(extent.height / 2, 1u) })
+		{
+			m_LevelExtents.push_back(extent);
+			if (extent.width == 1 && extent.height == 1) break;
+		}
+		m_LevelCnt = static_cast<uint32_t>(m_LevelExtents.size());
+
+		//IMAGE
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = { m_Extent.width, m_Extent.height, 1 };
+		imageInfo.mipLevels = m_LevelCnt;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = FORMAT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		auto res = vkCreateImage(m_Device, &imageInfo, nullptr, &m_Image);
+		assert(res == VK_SUCCESS);
+
+		m_Memory = MemoryAllocator::get(m_Device).allocateImage(m_Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+
+		auto createView = [this](uint32_t firstLevel, uint32_t levelCnt)
+		{
+			VkImageViewCreateInfo viewInfo = {};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.image = m_Image;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = FORMAT;
+			viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, firstLevel, levelCnt, 0, 1 };
+
+			VkImageView view;
+			auto res = vkCreateImageView(m_Device, &viewInfo, nullptr, &view);
+			assert(res == VK_SUCCESS);
+
+			return view;
+		};
+
+		m_View = createView(0, m_LevelCnt);
+		for (uint32_t level = 0; level < m_LevelCnt; ++level) m_LevelViews.push_back(createView(level, 1));
+
+		//culling reads pyramid before first build, it has to be in its read layout already
+		VkCommandBuffer commandBuffer = VulkanHelpers::beginSingleTimeCommands(m_Device, commandPool);
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_Image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, m_LevelCnt, 0, 1 };
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		VulkanHelpers::endSingleTimeCommands(m_Device, commandPool, queue, commandBuffer);
+
+		//RENDER PASS, previous content of level is never loaded
+		VulkanHelpers::createRenderPass(m_RenderPass, m_Device, FORMAT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ATTACHMENT_LOAD_OP_DONT_CARE, 1, false, VK_IMAGE_LAYOUT_UNDEFINED);
+
+		for (uint32_t level = 0; level < m_LevelCnt; ++level)
+		{
+			vector<VkImageView> attachments = { m_LevelViews[level] };
+			VkFramebuffer framebuffer;
+			VulkanHelpers::createFramebuffer(framebuffer, m_RenderPass, attachments, m_Device, m_LevelExtents[level]);
+			m_Framebuffers.push_back(framebuffer);
+		}
+
+		//DESCRIPTOR SETS
+		m_DescriptorSetLayout = make_shared<DescriptorSetLayout>(m_Device);
+		m_DescriptorSetLayout->addDescriptor("srcDepth", 0, VK_SHADER_STAGE_FRAGMENT_BIT, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		m_DescriptorSetLayout->createDescriptorSetLayout();
+
+		m_DescriptorSets.reserve(m_LevelCnt);
+		for (uint32_t level = 0; level < m_LevelCnt; ++level)
+		{
+			m_DescriptorSets.emplace_back(m_DescriptorSetLayout);
+			m_DescriptorSets.back().createDescriptorSet();
+
+			if (level == 0) continue; //depth is set by bindDepth
+
+			m_DescriptorSets.back().setSampler("srcDepth", m_LevelViews[level - 1], m_Sampler.m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			m_DescriptorSets.back().update();
+		}
+
+		//GRAPHIC PIPELINES, full screen quad of deferred 2nd pass
+		ShaderSet shaderData;
+		shaderData.vertexInputBindingDescription = {};
+		shaderData.vertexShaderPath = string("./../Shaders/defferedShader2ndPassVert.spv");
+		shaderData.fragmentShaderPath = string("./../Shaders/hiZFrag.spv");
+		shaderData.descriptorSetLayout.push_back(m_DescriptorSetLayout->getLayout());
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		for (uint32_t level = 0; level < m_LevelCnt; ++level)
+		{
+			VkPipeline pipeline;
+			VulkanHelpers::createGraphicsPipeline(m_Device, m_RenderPass, 1, m_LevelExtents[level], shaderData, false, inputAssembly, m_PipelineLayout, pipeline);
+			m_Pipelines.push_back(pipeline);
+		}
+	}
+
+	HiZPyramid::~HiZPyramid()
+	{
+		for (auto framebuffer : m_Framebuffers) vkDestroyFramebuffer(m_Device, framebuffer, nullptr);
+		vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
+
+		for (auto view : m_LevelViews) vkDestroyImageView(m_Device, view, nullptr);
+		vkDestroyImageView(m_Device, m_View, nullptr);
+		vkDestroyImage(m_Device, m_Image, nullptr);
+		MemoryAllocator::get(m_Device).free(m_Memory);
+	}
+
+	void HiZPyramid::bindDepth(VkImageView depthView)
+	{
+		m_DescriptorSets[0].setSampler("srcDepth", depthView, m_Sampler.m_Sampler, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+		m_DescriptorSets[0].update();
+	}
+
+	void HiZPyramid::build(VkCommandBuffer commandBuffer)
+	{
+		//culling of this frame has read previous pyramid, levels are discarded by render passes
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+		for (uint32_t level = 0; level < m_LevelCnt; ++level)
+		{
+			if (level > 0)
+			{
+				//previous level is written
+				VkMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+				barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+			}
+
+			VkRenderPassBeginInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = m_RenderPass;
+			renderPassInfo.framebuffer = m_Framebuffers[level];
+			renderPassInfo.renderArea.offset = { 0, 0 };
+			renderPassInfo.renderArea.extent = m_LevelExtents[level];
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+			VkDescriptorSet descriptorSet = m_DescriptorSets[level].getDescriptorSet();
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines[level]);
+
+			//quad
+			vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+
+			vkCmdEndRenderPass(commandBuffer);
+		}
+
+		m_Built = true;
+	}
+
+	bool HiZPyramid::isBuilt() const
+	{
+		return m_Built;
+	}
+
+	VkImageView HiZPyramid::getView() const
+	{
+		return m_View;
+	}
+
+	VkSampler HiZPyramid::getSampler() const
+	{
+		return m_Sampler.m_Sampler;
+	}
+
+	VkExtent2D HiZPyramid::getExtent() const
+	{
+		return m_Extent;
+	}
+
+	uint32_t HiZPyramid::getLevelCnt() const
+	{
+		return m_LevelCnt;
+	}
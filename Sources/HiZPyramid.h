@@ -0,0 +1,58 @@
+#pragma once
+
+#include "VulkanHelper.h"
+#include "MaterialManager.h"
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+//Mip chain of farthest depth of G-buffer depth, level 0 has half of depth resolution. Built every frame after G-buffer pass,
+//occlusion culling of next frame reads it. Image lives outside of render graph because its content is used in next frame,
+//every level is rendered by own render pass sampling previous level.
+class HiZPyramid
+{
+public:
+	HiZPyramid(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue queue, VkExtent2D depthExtent);
+	~HiZPyramid();
+	HiZPyramid(HiZPyramid const&) = delete;
+	HiZPyramid& operator=(HiZPyramid const&) = delete;
+
+	//source depth image, sampled in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, set once render graph is compiled
+	void bindDepth(VkImageView depthView);
+
+	//outside of render pass, depth has to be readable by fragment shaders (render graph pass sampling it)
+	void build(VkCommandBuffer commandBuffer);
+
+	//false until first build was recorded, image content is undefined before
+	bool isBuilt() const;
+
+	VkImageView getView() const; //all levels, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL outside of build
+	VkSampler getSampler() const;
+	VkExtent2D getExtent() const; //level 0
+	uint32_t getLevelCnt() const;
+
+	static const VkFormat FORMAT = VK_FORMAT_R32_SFLOAT;
+
+private:
+	VkDevice m_Device;
+	VkExtent2D m_Extent;
+	uint32_t m_LevelCnt;
+	bool m_Built = false;
+
+	VkImage m_Image;
+	MemoryAllocation m_Memory;
+	VkImageView m_View;
+	vector<VkImageView> m_LevelViews;
+	vector<VkFramebuffer> m_Framebuffers;
+	vector<VkExtent2D> m_LevelExtents;
+
+	Sampler m_Sampler; //texelFetch only, filtering is not used
+	VkRenderPass m_RenderPass;
+	shared_ptr<DescriptorSetLayout> m_DescriptorSetLayout;
+	vector<DescriptorSet> m_DescriptorSets; //[level] samples level - 1, level 0 samples depth
+	VkPipelineLayout m_PipelineLayout;
+	vector<VkPipeline> m_Pipelines; //per level, viewport is static
+};
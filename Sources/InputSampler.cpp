@@ -0,0 +1,48 @@
+
+#include "InputSampler.h"
+
+using namespace std;
+
+
+	InputSampler::InputSampler(Window& window, function<void(Window&, Event const&)> handler) : m_Window(window), m_Handler(move(handler))
+	{
+		m_Window.setKeyCallback([this](Window&, int key, int scancode, int action, int mods)
+			{
+				Event event = { Event::Type::KEY, key, scancode, action, mods, 0.0, 0.0 };
+				push(event);
+			});
+
+		m_Window.setMouseButtonCallback([this](Window&, int button, int action, int mods)
+			{
+				Event event = { Event::Type::MOUSE_BUTTON, button, 0, action, mods, 0.0, 0.0 };
+				push(event);
+			});
+
+		m_Window.setMouseMoveCallback([this](Window&, double x, double y)
+			{
+				Event event = { Event::Type::MOUSE_MOVE, 0, 0, 0, 0, x, y };
+				push(event);
+			});
+	}
+
+	chrono::steady_clock::time_point InputSampler::sample()
+	{
+		m_Window.pollEvents();
+
+		if (m_Events.empty()) return chrono::steady_clock::time_point();
+
+		chrono::steady_clock::time_point const oldest = m_Events.front().time;
+
+		//handler can cause new events (glfwSetCursorPos), they are passed by next sample
+		vector<Event> events;
+		events.swap(m_Events);
+		for (auto const& event : events) m_Handler(m_Window, event);
+
+		return oldest;
+	}
+
+	void InputSampler::push(Event& event)
+	{
+		event.time = chrono::steady_clock::now();
+		m_Events.push_back(event);
+	}
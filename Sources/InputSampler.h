@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Window.h"
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+//Window input events stamped with time of arrival and queued, application state sees them only when they are sampled.
+//GLFW delivers events from pollEvents on main thread only, so the queue between window callbacks and sample() is the input
+//path; sampling again right before submission (late latching) lets frame use input which arrived while it was recorded.
+class InputSampler
+{
+public:
+	struct Event
+	{
+		enum class Type
+		{
+			KEY,
+			MOUSE_BUTTON,
+			MOUSE_MOVE,
+		};
+
+		Type type;
+		int key; //key or mouse button
+		int scancode;
+		int action;
+		int mods;
+		double x; //cursor position
+		double y;
+		chrono::steady_clock::time_point time; //arrival, when pollEvents received it
+	};
+
+	//replaces key, mouse button and mouse move callbacks of window
+	InputSampler(Window& window, function<void(Window&, Event const&)> handler);
+	InputSampler(InputSampler const&) = delete;
+	InputSampler& operator=(InputSampler const&) = delete;
+
+	//polls window and passes queued events to handler in order
+	//returns arrival of oldest passed event, time_point() when there was none
+	chrono::steady_clock::time_point sample();
+
+private:
+	void push(Event& event);
+
+	Window& m_Window;
+	function<void(Window&, Event const&)> m_Handler;
+	vector<Event> m_Events;
+};
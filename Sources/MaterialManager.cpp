@@ -1,6 +1,9 @@
 #pragma once
 
 #include "MaterialManager.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 using namespace std;
@@ -65,7 +68,7 @@ using namespace std;
 		if (m_Device == VK_NULL_HANDLE) return;
 
 		vkDestroyBuffer(m_Device, buffer, nullptr);
-		vkFreeMemory(m_Device, bufferMemory, nullptr);
+		MemoryAllocator::get(m_Device).free(bufferMemory);
 		m_Device = VK_NULL_HANDLE;
 	}
 
@@ -77,6 +80,12 @@ using namespace std;
 
 	DescriptorSetLayout::~DescriptorSetLayout()
 	{
+		if (m_UpdateTemplate != VK_NULL_HANDLE)
+		{
+			m_DestroyDescriptorUpdateTemplate(m_Device, m_UpdateTemplate, nullptr);
+			m_UpdateTemplate = VK_NULL_HANDLE;
+		}
+
 		if (m_DescriptorSetLayout != VK_NULL_HANDLE)
 		{
 			vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, nullptr);
@@ -115,17 +124,69 @@ using namespace std;
 				});
 		}
 
+		//binding ids are dense, binding is index
+		m_Bindings.resize(bindings.size());
+		for (auto const& binding : bindings) m_Bindings[binding.binding] = binding;
+
+		m_DescriptorInfoCnt = 0;
+		for (auto const& binding : m_Bindings)
+		{
+			m_DescriptorInfoOffsets.push_back(m_DescriptorInfoCnt);
+			m_DescriptorInfoCnt += binding.descriptorCount;
+		}
+
 		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
 		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 
-		if (!bindings.empty())
+		if (!m_Bindings.empty())
 		{
-			layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-			layoutInfo.pBindings = &bindings[0];
+			layoutInfo.bindingCount = static_cast<uint32_t>(m_Bindings.size());
+			layoutInfo.pBindings = &m_Bindings[0];
 		}
 
 		auto res = vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_DescriptorSetLayout);
 		assert(res == VK_SUCCESS);
+
+		map<VkDescriptorType, uint32_t> descriptorTypeCnt;
+		for (auto const& binding : m_Bindings) descriptorTypeCnt[binding.descriptorType] += binding.descriptorCount;
+
+		m_PoolSizes.assign(begin(descriptorTypeCnt), end(descriptorTypeCnt));
+
+		createUpdateTemplate();
+	}
+
+	void DescriptorSetLayout::createUpdateTemplate()
+	{
+		//null when VK_KHR_descriptor_update_template is not enabled on device
+		auto createDescriptorUpdateTemplate = reinterpret_cast<PFN_vkCreateDescriptorUpdateTemplateKHR>(vkGetDeviceProcAddr(m_Device, "vkCreateDescriptorUpdateTemplateKHR"));
+		m_UpdateDescriptorSetWithTemplate = reinterpret_cast<PFN_vkUpdateDescriptorSetWithTemplateKHR>(vkGetDeviceProcAddr(m_Device, "vkUpdateDescriptorSetWithTemplateKHR"));
+		m_DestroyDescriptorUpdateTemplate = reinterpret_cast<PFN_vkDestroyDescriptorUpdateTemplateKHR>(vkGetDeviceProcAddr(m_Device, "vkDestroyDescriptorUpdateTemplateKHR"));
+
+		if (!createDescriptorUpdateTemplate || !m_UpdateDescriptorSetWithTemplate || !m_DestroyDescriptorUpdateTemplate || m_Bindings.empty()) return;
+
+		vector<VkDescriptorUpdateTemplateEntryKHR> entries;
+		for (uint32_t binding = 0; binding < m_Bindings.size(); ++binding)
+		{
+			VkDescriptorUpdateTemplateEntryKHR entry = {};
+			entry.dstBinding = binding;
+			entry.dstArrayElement = 0;
+			entry.descriptorCount = m_Bindings[binding].descriptorCount;
+			entry.descriptorType = m_Bindings[binding].descriptorType;
+			entry.offset = m_DescriptorInfoOffsets[binding] * sizeof(DescriptorInfo);
+			entry.stride = sizeof(DescriptorInfo);
+
+			entries.push_back(entry);
+		}
+
+		VkDescriptorUpdateTemplateCreateInfoKHR templateInfo = {};
+		templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+		templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+		templateInfo.pDescriptorUpdateEntries = &entries[0];
+		templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+		templateInfo.descriptorSetLayout = m_DescriptorSetLayout;
+
+		auto res = createDescriptorUpdateTemplate(m_Device, &templateInfo, nullptr, &m_UpdateTemplate);
+		assert(res == VK_SUCCESS);
 	}
 
 	VkDescriptorSetLayoutBinding const* DescriptorSetLayout::getDescriptor(string const& paramName) const
@@ -140,6 +201,39 @@ using namespace std;
 		return m_DescriptorSetLayoutBindingData.size();
 	}
 
+	uint32_t DescriptorSetLayout::getBinding(string const& paramName) const
+	{
+		auto desc = getDescriptor(paramName);
+		assert(desc != nullptr && "Unknown shader parameter!");
+
+		return desc->binding;
+	}
+
+	VkDescriptorSetLayoutBinding const& DescriptorSetLayout::getDescriptor(uint32_t binding) const
+	{
+		return m_Bindings.at(binding);
+	}
+
+	size_t DescriptorSetLayout::getDescriptorInfoCnt() const
+	{
+		return m_DescriptorInfoCnt;
+	}
+
+	size_t DescriptorSetLayout::getDescriptorInfoOffset(uint32_t binding) const
+	{
+		return m_DescriptorInfoOffsets[binding];
+	}
+
+	bool DescriptorSetLayout::hasUpdateTemplate() const
+	{
+		return m_UpdateTemplate != VK_NULL_HANDLE;
+	}
+
+	void DescriptorSetLayout::updateWithTemplate(VkDescriptorSet descriptorSet, DescriptorInfo const* descriptorInfo) const
+	{
+		m_UpdateDescriptorSetWithTemplate(m_Device, descriptorSet, m_UpdateTemplate, descriptorInfo);
+	}
+
 	
 	VkDevice DescriptorSetLayout::getDevice() const
 	{
@@ -151,6 +245,11 @@ using namespace std;
 		return m_DescriptorSetLayout;
 	}
 
+	DescriptorAllocator::PoolSizes const& DescriptorSetLayout::getPoolSizes() const
+	{
+		return m_PoolSizes;
+	}
+
 
 
 	DescriptorSet::DescriptorSet(shared_ptr<DescriptorSetLayout> descriptorSetLayout)
@@ -170,153 +269,155 @@ using namespace std;
 
 	DescriptorSet& DescriptorSet::operator=(DescriptorSet &&obj)
 	{
+		destroy();
 		*this = obj;
-		obj.m_DescriptorPool = VK_NULL_HANDLE;
+		obj.m_Allocation = DescriptorAllocation();
 
 		return *this;
 	}
 
-	void DescriptorSet::updateDescriptorSet(VkDescriptorSetLayoutBinding const & descSetLayoutBinding)
+	void DescriptorSet::createDescriptorSet()
 	{
-		VkWriteDescriptorSet newDescriptorSet = {};
-		newDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		newDescriptorSet.dstSet = m_DescriptorSet;
-		newDescriptorSet.dstBinding = descSetLayoutBinding.binding;
-		newDescriptorSet.dstArrayElement = 0;
-		newDescriptorSet.descriptorType = descSetLayoutBinding.descriptorType;
-		newDescriptorSet.descriptorCount = descSetLayoutBinding.descriptorCount;
-
-		auto descriptorImageInfoArray = get_if<vector<VkDescriptorImageInfo>>(&m_DescriptorInfo[descSetLayoutBinding.binding].second);
-		newDescriptorSet.pImageInfo = descriptorImageInfoArray ? &descriptorImageInfoArray->at(0) : nullptr;
-		newDescriptorSet.pBufferInfo = get_if<VkDescriptorBufferInfo>(&m_DescriptorInfo[descSetLayoutBinding.binding].second);
+		m_Allocation = DescriptorAllocator::get(m_DescriptorSetLayout->getDevice()).allocate(m_DescriptorSetLayout->getLayout(), m_DescriptorSetLayout->getPoolSizes());
+		m_DescriptorSet = m_Allocation.set;
 
-		vkUpdateDescriptorSets(m_DescriptorSetLayout->getDevice(), 1, &newDescriptorSet, 0, nullptr);
+		m_DescriptorInfo.assign(m_DescriptorSetLayout->getDescriptorInfoCnt(), DescriptorInfo{});
+		m_Written.assign(m_DescriptorSetLayout->getDescriptorCount(), false);
+		m_Dirty.assign(m_DescriptorSetLayout->getDescriptorCount(), false);
 	}
 
-
-	void DescriptorSet::createDescriptorSet()
+	DescriptorInfo* DescriptorSet::getDescriptorInfo(uint32_t binding, VkDescriptorType type)
 	{
-		unordered_multiset<VkDescriptorType> descriptorTypeCnt;
-
-		m_DescriptorSetLayout->enumerate([&descriptorTypeCnt](VkDescriptorSetLayoutBinding& layoutBinding)
-			{
-				for (int i = 0; i < layoutBinding.descriptorCount; ++i)
-				{
-					//insert  layoutBinding.descriptorCount- times (this is really stupid way how to do it, but i feel lazy to refactor it at this moment)
-					descriptorTypeCnt.insert(layoutBinding.descriptorType);
-				}
-				
-			});
-
-		vector< VkDescriptorPoolSize> poolSizes;
-		for (auto& descriptorType : descriptorTypeCnt)
-		{
-			VkDescriptorPoolSize descriptorPoolSize;
-			descriptorPoolSize.type = descriptorType;
-			descriptorPoolSize.descriptorCount = static_cast<uint32_t>(descriptorTypeCnt.count(descriptorType));
+		assert(m_DescriptorSetLayout->getDescriptor(binding).descriptorType == type);
 
-			poolSizes.push_back(descriptorPoolSize);
-		}
-
-		VkDescriptorPoolCreateInfo poolInfo = {};
-		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = 1;
+		m_Written[binding] = true;
+		m_Dirty[binding] = true;
 
-		VkDevice device = m_DescriptorSetLayout->getDevice();
+		return &m_DescriptorInfo[m_DescriptorSetLayout->getDescriptorInfoOffset(binding)];
+	}
 
-		auto res = vkCreateDescriptorPool(device, &poolInfo, nullptr, &m_DescriptorPool);
-		assert(res == VK_SUCCESS);
+	void DescriptorSet::update()
+	{
+		if (find(begin(m_Dirty), end(m_Dirty), true) == end(m_Dirty)) return;
 
-		VkDescriptorSetAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = m_DescriptorPool;
-		allocInfo.descriptorSetCount = 1;
+		PROFILE_FUNCTION();
 
-		auto layout = m_DescriptorSetLayout->getLayout();
-		allocInfo.pSetLayouts = &layout;
+		if (m_DescriptorSetLayout->hasUpdateTemplate() && find(begin(m_Written), end(m_Written), false) == end(m_Written))
+		{
+			m_DescriptorSetLayout->updateWithTemplate(m_DescriptorSet, &m_DescriptorInfo[0]);
+		}
+		else
+		{
+			vector<VkWriteDescriptorSet> writes;
 
-		res = vkAllocateDescriptorSets(device, &allocInfo, &m_DescriptorSet);
+			for (uint32_t binding = 0; binding < m_Dirty.size(); ++binding)
+			{
+				if (!m_Dirty[binding]) continue;
+
+				auto const& desc = m_DescriptorSetLayout->getDescriptor(binding);
+				auto const& descriptorInfo = m_DescriptorInfo[m_DescriptorSetLayout->getDescriptorInfoOffset(binding)];
+				bool const isImage = desc.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER || desc.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+
+				VkWriteDescriptorSet newDescriptorSet = {};
+				newDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				newDescriptorSet.dstSet = m_DescriptorSet;
+				newDescriptorSet.dstBinding = binding;
+				newDescriptorSet.dstArrayElement = 0;
+				newDescriptorSet.descriptorType = desc.descriptorType;
+				newDescriptorSet.descriptorCount = desc.descriptorCount;
+				newDescriptorSet.pImageInfo = isImage ? &descriptorInfo.image : nullptr;
+				newDescriptorSet.pBufferInfo = isImage ? nullptr : &descriptorInfo.buffer;
+
+				writes.push_back(newDescriptorSet);
+			}
+
+			vkUpdateDescriptorSets(m_DescriptorSetLayout->getDevice(), static_cast<uint32_t>(writes.size()), &writes[0], 0, nullptr);
+		}
 
-		assert(res == VK_SUCCESS);
+		m_Dirty.assign(m_Dirty.size(), false);
 	}
 
-	void DescriptorSet::setSamplerArray(string const& paramName, vector<VkImageView> const &imageViews, VkSampler sampler, VkImageLayout imageLayout)
+	void DescriptorSet::setSamplerArray(uint32_t binding, vector<VkImageView> const& imageViews, VkSampler sampler, VkImageLayout imageLayout)
 	{
-		auto desc = m_DescriptorSetLayout->getDescriptor(paramName);
-		assert(desc != nullptr && desc->descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		auto const descriptorCount = m_DescriptorSetLayout->getDescriptor(binding).descriptorCount;
+		assert(!imageViews.empty() && imageViews.size() <= descriptorCount);
 
-		vector<VkDescriptorImageInfo> imageInfos;
+		auto descriptorInfo = getDescriptorInfo(binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
-		for (auto imageView : imageViews)
+		//whole array is written, remaining elements repeat last image
+		for (uint32_t i = 0; i < descriptorCount; ++i)
 		{
-			VkDescriptorImageInfo imageInfo = {};
+			VkDescriptorImageInfo& imageInfo = descriptorInfo[i].image;
 			imageInfo.imageLayout = imageLayout;
-			imageInfo.imageView = imageView;
+			imageInfo.imageView = imageViews[min<size_t>(i, imageViews.size() - 1)];
 			imageInfo.sampler = sampler;
-
-
-			imageInfos.push_back(imageInfo);
 		}
-		
-		if (m_DescriptorInfo.size() <= desc->binding)  m_DescriptorInfo.resize(m_DescriptorSetLayout->getDescriptorCount());
-		m_DescriptorInfo[desc->binding] = make_pair(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageInfos);
-
-		updateDescriptorSet(*desc);
 	}
 
-	void DescriptorSet::setSampler(string const& paramName, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout)
+	void DescriptorSet::setSampler(uint32_t binding, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout)
 	{
-		setSamplerArray(paramName, { imageView }, sampler, imageLayout);
+		setSamplerArray(binding, { imageView }, sampler, imageLayout);
 	}
 
-	void DescriptorSet::setImageStorage(string const& paramName, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout)
+	void DescriptorSet::setImageStorage(uint32_t binding, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout)
 	{
-		auto desc = m_DescriptorSetLayout->getDescriptor(paramName);
-		assert(desc != nullptr && desc->descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
-
-		VkDescriptorImageInfo imageInfo = {};
+		VkDescriptorImageInfo& imageInfo = getDescriptorInfo(binding, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)->image;
 		imageInfo.imageLayout = imageLayout;
 		imageInfo.imageView = imageView;
 		imageInfo.sampler = sampler;
+	}
 
-		if (m_DescriptorInfo.size() <= desc->binding)  m_DescriptorInfo.resize(m_DescriptorSetLayout->getDescriptorCount());
-		m_DescriptorInfo[desc->binding] = make_pair(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, vector<VkDescriptorImageInfo>({ imageInfo }));
+	void DescriptorSet::setBufferInfo(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize range)
+	{
+		VkDescriptorBufferInfo& bufferInfo = getDescriptorInfo(binding, type)->buffer;
+		bufferInfo.buffer = buffer;
+		bufferInfo.offset = 0;
+		bufferInfo.range = range;
+	}
 
-		updateDescriptorSet(*desc);
+	void DescriptorSet::setBuffer(uint32_t binding, Buffer const& buffer)
+	{
+		setBufferInfo(binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, buffer.buffer, buffer.size);
 	}
 
-	void DescriptorSet::setBuffer(string const& paramName, Buffer const & buffer)
+	void DescriptorSet::setDynamicBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize range)
 	{
-		auto desc = m_DescriptorSetLayout->getDescriptor(paramName);
-		assert(desc != nullptr && desc->descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+		setBufferInfo(binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, buffer, range);
+	}
 
-		VkDescriptorBufferInfo bufferInfo = {};
-		bufferInfo.buffer = buffer.buffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = buffer.size;
+	void DescriptorSet::setStorage(uint32_t binding, Buffer const& buffer)
+	{
+		setBufferInfo(binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, buffer.buffer, buffer.size);
+	}
 
-		if (m_DescriptorInfo.size() <= desc->binding)  m_DescriptorInfo.resize(m_DescriptorSetLayout->getDescriptorCount());
-		m_DescriptorInfo[desc->binding] = make_pair(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, bufferInfo);
+	void DescriptorSet::setSamplerArray(string const& paramName, vector<VkImageView> const &imageViews, VkSampler sampler, VkImageLayout imageLayout)
+	{
+		setSamplerArray(m_DescriptorSetLayout->getBinding(paramName), imageViews, sampler, imageLayout);
+	}
 
-		updateDescriptorSet(*desc);
+	void DescriptorSet::setSampler(string const& paramName, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout)
+	{
+		setSampler(m_DescriptorSetLayout->getBinding(paramName), imageView, sampler, imageLayout);
 	}
 
-	void DescriptorSet::setStorage(string const& paramName, Buffer const& buffer)
+	void DescriptorSet::setImageStorage(string const& paramName, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout)
 	{
-		auto desc = m_DescriptorSetLayout->getDescriptor(paramName);
-		assert(desc != nullptr && desc->descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		setImageStorage(m_DescriptorSetLayout->getBinding(paramName), imageView, sampler, imageLayout);
+	}
 
-		VkDescriptorBufferInfo bufferInfo = {};
-		bufferInfo.buffer = buffer.buffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = buffer.size;
+	void DescriptorSet::setBuffer(string const& paramName, Buffer const & buffer)
+	{
+		setBuffer(m_DescriptorSetLayout->getBinding(paramName), buffer);
+	}
 
-		if (m_DescriptorInfo.size() <= desc->binding)  m_DescriptorInfo.resize(m_DescriptorSetLayout->getDescriptorCount());
-		m_DescriptorInfo[desc->binding] = make_pair(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, bufferInfo);
+	void DescriptorSet::setDynamicBuffer(string const& paramName, VkBuffer buffer, VkDeviceSize range)
+	{
+		setDynamicBuffer(m_DescriptorSetLayout->getBinding(paramName), buffer, range);
+	}
 
-		updateDescriptorSet(*desc);
+	void DescriptorSet::setStorage(string const& paramName, Buffer const& buffer)
+	{
+		setStorage(m_DescriptorSetLayout->getBinding(paramName), buffer);
 	}
 
 
@@ -332,15 +433,15 @@ using namespace std;
 
 	void DescriptorSet::destroy()
 	{
-		if (m_DescriptorPool != VK_NULL_HANDLE)
+		if (m_Allocation.pool != VK_NULL_HANDLE)
 		{
-			vkDestroyDescriptorPool(m_DescriptorSetLayout->getDevice(), m_DescriptorPool, nullptr);
-			m_DescriptorPool = VK_NULL_HANDLE;
+			DescriptorAllocator::get(m_DescriptorSetLayout->getDevice()).free(m_Allocation);
+			m_Allocation = DescriptorAllocation();
 		}
 	}
 
 
-	MaterialManager::MaterialManager(TextureManager& textureManager, VkDevice device, VkPhysicalDevice physicalDevice) :m_TextureManager(textureManager)
+	MaterialManager::MaterialManager(TextureManager& textureManager, StagingRing& stagingRing, VkDevice device, VkPhysicalDevice physicalDevice) :m_TextureManager(textureManager), m_StagingRing(stagingRing)
 	{
 		m_Device = device;
 		m_PhysicalDevice = physicalDevice;
@@ -355,6 +456,12 @@ using namespace std;
 		m_DecriptorSetLayout->addDescriptor("aoTex", 5, VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 		m_DecriptorSetLayout->createDescriptorSetLayout();
 
+		m_MaterialBufferBinding = m_DecriptorSetLayout->getBinding("materialBuffer");
+		m_DiffuseTexBinding = m_DecriptorSetLayout->getBinding("diffuseTex");
+		m_SpecularTexBinding = m_DecriptorSetLayout->getBinding("specularTex");
+		m_NormalTexBinding = m_DecriptorSetLayout->getBinding("normalTex");
+		m_SpecularHighlightTexBinding = m_DecriptorSetLayout->getBinding("specularHighlightTex");
+		m_AoTexBinding = m_DecriptorSetLayout->getBinding("aoTex");
 	}
 
 	shared_ptr<const MaterialDescription> MaterialManager::createMaterial(tinyobj::material_t const& material, const string& path)
@@ -392,17 +499,18 @@ using namespace std;
 
 			materialBuffer.shininess = material.shininess;
 
-			auto buffer = Buffer(m_PhysicalDevice, m_Device, &materialBuffer, 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+			auto buffer = Buffer(m_PhysicalDevice, m_Device, m_StagingRing, &materialBuffer, 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 			
 			DescriptorSet descriptorSet(m_DecriptorSetLayout);
 			descriptorSet.createDescriptorSet();
 
-			descriptorSet.setBuffer("materialBuffer",buffer);
-			descriptorSet.setSampler("diffuseTex", diffuseTexture->imageView, m_Sampler->m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-			descriptorSet.setSampler("specularTex", specularTexture->imageView, m_Sampler->m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-			descriptorSet.setSampler("normalTex",normalTexture->imageView, m_Sampler->m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-			descriptorSet.setSampler("specularHighlightTex", specularHighlightTexture->imageView, m_Sampler->m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-			descriptorSet.setSampler("aoTex", aoTexture->imageView, m_Sampler->m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			descriptorSet.setBuffer(m_MaterialBufferBinding, buffer);
+			descriptorSet.setSampler(m_DiffuseTexBinding, diffuseTexture->imageView, m_Sampler->m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			descriptorSet.setSampler(m_SpecularTexBinding, specularTexture->imageView, m_Sampler->m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			descriptorSet.setSampler(m_NormalTexBinding, normalTexture->imageView, m_Sampler->m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			descriptorSet.setSampler(m_SpecularHighlightTexBinding, specularHighlightTexture->imageView, m_Sampler->m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			descriptorSet.setSampler(m_AoTexBinding, aoTexture->imageView, m_Sampler->m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			descriptorSet.update();
 			
 
 			MaterialDescription* newMaterial = new MaterialDescription{ move(diffuseTexture), move(specularTexture), move(normalTexture), move(specularHighlightTexture), move(aoTexture), m_Sampler, move(descriptorSet), move(buffer) };
@@ -2,7 +2,11 @@
 
 
 #include "VulkanHelper.h"
+#include "StagingRing.h"
 #include "TextureManager.h"
+#include "DescriptorAllocator.h"
+#include <assert.h>
+#include <cstring>
 #include <vector>
 #include <array>
 #include <memory>
@@ -38,44 +42,87 @@ private:
 struct Buffer
 {
 	VkBuffer buffer;
-	VkDeviceMemory bufferMemory;
+	MemoryAllocation bufferMemory;
 	size_t size; //sizeof(T) * count
 	size_t count;
 
+	bool hostVisible;
+
 	VkDevice m_Device = VK_NULL_HANDLE;
 
-	template<typename T> explicit Buffer(VkPhysicalDevice physicalDevice, VkDevice device, T* bufferDataPtr,size_t  dataCnt, VkBufferUsageFlagBits usageBits)
+	//host visible and persistently mapped, for data updated by CPU every frame
+	//non coherent buffers use host cached memory (fast CPU reads), writes / reads are flushed / invalidated by write and read
+	template<typename T> explicit Buffer(VkPhysicalDevice physicalDevice, VkDevice device, T* bufferDataPtr,size_t  dataCnt, VkBufferUsageFlagBits usageBits, bool coherent = true)
+	{
+		m_Device = device;
+		size = sizeof(T) * dataCnt;
+		count = dataCnt;
+		hostVisible = true;
+		VkMemoryPropertyFlags const memoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | (coherent ? VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+		VulkanHelpers::createBuffer(buffer, bufferMemory, physicalDevice, device, bufferDataPtr, dataCnt, usageBits, memoryProperties);
+	}
+
+	//device local, data is uploaded through staging ring
+	template<typename T> explicit Buffer(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing, T const* bufferDataPtr, size_t dataCnt, VkBufferUsageFlags usageBits)
 	{
 		m_Device = device;
 		size = sizeof(T) * dataCnt;
 		count = dataCnt;
-		VulkanHelpers::createBuffer(buffer, bufferMemory, physicalDevice, device, bufferDataPtr, dataCnt, usageBits);
+		hostVisible = false;
+		VulkanHelpers::allocateBuffer(buffer, bufferMemory, physicalDevice, device, size, usageBits | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		stagingRing.copyToBuffer(buffer, 0, bufferDataPtr, size);
 	}
 
 	~Buffer();
 	Buffer& operator=(Buffer&& obj);
 	Buffer(Buffer&& obj);
 
+	//writes elements [first, first + cnt), plain memcpy into mapping, flush only for non coherent memory
+	template<typename T> void write(T const* bufferDataPtr, size_t first, size_t cnt)
+	{
+		assert(hostVisible && sizeof(T) * count == size && first + cnt <= count);
+		memcpy(static_cast<T*>(bufferMemory.mappedPtr) + first, bufferDataPtr, sizeof(T) * cnt);
+		flush(sizeof(T) * first, sizeof(T) * cnt);
+	}
+
+	template<typename T> void read(T* bufferDataPtr, size_t first, size_t cnt) const
+	{
+		assert(hostVisible && sizeof(T) * count == size && first + cnt <= count);
+		invalidate(sizeof(T) * first, sizeof(T) * cnt);
+		memcpy(bufferDataPtr, static_cast<T const*>(bufferMemory.mappedPtr) + first, sizeof(T) * cnt);
+	}
+
 	template<typename T> void updateBuffer(T* bufferDataPtr)
 	{
-		VulkanHelpers::copyData(bufferMemory, m_Device, bufferDataPtr, count);
+		write(bufferDataPtr, 0, count);
+	}
+
+	template<typename T> void updateBuffer(StagingRing& stagingRing, T const* bufferDataPtr)
+	{
+		stagingRing.copyToBuffer(buffer, 0, bufferDataPtr, size);
 	}
 	
 	template<typename T> void copyBuffer(T* bufferDataPtr) const
 	{
-		VulkanHelpers::readDataFromGPU(bufferMemory, m_Device, *bufferDataPtr, count);
+		read(bufferDataPtr, 0, count);
 	}
 
+	//persistent mapping, valid for lifetime of buffer, writes through it have to be followed by flush
 	void*  mapMemory() const
 	{
-		void* data;
-		vkMapMemory(m_Device, bufferMemory, 0, size, 0, &data);
-		return data;
+		assert(hostVisible);
+		return bufferMemory.mappedPtr;
 	}
 
-	void unmapMemory() const
+	//byte ranges, no-op for coherent memory
+	void flush(VkDeviceSize offset = 0, VkDeviceSize rangeSize = VK_WHOLE_SIZE) const
 	{
-		vkUnmapMemory(m_Device, bufferMemory);
+		MemoryAllocator::get(m_Device).flush(bufferMemory, offset, rangeSize);
+	}
+
+	void invalidate(VkDeviceSize offset = 0, VkDeviceSize rangeSize = VK_WHOLE_SIZE) const
+	{
+		MemoryAllocator::get(m_Device).invalidate(bufferMemory, offset, rangeSize);
 	}
 
 private:
@@ -91,6 +138,15 @@ struct ShaderParam
 	variant< VkDescriptorImageInfo, VkDescriptorBufferInfo> m_DescriptorInfo;
 };
 
+//one descriptor of update data, descriptors of all bindings are packed in one array consumed by update template
+union DescriptorInfo
+{
+	VkDescriptorImageInfo image;
+	VkDescriptorBufferInfo buffer;
+};
+
+static_assert(sizeof(VkDescriptorImageInfo) == sizeof(VkDescriptorBufferInfo), "DescriptorInfo array is passed as pImageInfo / pBufferInfo array");
+
 class DescriptorSetLayout
 {
 public:
@@ -106,6 +162,17 @@ public:
 	VkDescriptorSetLayoutBinding const* getDescriptor(string const& paramName) const;
 	size_t getDescriptorCount() const;
 
+	//binding of parameter, resolve it once and pass it to DescriptorSet setters instead of name
+	uint32_t getBinding(string const& paramName) const;
+	VkDescriptorSetLayoutBinding const& getDescriptor(uint32_t binding) const;
+
+	size_t getDescriptorInfoCnt() const; //descriptors of all bindings
+	size_t getDescriptorInfoOffset(uint32_t binding) const; //first DescriptorInfo of binding
+
+	//VK_KHR_descriptor_update_template is optional
+	bool hasUpdateTemplate() const;
+	void updateWithTemplate(VkDescriptorSet descriptorSet, DescriptorInfo const* descriptorInfo) const;
+
 	template< typename Func> void enumerate(Func func)
 	{
 		for (auto& it : m_DescriptorSetLayoutBindingData)
@@ -116,10 +183,22 @@ public:
 
 	VkDevice getDevice() const;
 	VkDescriptorSetLayout getLayout() const;
+	DescriptorAllocator::PoolSizes const& getPoolSizes() const; //descriptor counts of one set, key of shared pools
 private:
+	void createUpdateTemplate();
+
 	VkDevice m_Device = VK_NULL_HANDLE;
 	VkDescriptorSetLayout m_DescriptorSetLayout = VK_NULL_HANDLE;
 	unordered_map<string, VkDescriptorSetLayoutBinding> m_DescriptorSetLayoutBindingData;
+	DescriptorAllocator::PoolSizes m_PoolSizes;
+
+	vector<VkDescriptorSetLayoutBinding> m_Bindings; //indexed by binding
+	vector<size_t> m_DescriptorInfoOffsets;
+	size_t m_DescriptorInfoCnt = 0;
+
+	VkDescriptorUpdateTemplateKHR m_UpdateTemplate = VK_NULL_HANDLE;
+	PFN_vkUpdateDescriptorSetWithTemplateKHR m_UpdateDescriptorSetWithTemplate = nullptr;
+	PFN_vkDestroyDescriptorUpdateTemplateKHR m_DestroyDescriptorUpdateTemplate = nullptr;
 };
 
 class DescriptorSet
@@ -135,22 +214,37 @@ public:
 	void setSampler(string const& paramName, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout);
 	void setImageStorage(string const& paramName, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout);
 	void setBuffer(string const& paramName, Buffer const& buffer);
+	void setDynamicBuffer(string const& paramName, VkBuffer buffer, VkDeviceSize range); //offset is passed to vkCmdBindDescriptorSets
 	void setStorage(string const& paramName, Buffer const& buffer);
 
+	//binding from DescriptorSetLayout::getBinding, no name lookup
+	void setSamplerArray(uint32_t binding, vector<VkImageView> const& imageViews, VkSampler sampler, VkImageLayout imageLayout);
+	void setSampler(uint32_t binding, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout);
+	void setImageStorage(uint32_t binding, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout);
+	void setBuffer(uint32_t binding, Buffer const& buffer);
+	void setDynamicBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize range);
+	void setStorage(uint32_t binding, Buffer const& buffer);
+
+	//setters only record descriptors, all bindings changed since last update are written by one call
+	void update();
+
 	VkDescriptorSet getDescriptorSet() const;
 	shared_ptr<DescriptorSetLayout> getDescriptorSetlayout() const;
 private:
 
-	void updateDescriptorSet(VkDescriptorSetLayoutBinding const& descSetLayoutBinding);
+	DescriptorInfo* getDescriptorInfo(uint32_t binding, VkDescriptorType type);
+	void setBufferInfo(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize range);
 
 	void destroy();
 	DescriptorSet(DescriptorSet const&) = default;
 	DescriptorSet& operator=(DescriptorSet const&) = default;
 
 	VkDescriptorSet m_DescriptorSet;
-	VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+	DescriptorAllocation m_Allocation;
 	shared_ptr<DescriptorSetLayout> m_DescriptorSetLayout;
-	vector<pair< VkDescriptorType, variant< vector<VkDescriptorImageInfo>, VkDescriptorBufferInfo> >> m_DescriptorInfo;
+	vector<DescriptorInfo> m_DescriptorInfo; //packed as expected by update template
+	vector<bool> m_Written; //per binding, template can be used only when every binding is valid
+	vector<bool> m_Dirty; //per binding, changed since last update
 };
 
 
@@ -172,7 +266,7 @@ struct MaterialDescription
 class MaterialManager
 {
 public:
-	MaterialManager(TextureManager& textureManager, VkDevice device, VkPhysicalDevice physicalDevice);
+	MaterialManager(TextureManager& textureManager, StagingRing& stagingRing, VkDevice device, VkPhysicalDevice physicalDevice);
 	shared_ptr<const MaterialDescription> createMaterial(tinyobj::material_t const& material, const string& path);
 	shared_ptr <DescriptorSetLayout> getDescriptorSetLayout() const;
 	
@@ -182,8 +276,17 @@ private:
 	
 	shared_ptr<const Sampler> m_Sampler;
 	TextureManager& m_TextureManager;
+	StagingRing& m_StagingRing;
 
 	shared_ptr <DescriptorSetLayout> m_DecriptorSetLayout;
 
+	//resolved once from m_DecriptorSetLayout
+	uint32_t m_MaterialBufferBinding;
+	uint32_t m_DiffuseTexBinding;
+	uint32_t m_SpecularTexBinding;
+	uint32_t m_NormalTexBinding;
+	uint32_t m_SpecularHighlightTexBinding;
+	uint32_t m_AoTexBinding;
+
 	unordered_map<string, weak_ptr <const MaterialDescription> > m_Data;
 };
\ No newline at end of file
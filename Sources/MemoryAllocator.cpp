@@ -0,0 +1,407 @@
+
+#include "MemoryAllocator.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+	uint32_t log2(VkDeviceSize value)
+	{
+		uint32_t result = 0;
+		while (value > 1)
+		{
+			value >>= 1;
+			++result;
+		}
+
+		return result;
+	}
+
+	VkDeviceSize roundUpToPowerOfTwo(VkDeviceSize value)
+	{
+		VkDeviceSize result = 1;
+		while (result < value) result <<= 1;
+
+		return result;
+	}
+}
+
+unordered_map<VkDevice, MemoryAllocator*> MemoryAllocator::s_Allocators;
+
+
+	MemoryAllocator::MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device) : m_PhysicalDevice(physicalDevice), m_Device(device)
+	{
+		vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &m_MemoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
+		m_MaxAllocationCnt = properties.limits.maxMemoryAllocationCount;
+		m_NonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+
+		assert(s_Allocators.count(m_Device) == 0 && "Only one MemoryAllocator per device!");
+		s_Allocators[m_Device] = this;
+	}
+
+	MemoryAllocator::~MemoryAllocator()
+	{
+		if (m_Statistics.allocationCnt + m_Statistics.dedicatedAllocationCnt > 0)
+		{
+			cout << "MemoryAllocator: " << m_Statistics.allocationCnt + m_Statistics.dedicatedAllocationCnt << " allocations were not freed" << endl;
+		}
+
+		for (auto& pool : m_Pools)
+		{
+			for (auto& block : pool.blocks) freeMemory(block->memory, block->mappedPtr != nullptr);
+		}
+
+		s_Allocators.erase(m_Device);
+	}
+
+	MemoryAllocator& MemoryAllocator::get(VkDevice device)
+	{
+		auto it = s_Allocators.find(device);
+		assert(it != end(s_Allocators) && "No MemoryAllocator created for device!");
+
+		return *it->second;
+	}
+
+	uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+		{
+			if ((typeFilter & (1 << i)) && (m_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return i;
+			}
+		}
+
+		assert(!"Type not found!");
+		return 0;
+	}
+
+	bool MemoryAllocator::isHostVisible(uint32_t memoryType) const
+	{
+		return (m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+	}
+
+	MemoryAllocator::Pool& MemoryAllocator::getPool(uint32_t memoryType, bool optimalImages, uint32_t& outPoolIdx)
+	{
+		for (uint32_t i = 0; i < m_Pools.size(); ++i)
+		{
+			if (m_Pools[i].memoryType == memoryType && m_Pools[i].optimalImages == optimalImages)
+			{
+				outPoolIdx = i;
+				return m_Pools[i];
+			}
+		}
+
+		//small heaps (e.g. device local host visible) get smaller blocks
+		VkDeviceSize const heapSize = m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[memoryType].heapIndex].size;
+
+		Pool pool;
+		pool.memoryType = memoryType;
+		pool.optimalImages = optimalImages;
+		pool.blockSize = MAX_BLOCK_SIZE;
+		while (pool.blockSize > heapSize / 8 && pool.blockSize > MIN_ALLOCATION_SIZE) pool.blockSize /= 2;
+		pool.maxOrder = log2(pool.blockSize / MIN_ALLOCATION_SIZE);
+
+		m_Pools.push_back(move(pool));
+
+		outPoolIdx = static_cast<uint32_t>(m_Pools.size() - 1);
+		return m_Pools.back();
+	}
+
+	VkDeviceMemory MemoryAllocator::allocateMemory(VkDeviceSize size, uint32_t memoryType, uint8_t*& outMappedPtr)
+	{
+		assert(m_DeviceAllocationCnt < m_MaxAllocationCnt && "maxMemoryAllocationCount reached!");
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		VkDeviceMemory memory;
+		auto res = vkAllocateMemory(m_Device, &allocInfo, nullptr, &memory);
+		assert(res == VK_SUCCESS);
+
+		outMappedPtr = nullptr;
+		if (isHostVisible(memoryType))
+		{
+			void* data;
+			res = vkMapMemory(m_Device, memory, 0, VK_WHOLE_SIZE, 0, &data);
+			assert(res == VK_SUCCESS);
+
+			outMappedPtr = static_cast<uint8_t*>(data);
+		}
+
+		++m_DeviceAllocationCnt;
+
+		return memory;
+	}
+
+	void MemoryAllocator::freeMemory(VkDeviceMemory memory, bool mapped)
+	{
+		if (mapped) vkUnmapMemory(m_Device, memory);
+		vkFreeMemory(m_Device, memory, nullptr);
+
+		--m_DeviceAllocationCnt;
+	}
+
+	bool MemoryAllocator::allocateFromBlock(Pool& pool, Block& block, uint32_t order, VkDeviceSize& outOffset)
+	{
+		uint32_t freeOrder = order;
+		while (freeOrder <= pool.maxOrder && block.freeOffsets[freeOrder].empty()) ++freeOrder;
+
+		if (freeOrder > pool.maxOrder) return false;
+
+		VkDeviceSize const offset = *begin(block.freeOffsets[freeOrder]);
+		block.freeOffsets[freeOrder].erase(begin(block.freeOffsets[freeOrder]));
+
+		//split, upper halves stay free
+		while (freeOrder > order)
+		{
+			--freeOrder;
+			block.freeOffsets[freeOrder].insert(offset + (MIN_ALLOCATION_SIZE << freeOrder));
+		}
+
+		++block.allocationCnt;
+		outOffset = offset;
+
+		return true;
+	}
+
+	void MemoryAllocator::freeToBlock(Pool& pool, Block& block, VkDeviceSize offset, uint32_t order)
+	{
+		//merge with free buddies
+		while (order < pool.maxOrder)
+		{
+			VkDeviceSize const buddy = offset ^ (MIN_ALLOCATION_SIZE << order);
+
+			auto it = block.freeOffsets[order].find(buddy);
+			if (it == end(block.freeOffsets[order])) break;
+
+			block.freeOffsets[order].erase(it);
+			offset = min(offset, buddy);
+			++order;
+		}
+
+		block.freeOffsets[order].insert(offset);
+		--block.allocationCnt;
+	}
+
+	MemoryAllocation MemoryAllocator::allocate(VkMemoryRequirements const& requirements, VkMemoryPropertyFlags properties, bool optimalImage)
+	{
+		MemoryAllocation allocation;
+		allocation.memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+		allocation.coherent = (m_MemoryProperties.memoryTypes[allocation.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+		allocation.size = requirements.size;
+
+		Pool& pool = getPool(allocation.memoryType, optimalImage, allocation.pool);
+
+		//buddy ranges are aligned to their size, so alignment is satisfied by rounding size up
+		VkDeviceSize const reservedSize = roundUpToPowerOfTwo(max({ requirements.size, requirements.alignment, MIN_ALLOCATION_SIZE }));
+
+		if (reservedSize > pool.blockSize / 2 || (optimalImage && requirements.size >= DEDICATED_IMAGE_SIZE))
+		{
+			uint8_t* mappedPtr;
+			allocation.memory = allocateMemory(requirements.size, allocation.memoryType, mappedPtr);
+			allocation.mappedPtr = mappedPtr;
+			allocation.dedicated = true;
+
+			++m_Statistics.dedicatedAllocationCnt;
+			m_Statistics.dedicatedBytes += requirements.size;
+
+			return allocation;
+		}
+
+		allocation.order = log2(reservedSize / MIN_ALLOCATION_SIZE);
+
+		Block* block = nullptr;
+		for (auto& candidate : pool.blocks)
+		{
+			if (allocateFromBlock(pool, *candidate, allocation.order, allocation.offset))
+			{
+				block = candidate.get();
+				break;
+			}
+		}
+
+		if (block == nullptr)
+		{
+			unique_ptr<Block> newBlock = make_unique<Block>();
+			newBlock->memory = allocateMemory(pool.blockSize, pool.memoryType, newBlock->mappedPtr);
+			newBlock->freeOffsets.resize(pool.maxOrder + 1);
+			newBlock->freeOffsets[pool.maxOrder].insert(0);
+			newBlock->allocationCnt = 0;
+
+			block = newBlock.get();
+			m_BlockByMemory[block->memory] = block;
+			pool.blocks.push_back(move(newBlock));
+
+			++m_Statistics.blockCnt;
+			m_Statistics.blockBytes += pool.blockSize;
+
+			bool const allocated = allocateFromBlock(pool, *block, allocation.order, allocation.offset);
+			assert(allocated);
+		}
+
+		allocation.memory = block->memory;
+		allocation.mappedPtr = block->mappedPtr != nullptr ? block->mappedPtr + allocation.offset : nullptr;
+
+		++m_Statistics.allocationCnt;
+		m_Statistics.usedBytes += requirements.size;
+		m_Statistics.reservedBytes += reservedSize;
+
+		return allocation;
+	}
+
+	void MemoryAllocator::free(MemoryAllocation const& allocation)
+	{
+		if (allocation.memory == VK_NULL_HANDLE) return;
+
+		if (allocation.dedicated)
+		{
+			freeMemory(allocation.memory, allocation.mappedPtr != nullptr);
+
+			--m_Statistics.dedicatedAllocationCnt;
+			m_Statistics.dedicatedBytes -= allocation.size;
+
+			return;
+		}
+
+		Pool& pool = m_Pools[allocation.pool];
+		Block* block = m_BlockByMemory[allocation.memory];
+
+		freeToBlock(pool, *block, allocation.offset, allocation.order);
+
+		--m_Statistics.allocationCnt;
+		m_Statistics.usedBytes -= allocation.size;
+		m_Statistics.reservedBytes -= MIN_ALLOCATION_SIZE << allocation.order;
+
+		//keep last block of pool alive, so loading and releasing a single resource does not reallocate memory
+		if (block->allocationCnt == 0 && pool.blocks.size() > 1)
+		{
+			freeMemory(block->memory, block->mappedPtr != nullptr);
+			m_BlockByMemory.erase(block->memory);
+
+			pool.blocks.erase(find_if(begin(pool.blocks), end(pool.blocks), [block](unique_ptr<Block> const& candidate) { return candidate.get() == block; }));
+
+			--m_Statistics.blockCnt;
+			m_Statistics.blockBytes -= pool.blockSize;
+		}
+	}
+
+	VkMappedMemoryRange MemoryAllocator::getMappedRange(MemoryAllocation const& allocation, VkDeviceSize offset, VkDeviceSize size) const
+	{
+		VkDeviceSize begin = allocation.offset + offset;
+		VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+		//range has to be multiple of nonCoherentAtomSize, buddy ranges are aligned to at least MIN_ALLOCATION_SIZE (>= max atom size)
+		begin = begin / m_NonCoherentAtomSize * m_NonCoherentAtomSize;
+		end = (end + m_NonCoherentAtomSize - 1) / m_NonCoherentAtomSize * m_NonCoherentAtomSize;
+
+		VkMappedMemoryRange range = {};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = allocation.memory;
+		range.offset = begin;
+		range.size = allocation.dedicated && end >= allocation.size ? VK_WHOLE_SIZE : end - begin;
+
+		return range;
+	}
+
+	void MemoryAllocator::flush(MemoryAllocation const& allocation, VkDeviceSize offset, VkDeviceSize size) const
+	{
+		if (allocation.coherent) return;
+
+		VkMappedMemoryRange range = getMappedRange(allocation, offset, size);
+		auto res = vkFlushMappedMemoryRanges(m_Device, 1, &range);
+		assert(res == VK_SUCCESS);
+	}
+
+	void MemoryAllocator::invalidate(MemoryAllocation const& allocation, VkDeviceSize offset, VkDeviceSize size) const
+	{
+		if (allocation.coherent) return;
+
+		VkMappedMemoryRange range = getMappedRange(allocation, offset, size);
+		auto res = vkInvalidateMappedMemoryRanges(m_Device, 1, &range);
+		assert(res == VK_SUCCESS);
+	}
+
+	MemoryAllocation MemoryAllocator::allocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+	{
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(m_Device, buffer, &memRequirements);
+
+		MemoryAllocation allocation = allocate(memRequirements, properties, false);
+
+		auto res = vkBindBufferMemory(m_Device, buffer, allocation.memory, allocation.offset);
+		assert(res == VK_SUCCESS);
+
+		return allocation;
+	}
+
+	MemoryAllocation MemoryAllocator::allocateImage(VkImage image, VkMemoryPropertyFlags properties, bool optimalTiling)
+	{
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(m_Device, image, &memRequirements);
+
+		MemoryAllocation allocation = allocate(memRequirements, properties, optimalTiling);
+
+		auto res = vkBindImageMemory(m_Device, image, allocation.memory, allocation.offset);
+		assert(res == VK_SUCCESS);
+
+		return allocation;
+	}
+
+	MemoryStatistics MemoryAllocator::getStatistics() const
+	{
+		return m_Statistics;
+	}
+
+	float MemoryAllocator::getFragmentation() const
+	{
+		VkDeviceSize freeSize = 0;
+		VkDeviceSize fragmentedSize = 0;
+
+		for (auto const& pool : m_Pools)
+		{
+			VkDeviceSize poolFreeSize = 0;
+			VkDeviceSize largestFreeSize = 0;
+
+			for (auto const& block : pool.blocks)
+			{
+				for (uint32_t order = 0; order <= pool.maxOrder; ++order)
+				{
+					if (block->freeOffsets[order].empty()) continue;
+
+					poolFreeSize += block->freeOffsets[order].size() * (MIN_ALLOCATION_SIZE << order);
+					largestFreeSize = max(largestFreeSize, MIN_ALLOCATION_SIZE << order);
+				}
+			}
+
+			freeSize += poolFreeSize;
+			fragmentedSize += poolFreeSize - largestFreeSize;
+		}
+
+		return freeSize == 0 ? 0.0f : static_cast<float>(fragmentedSize) / freeSize;
+	}
+
+	void MemoryAllocator::printStatistics() const
+	{
+		auto toMB = [](VkDeviceSize bytes) { return bytes / (1024.0 * 1024.0); };
+
+		cout << "GPU memory: " << m_DeviceAllocationCnt << " vkAllocateMemory allocations (limit " << m_MaxAllocationCnt << ")" << endl;
+		cout << "  blocks: " << m_Statistics.blockCnt << ", " << toMB(m_Statistics.blockBytes) << " MB" << endl;
+		cout << "  sub-allocations: " << m_Statistics.allocationCnt << ", used " << toMB(m_Statistics.usedBytes) << " MB, reserved " << toMB(m_Statistics.reservedBytes) << " MB" << endl;
+		cout << "  dedicated: " << m_Statistics.dedicatedAllocationCnt << ", " << toMB(m_Statistics.dedicatedBytes) << " MB" << endl;
+		cout << "  fragmentation: " << getFragmentation() << endl;
+
+		for (auto const& pool : m_Pools)
+		{
+			cout << "  memory type " << pool.memoryType << (pool.optimalImages ? " (optimal images)" : " (buffers)") << ": " << pool.blocks.size() << " x " << toMB(pool.blockSize) << " MB blocks" << endl;
+		}
+	}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//Sub-allocated range of VkDeviceMemory block (or whole dedicated allocation)
+struct MemoryAllocation
+{
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0; //requested size
+	void* mappedPtr = nullptr; //host visible memory is persistently mapped, already includes offset
+	bool coherent = true; //false when host writes / GPU writes have to be flushed / invalidated explicitly
+
+	uint32_t memoryType = 0;
+	uint32_t pool = 0;
+	uint32_t order = 0; //buddy order, size of reserved range is MemoryAllocator::MIN_ALLOCATION_SIZE << order
+	bool dedicated = false;
+};
+
+struct MemoryStatistics
+{
+	size_t blockCnt = 0;
+	size_t allocationCnt = 0;
+	size_t dedicatedAllocationCnt = 0;
+	VkDeviceSize blockBytes = 0;
+	VkDeviceSize usedBytes = 0; //requested sizes of sub-allocations
+	VkDeviceSize reservedBytes = 0; //buddy ranges of sub-allocations, difference to usedBytes is internal fragmentation
+	VkDeviceSize dedicatedBytes = 0;
+};
+
+//Buddy sub-allocator over few big VkDeviceMemory blocks per memory type. Buffers and linear images never share
+//a pool with optimal images, so bufferImageGranularity cannot be violated by neighbouring resources.
+class MemoryAllocator
+{
+public:
+	MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+	~MemoryAllocator();
+	MemoryAllocator(MemoryAllocator const&) = delete;
+	MemoryAllocator& operator=(MemoryAllocator const&) = delete;
+
+	//allocator registered for device, resource creation helpers only know VkDevice
+	static MemoryAllocator& get(VkDevice device);
+
+	MemoryAllocation allocate(VkMemoryRequirements const& requirements, VkMemoryPropertyFlags properties, bool optimalImage);
+	void free(MemoryAllocation const& allocation);
+
+	//make host writes of [offset, offset + size) of allocation visible to GPU, no-op for coherent memory
+	void flush(MemoryAllocation const& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+	//make GPU writes visible to host before reading mapped pointer, no-op for coherent memory
+	void invalidate(MemoryAllocation const& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+
+	//allocate + bind
+	MemoryAllocation allocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+	MemoryAllocation allocateImage(VkImage image, VkMemoryPropertyFlags properties, bool optimalTiling);
+
+	MemoryStatistics getStatistics() const;
+	void printStatistics() const;
+
+	//1 - largest free range / free space of blocks, per pool weighted by free space, 0 when every pool has contiguous free space
+	float getFragmentation() const;
+
+	static const VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+	static const VkDeviceSize MAX_BLOCK_SIZE = 64 * 1024 * 1024;
+	static const VkDeviceSize DEDICATED_IMAGE_SIZE = 16 * 1024 * 1024; //bigger images (render targets, big textures) get own memory
+
+private:
+	struct Block
+	{
+		VkDeviceMemory memory;
+		uint8_t* mappedPtr;
+		vector<set<VkDeviceSize>> freeOffsets; //per buddy order
+		size_t allocationCnt;
+	};
+
+	struct Pool
+	{
+		uint32_t memoryType;
+		bool optimalImages;
+		VkDeviceSize blockSize;
+		uint32_t maxOrder;
+		vector<unique_ptr<Block>> blocks;
+	};
+
+	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+	Pool& getPool(uint32_t memoryType, bool optimalImages, uint32_t& outPoolIdx);
+
+	VkDeviceMemory allocateMemory(VkDeviceSize size, uint32_t memoryType, uint8_t*& outMappedPtr);
+	void freeMemory(VkDeviceMemory memory, bool mapped);
+	bool isHostVisible(uint32_t memoryType) const;
+	VkMappedMemoryRange getMappedRange(MemoryAllocation const& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+
+	bool allocateFromBlock(Pool& pool, Block& block, uint32_t order, VkDeviceSize& outOffset);
+	void freeToBlock(Pool& pool, Block& block, VkDeviceSize offset, uint32_t order);
+
+	VkPhysicalDevice m_PhysicalDevice;
+	VkDevice m_Device;
+	VkPhysicalDeviceMemoryProperties m_MemoryProperties;
+	uint32_t m_MaxAllocationCnt;
+	uint32_t m_DeviceAllocationCnt = 0; //live vkAllocateMemory calls
+	VkDeviceSize m_NonCoherentAtomSize;
+
+	vector<Pool> m_Pools;
+	unordered_map<VkDeviceMemory, Block*> m_BlockByMemory;
+
+	MemoryStatistics m_Statistics;
+
+	static unordered_map<VkDevice, MemoryAllocator*> s_Allocators;
+};
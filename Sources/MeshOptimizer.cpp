@@ -0,0 +1,269 @@
+
+#include "MeshOptimizer.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <numeric>
+#include <glm/vec3.hpp>
+#include <glm/geometric.hpp>
+
+using namespace std;
+
+
+	VertexCacheStatistics MeshOptimizer::analyzeVertexCache(vector<unsigned int> const& indices, size_t vertexCnt, unsigned int cacheSize)
+	{
+		VertexCacheStatistics statistics;
+
+		if (indices.size() < 3 || vertexCnt == 0) return statistics;
+
+		//vertex is in FIFO cache if it was transformed within last cacheSize misses
+		vector<unsigned int> cacheTimeStamps(vertexCnt, 0);
+		unsigned int timeStamp = cacheSize + 1;
+		size_t transformedCnt = 0;
+
+		for (auto index : indices)
+		{
+			if (timeStamp - cacheTimeStamps[index] > cacheSize)
+			{
+				cacheTimeStamps[index] = timeStamp++;
+				++transformedCnt;
+			}
+		}
+
+		statistics.acmr = static_cast<float>(transformedCnt) / static_cast<float>(indices.size() / 3);
+		statistics.atvr = static_cast<float>(transformedCnt) / static_cast<float>(vertexCnt);
+
+		return statistics;
+	}
+
+	void MeshOptimizer::optimizeVertexCache(vector<unsigned int>& indices, size_t vertexCnt, vector<unsigned int>& outClusters, unsigned int cacheSize)
+	{
+		outClusters.clear();
+
+		size_t const triangleCnt = indices.size() / 3;
+		if (triangleCnt == 0) return;
+
+		//count of not yet emitted triangles using given vertex
+		vector<unsigned int> liveTriangles(vertexCnt, 0);
+		for (auto index : indices) ++liveTriangles[index];
+
+		//vertex -> triangles adjacency
+		vector<unsigned int> adjacencyOffsets(vertexCnt + 1, 0);
+		for (size_t v = 0; v < vertexCnt; ++v) adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+		vector<unsigned int> adjacency(indices.size());
+		{
+			vector<unsigned int> fillOffsets(begin(adjacencyOffsets), end(adjacencyOffsets) - 1);
+			for (size_t i = 0; i < indices.size(); ++i) adjacency[fillOffsets[indices[i]]++] = static_cast<unsigned int>(i / 3);
+		}
+
+		vector<unsigned int> cacheTimeStamps(vertexCnt, 0);
+		vector<bool> emitted(triangleCnt, false);
+		vector<unsigned int> deadEndStack;
+		vector<unsigned int> candidates;
+		vector<unsigned int> output;
+		output.reserve(indices.size());
+
+		unsigned int timeStamp = cacheSize + 1;
+		size_t inputCursor = 0;
+		int fanningVertex = static_cast<int>(indices[0]);
+
+		outClusters.push_back(0);
+
+		while (fanningVertex >= 0)
+		{
+			candidates.clear();
+
+			//emit all remaining triangles around fanning vertex
+			for (unsigned int adj = adjacencyOffsets[fanningVertex]; adj < adjacencyOffsets[fanningVertex + 1]; ++adj)
+			{
+				unsigned int const triangle = adjacency[adj];
+				if (emitted[triangle]) continue;
+
+				for (unsigned int k = 0; k < 3; ++k)
+				{
+					unsigned int const v = indices[triangle * 3 + k];
+
+					output.push_back(v);
+					deadEndStack.push_back(v);
+					candidates.push_back(v);
+					--liveTriangles[v];
+
+					if (timeStamp - cacheTimeStamps[v] > cacheSize)
+					{
+						cacheTimeStamps[v] = timeStamp++;
+					}
+				}
+
+				emitted[triangle] = true;
+			}
+
+			//pick candidate which stays in cache after its remaining triangles are emitted, prefer the oldest one
+			int nextVertex = -1;
+			int bestPriority = -1;
+
+			for (auto v : candidates)
+			{
+				if (liveTriangles[v] == 0) continue;
+
+				int priority = 0;
+				if (timeStamp - cacheTimeStamps[v] + 2 * liveTriangles[v] <= cacheSize)
+				{
+					priority = static_cast<int>(timeStamp - cacheTimeStamps[v]);
+				}
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					nextVertex = static_cast<int>(v);
+				}
+			}
+
+			if (nextVertex == -1)
+			{
+				//dead end, try recently referenced vertices first
+				while (!deadEndStack.empty() && nextVertex == -1)
+				{
+					unsigned int const v = deadEndStack.back();
+					deadEndStack.pop_back();
+
+					if (liveTriangles[v] > 0) nextVertex = static_cast<int>(v);
+				}
+
+				//nothing in cache to continue with, take next vertex in input order -> hard cluster boundary
+				if (nextVertex == -1)
+				{
+					while (inputCursor < vertexCnt && liveTriangles[inputCursor] == 0) ++inputCursor;
+
+					if (inputCursor < vertexCnt)
+					{
+						nextVertex = static_cast<int>(inputCursor);
+
+						unsigned int const clusterStart = static_cast<unsigned int>(output.size() / 3);
+						if (clusterStart > outClusters.back()) outClusters.push_back(clusterStart);
+					}
+				}
+			}
+
+			fanningVertex = nextVertex;
+		}
+
+		assert(output.size() == indices.size());
+		indices = move(output);
+	}
+
+	size_t MeshOptimizer::optimizeOverdraw(vector<unsigned int>& indices, vector<float> const& positions, vector<unsigned int> const& hardClusters, float threshold, unsigned int cacheSize)
+	{
+		size_t const triangleCnt = indices.size() / 3;
+		size_t const vertexCnt = positions.size() / 3;
+
+		if (triangleCnt == 0) return 0;
+
+		float const meshAcmr = analyzeVertexCache(indices, vertexCnt, cacheSize).acmr;
+
+		//split hard clusters, every cluster starts with cold cache as clusters are reordered afterwards
+		vector<unsigned int> clusters;
+		vector<unsigned int> cacheTimeStamps(vertexCnt, 0);
+		unsigned int timeStamp = cacheSize + 1;
+
+		vector<unsigned int> hardBoundaries = hardClusters.empty() ? vector<unsigned int>(1, 0) : hardClusters;
+
+		for (size_t c = 0; c < hardBoundaries.size(); ++c)
+		{
+			size_t const start = hardBoundaries[c];
+			size_t const stop = (c + 1 < hardBoundaries.size()) ? hardBoundaries[c + 1] : triangleCnt;
+
+			size_t clusterStart = start;
+			size_t clusterMisses = 0;
+			timeStamp += cacheSize + 1;
+			clusters.push_back(static_cast<unsigned int>(start));
+
+			for (size_t t = start; t < stop; ++t)
+			{
+				for (size_t k = 0; k < 3; ++k)
+				{
+					unsigned int const v = indices[t * 3 + k];
+					if (timeStamp - cacheTimeStamps[v] > cacheSize)
+					{
+						cacheTimeStamps[v] = timeStamp++;
+						++clusterMisses;
+					}
+				}
+
+				float const clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(t - clusterStart + 1);
+
+				if (t + 1 < stop && clusterAcmr <= threshold * meshAcmr)
+				{
+					clusterStart = t + 1;
+					clusterMisses = 0;
+					timeStamp += cacheSize + 1;
+					clusters.push_back(static_cast<unsigned int>(clusterStart));
+				}
+			}
+		}
+
+		auto getPosition = [&positions](unsigned int idx)
+		{
+			return glm::vec3(positions[idx * 3], positions[idx * 3 + 1], positions[idx * 3 + 2]);
+		};
+
+		glm::vec3 meshCentroid(0.0f);
+		for (size_t v = 0; v < vertexCnt; ++v) meshCentroid += getPosition(static_cast<unsigned int>(v));
+		meshCentroid /= static_cast<float>(max<size_t>(vertexCnt, 1));
+
+		//clusters facing away from mesh center are drawn first, they are likely to occlude the inner ones
+		vector<float> sortKeys(clusters.size());
+
+		for (size_t c = 0; c < clusters.size(); ++c)
+		{
+			size_t const start = clusters[c];
+			size_t const stop = (c + 1 < clusters.size()) ? clusters[c + 1] : triangleCnt;
+
+			glm::vec3 centroid(0.0f);
+			glm::vec3 normal(0.0f);
+			float area = 0.0f;
+
+			for (size_t t = start; t < stop; ++t)
+			{
+				glm::vec3 const p0 = getPosition(indices[t * 3]);
+				glm::vec3 const p1 = getPosition(indices[t * 3 + 1]);
+				glm::vec3 const p2 = getPosition(indices[t * 3 + 2]);
+
+				glm::vec3 const triangleNormal = glm::cross(p1 - p0, p2 - p0);
+				float const triangleArea = glm::length(triangleNormal);
+
+				centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+				normal += triangleNormal;
+				area += triangleArea;
+			}
+
+			if (area > 0.0f) centroid /= area;
+
+			float const normalLength = glm::length(normal);
+			if (normalLength > 0.0f) normal /= normalLength;
+
+			sortKeys[c] = glm::dot(centroid - meshCentroid, normal);
+		}
+
+		vector<size_t> clusterOrder(clusters.size());
+		iota(begin(clusterOrder), end(clusterOrder), 0);
+		stable_sort(begin(clusterOrder), end(clusterOrder), [&sortKeys](size_t a, size_t b)
+			{
+				return sortKeys[a] > sortKeys[b];
+			});
+
+		vector<unsigned int> output;
+		output.reserve(indices.size());
+
+		for (auto c : clusterOrder)
+		{
+			size_t const start = clusters[c];
+			size_t const stop = (c + 1 < clusters.size()) ? clusters[c + 1] : triangleCnt;
+
+			output.insert(output.end(), begin(indices) + start * 3, begin(indices) + stop * 3);
+		}
+
+		indices = move(output);
+
+		return clusters.size();
+	}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+
+using namespace std;
+
+struct VertexCacheStatistics
+{
+	float acmr = 0.0f; //average cache miss ratio: transformed vertices per triangle (0.5 best, 3.0 worst)
+	float atvr = 0.0f; //average transformed vertex ratio: transformed vertices per unique vertex (1.0 best)
+};
+
+struct MeshOptimizationStatistics
+{
+	VertexCacheStatistics before;
+	VertexCacheStatistics after;
+	size_t clusterCnt = 0;
+};
+
+//Reorders index/vertex data of triangle lists to improve post-transform vertex cache hit rate, overdraw and vertex fetch locality
+class MeshOptimizer
+{
+public:
+	static const unsigned int CACHE_SIZE = 16;
+
+	//simulates FIFO post-transform cache
+	static VertexCacheStatistics analyzeVertexCache(vector<unsigned int> const& indices, size_t vertexCnt, unsigned int cacheSize = CACHE_SIZE);
+
+	//Tipsify (Sander et al. 2007), outClusters receives index of first triangle of each cluster (hard boundaries where the algorithm jumped to a dead end)
+	static void optimizeVertexCache(vector<unsigned int>& indices, size_t vertexCnt, vector<unsigned int>& outClusters, unsigned int cacheSize = CACHE_SIZE);
+
+	//splits hard clusters into smaller ones while their local ACMR stays below threshold * ACMR of whole mesh, then sorts clusters front to back (outward facing first)
+	//positions are tightly packed xyz floats
+	static size_t optimizeOverdraw(vector<unsigned int>& indices, vector<float> const& positions, vector<unsigned int> const& hardClusters, float threshold = 1.05f, unsigned int cacheSize = CACHE_SIZE);
+
+	//reorders vertices in order of first use in index buffer, unreferenced vertices are removed
+	template<typename T> static void optimizeVertexFetch(vector<T>& vertices, vector<unsigned int>& indices)
+	{
+		unsigned int const invalidIdx = numeric_limits<unsigned int>::max();
+
+		vector<unsigned int> remap(vertices.size(), invalidIdx);
+		vector<T> reorderedVertices;
+		reorderedVertices.reserve(vertices.size());
+
+		for (auto& index : indices)
+		{
+			if (remap[index] == invalidIdx)
+			{
+				remap[index] = static_cast<unsigned int>(reorderedVertices.size());
+				reorderedVertices.push_back(vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		vertices = move(reorderedVertices);
+	}
+};
@@ -0,0 +1,280 @@
+
+#include "MeshSimplifier.h"
+
+#include <math.h>
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <unordered_set>
+#include <glm/vec3.hpp>
+#include <glm/geometric.hpp>
+
+using namespace std;
+
+namespace
+{
+	//symmetric 4x4 matrix of plane equation outer products, weighted by triangle area
+	struct Quadric
+	{
+		double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+		double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+		double a22 = 0.0, a23 = 0.0;
+		double a33 = 0.0;
+		double weight = 0.0;
+
+		Quadric() = default;
+
+		Quadric(glm::vec3 const& n, float d, float w)
+		{
+			a00 = w * n.x * n.x; a01 = w * n.x * n.y; a02 = w * n.x * n.z; a03 = w * n.x * d;
+			a11 = w * n.y * n.y; a12 = w * n.y * n.z; a13 = w * n.y * d;
+			a22 = w * n.z * n.z; a23 = w * n.z * d;
+			a33 = w * d * d;
+			weight = w;
+		}
+
+		void add(Quadric const& q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+			a11 += q.a11; a12 += q.a12; a13 += q.a13;
+			a22 += q.a22; a23 += q.a23;
+			a33 += q.a33;
+			weight += q.weight;
+		}
+
+		//weighted sum of squared distances of p to all accumulated planes
+		double evaluate(glm::vec3 const& p) const
+		{
+			double const x = p.x, y = p.y, z = p.z;
+
+			return a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+				+ a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+				+ a22 * z * z + 2.0 * a23 * z
+				+ a33;
+		}
+	};
+
+	struct Collapse
+	{
+		float cost;
+		unsigned int from;
+		unsigned int to;
+
+		//priority_queue keeps the cheapest collapse on top
+		bool operator<(Collapse const& other) const
+		{
+			return cost > other.cost;
+		}
+	};
+}
+
+
+	vector<unsigned int> MeshSimplifier::simplify(vector<unsigned int> const& indices, vector<float> const& positions, size_t targetIndexCnt, float targetError, float& outError)
+	{
+		outError = 0.0f;
+
+		size_t const vertexCnt = positions.size() / 3;
+		size_t const triangleCnt = indices.size() / 3;
+
+		vector<unsigned int> triangles = indices;
+		if (triangles.size() <= targetIndexCnt) return triangles;
+
+		auto getPosition = [&positions](unsigned int idx)
+		{
+			return glm::vec3(positions[idx * 3], positions[idx * 3 + 1], positions[idx * 3 + 2]);
+		};
+
+		vector<bool> locked(vertexCnt, false);
+
+		{	//lock attribute seams, vertices sharing position with other vertex
+			vector<unsigned int> order(vertexCnt);
+			iota(begin(order), end(order), 0);
+			sort(begin(order), end(order), [&positions](unsigned int a, unsigned int b)
+				{
+					return lexicographical_compare(&positions[a * 3], &positions[a * 3 + 3], &positions[b * 3], &positions[b * 3 + 3]);
+				});
+
+			for (size_t i = 1; i < order.size(); ++i)
+			{
+				if (equal(&positions[order[i - 1] * 3], &positions[order[i - 1] * 3 + 3], &positions[order[i] * 3]))
+				{
+					locked[order[i - 1]] = locked[order[i]] = true;
+				}
+			}
+		}
+
+		{	//lock borders, edges without opposite half edge
+			auto edgeKey = [](unsigned int a, unsigned int b)
+			{
+				return (static_cast<unsigned long long>(a) << 32) | b;
+			};
+
+			unordered_set<unsigned long long> halfEdges;
+			for (size_t t = 0; t < triangleCnt; ++t)
+			{
+				for (size_t k = 0; k < 3; ++k) halfEdges.insert(edgeKey(triangles[t * 3 + k], triangles[t * 3 + (k + 1) % 3]));
+			}
+
+			for (size_t t = 0; t < triangleCnt; ++t)
+			{
+				for (size_t k = 0; k < 3; ++k)
+				{
+					unsigned int const a = triangles[t * 3 + k];
+					unsigned int const b = triangles[t * 3 + (k + 1) % 3];
+
+					if (halfEdges.count(edgeKey(b, a)) == 0) locked[a] = locked[b] = true;
+				}
+			}
+		}
+
+		vector<Quadric> quadrics(vertexCnt);
+		vector<vector<unsigned int>> vertexTriangles(vertexCnt);
+
+		for (size_t t = 0; t < triangleCnt; ++t)
+		{
+			glm::vec3 const p0 = getPosition(triangles[t * 3]);
+			glm::vec3 const p1 = getPosition(triangles[t * 3 + 1]);
+			glm::vec3 const p2 = getPosition(triangles[t * 3 + 2]);
+
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float const doubleArea = glm::length(normal);
+
+			for (size_t k = 0; k < 3; ++k) vertexTriangles[triangles[t * 3 + k]].push_back(static_cast<unsigned int>(t));
+
+			if (doubleArea == 0.0f) continue;
+
+			normal /= doubleArea;
+			Quadric const quadric(normal, -glm::dot(normal, p0), doubleArea * 0.5f);
+
+			for (size_t k = 0; k < 3; ++k) quadrics[triangles[t * 3 + k]].add(quadric);
+		}
+
+		auto collapseCost = [&](unsigned int from, unsigned int to)
+		{
+			Quadric quadric = quadrics[from];
+			quadric.add(quadrics[to]);
+
+			double const error = quadric.weight > 0.0 ? max(0.0, quadric.evaluate(getPosition(to))) / quadric.weight : 0.0;
+			return static_cast<float>(sqrt(error));
+		};
+
+		priority_queue<Collapse> collapses;
+
+		auto pushCollapses = [&](unsigned int v0, unsigned int v1)
+		{
+			if (!locked[v0]) collapses.push({ collapseCost(v0, v1), v0, v1 });
+			if (!locked[v1]) collapses.push({ collapseCost(v1, v0), v1, v0 });
+		};
+
+		for (size_t t = 0; t < triangleCnt; ++t)
+		{
+			for (size_t k = 0; k < 3; ++k) pushCollapses(triangles[t * 3 + k], triangles[t * 3 + (k + 1) % 3]);
+		}
+
+		vector<bool> triangleRemoved(triangleCnt, false);
+		vector<bool> vertexRemoved(vertexCnt, false);
+		size_t liveTriangleCnt = triangleCnt;
+
+		while (!collapses.empty() && liveTriangleCnt * 3 > targetIndexCnt)
+		{
+			Collapse collapse = collapses.top();
+			collapses.pop();
+
+			if (vertexRemoved[collapse.from] || vertexRemoved[collapse.to]) continue;
+
+			//quadrics could change since the collapse was queued
+			float const cost = collapseCost(collapse.from, collapse.to);
+			if (cost > collapse.cost)
+			{
+				collapse.cost = cost;
+				collapses.push(collapse);
+				continue;
+			}
+
+			if (cost > targetError) break;
+
+			//edge must still exist and no remaining triangle around collapsed vertex may flip
+			glm::vec3 const newPos = getPosition(collapse.to);
+			bool edgeExists = false;
+			bool flipped = false;
+
+			for (auto t : vertexTriangles[collapse.from])
+			{
+				if (triangleRemoved[t]) continue;
+
+				unsigned int const* tri = &triangles[t * 3];
+				if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+				{
+					edgeExists = true;
+					continue;
+				}
+
+				glm::vec3 const p0 = getPosition(tri[0]);
+				glm::vec3 const p1 = getPosition(tri[1]);
+				glm::vec3 const p2 = getPosition(tri[2]);
+
+				glm::vec3 const q0 = tri[0] == collapse.from ? newPos : p0;
+				glm::vec3 const q1 = tri[1] == collapse.from ? newPos : p1;
+				glm::vec3 const q2 = tri[2] == collapse.from ? newPos : p2;
+
+				glm::vec3 const oldNormal = glm::cross(p1 - p0, p2 - p0);
+				glm::vec3 const newNormal = glm::cross(q1 - q0, q2 - q0);
+
+				if (glm::dot(oldNormal, newNormal) <= 0.25f * glm::length(oldNormal) * glm::length(newNormal))
+				{
+					flipped = true;
+					break;
+				}
+			}
+
+			if (!edgeExists || flipped) continue;
+
+			//apply collapse
+			vertexRemoved[collapse.from] = true;
+			quadrics[collapse.to].add(quadrics[collapse.from]);
+			outError = max(outError, cost);
+
+			for (auto t : vertexTriangles[collapse.from])
+			{
+				if (triangleRemoved[t]) continue;
+
+				unsigned int* tri = &triangles[t * 3];
+				for (size_t k = 0; k < 3; ++k)
+				{
+					if (tri[k] == collapse.from) tri[k] = collapse.to;
+				}
+
+				if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2])
+				{
+					triangleRemoved[t] = true;
+					--liveTriangleCnt;
+				}
+				else
+				{
+					vertexTriangles[collapse.to].push_back(t);
+				}
+			}
+
+			vertexTriangles[collapse.from].clear();
+
+			for (auto t : vertexTriangles[collapse.to])
+			{
+				if (triangleRemoved[t]) continue;
+
+				for (size_t k = 0; k < 3; ++k)
+				{
+					if (triangles[t * 3 + k] != collapse.to) pushCollapses(collapse.to, triangles[t * 3 + k]);
+				}
+			}
+		}
+
+		vector<unsigned int> output;
+		output.reserve(liveTriangleCnt * 3);
+
+		for (size_t t = 0; t < triangleCnt; ++t)
+		{
+			if (!triangleRemoved[t]) output.insert(output.end(), begin(triangles) + t * 3, begin(triangles) + t * 3 + 3);
+		}
+
+		return output;
+	}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+//Quadric error metric simplification (Garland & Heckbert) of indexed triangle lists
+class MeshSimplifier
+{
+public:
+	//Collapses vertices onto their existing neighbours, so output indexes the same vertex buffer as input.
+	//Border vertices and vertices on attribute seams (same position, different vertex) are never moved.
+	//Stops when output has at most targetIndexCnt indices or next collapse would exceed targetError.
+	//positions are tightly packed xyz floats, outError receives RMS distance to original surface in position units
+	static vector<unsigned int> simplify(vector<unsigned int> const& indices, vector<float> const& positions, size_t targetIndexCnt, float targetError, float& outError);
+};
@@ -5,3 +5,32 @@
 
 using namespace std;
 
+
+	vector<Vertex> ModelData::readVertices(size_t meshIdx) const
+	{
+		MeshData const& mesh = meshes[meshIdx];
+
+		vector<uint8_t> data(static_cast<size_t>(mesh.vertices.count) * mesh.vertices.stride);
+		geometryPool->read(mesh.vertices, &data[0]);
+
+		return VertexFormat::decodeVertices(mesh.vertexFormat, &data[0], mesh.vertices.count);
+	}
+
+	vector<uint32_t> ModelData::readIndices(size_t meshIdx) const
+	{
+		MeshData const& mesh = meshes[meshIdx];
+
+		if (mesh.getIndexType() == VK_INDEX_TYPE_UINT16)
+		{
+			vector<uint16_t> indices16(mesh.indices.count);
+			geometryPool->read(mesh.indices, &indices16[0]);
+
+			return vector<uint32_t>(begin(indices16), end(indices16));
+		}
+
+		vector<uint32_t> indices(mesh.indices.count);
+		geometryPool->read(mesh.indices, &indices[0]);
+
+		return indices;
+	}
+
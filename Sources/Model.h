@@ -1,6 +1,9 @@
 #pragma once
 
 #include "MaterialManager.h"
+#include "MeshOptimizer.h"
+#include "VertexFormat.h"
+#include "GeometryPool.h"
 
 #include <vulkan/vulkan.h>
 #include <vector>
@@ -8,18 +11,42 @@
 
 using namespace std;
 
-//Holds Vertex + Index data on GPU and CPU
+//Range of index buffer drawing one level of detail, all levels index the same vertex buffer
+struct MeshLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error; //simplification error in object space units
+};
+
+//Ranges of Vertex + Index data in GeometryPool
 struct MeshData
 {
-	Buffer vertexBuffer;
-	Buffer indexBuffer;
+	GeometryRange vertices;
+	GeometryRange positions; //positions only, for depth only passes
+	GeometryRange indices; //all LODs, 16 bit if vertex count allows it
+	VertexFormatType vertexFormat;
+	PositionFormatType positionFormat;
+	glm::mat4 positionDequantization; //has to be applied to positions values before model matrix
+	glm::vec3 boundsMin; //object space AABB, before position quantization
+	glm::vec3 boundsMax;
+	glm::vec4 boundingSphere; //object space, xyz center of AABB, w radius
+	MeshOptimizationStatistics cacheStatistics;
+	vector<MeshLod> lods; //lods[0] is full detail mesh
 
-	template<typename T> explicit MeshData(VkPhysicalDevice physicalDevice, VkDevice device, vector<T> const& vData, vector<unsigned int> const& iData):
-		vertexBuffer(physicalDevice, device, &vData[0], vData.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT),
-		indexBuffer(physicalDevice, device, &iData[0], iData.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+	VkIndexType getIndexType() const
 	{
+		return indices.stream == GeometryStream::INDEX16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
 	}
 
+	//coarsest level whose projected error stays below pixelThreshold, errorToPixels converts object space error to pixels
+	size_t selectLod(float errorToPixels, float pixelThreshold) const
+	{
+		size_t lod = 0;
+		while (lod + 1 < lods.size() && lods[lod + 1].error * errorToPixels <= pixelThreshold) ++lod;
+
+		return lod;
+	}
 };
 
 struct ModelData
@@ -27,4 +54,9 @@ struct ModelData
 	vector<MeshData> meshes;
 	vector<shared_ptr<const MaterialDescription>> materials;
 	string path;
+	GeometryPool* geometryPool;
+
+	//read back from GPU, for CPU side processing
+	vector<Vertex> readVertices(size_t meshIdx) const;
+	vector<uint32_t> readIndices(size_t meshIdx) const;
 };
\ No newline at end of file
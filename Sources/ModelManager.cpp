@@ -1,11 +1,19 @@
 
 #include "ModelManager.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <glm/glm.hpp>
 
 
-	ModelManager::ModelManager(VkPhysicalDevice physicalDevice, VkDevice device, MaterialManager& materialManager):m_MaterialManager(materialManager)
+	ModelManager::ModelManager(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing, MaterialManager& materialManager, VertexFormatType vertexFormat, PositionFormatType positionFormat):
+		m_MaterialManager(materialManager), m_GeometryPool(physicalDevice, device, stagingRing)
 	{
 		m_PhysicalDevice = physicalDevice;
 		m_Device = device;
+		m_VertexFormat = vertexFormat;
+		m_PositionFormat = positionFormat;
 	}
 
 	ModelManager::~ModelManager()
@@ -13,8 +21,40 @@
 		assert(m_Models.size() == 0 && "ModelManager cannot be destroyed before models are released!");
 	}
 
+	template<typename T> MeshData ModelManager::createMeshData(vector<Vertex> const& vertices, vector<unsigned int> const& indices)
+	{
+		MeshData meshData;
+
+		meshData.vertexFormat = T::s_Type;
+		meshData.vertices = m_GeometryPool.allocate(GeometryStream::VERTEX, VertexFormat::encodeVertices<T>(vertices));
+
+		meshData.positionFormat = m_PositionFormat;
+		if (m_PositionFormat == PositionFormatType::UNORM16)
+		{
+			meshData.positions = m_GeometryPool.allocate(GeometryStream::POSITION, VertexFormat::quantizePositions(vertices, meshData.positionDequantization));
+		}
+		else
+		{
+			meshData.positionDequantization = glm::mat4(1.0f);
+			meshData.positions = m_GeometryPool.allocate(GeometryStream::POSITION, VertexFormat::encodeVertices<PositionFloat>(vertices));
+		}
+
+		if (vertices.size() <= numeric_limits<uint16_t>::max() + 1)
+		{
+			meshData.indices = m_GeometryPool.allocate(GeometryStream::INDEX16, vector<uint16_t>(begin(indices), end(indices)));
+		}
+		else
+		{
+			meshData.indices = m_GeometryPool.allocate(GeometryStream::INDEX32, indices);
+		}
+
+		return meshData;
+	}
+
 	ModelDataSharedPtr ModelManager::loadModel(string const& path)
 	{
+		PROFILE_FUNCTION();
+
 		auto it = m_Models.find(path);
 		if (it != end(m_Models))
 		{
@@ -24,6 +64,7 @@
 		{
 			ModelData* newModel = new ModelData();
 			newModel->path = path;
+			newModel->geometryPool = &m_GeometryPool;
 
 			//determine material file path from obj path (same path just different sufix)
 
@@ -95,18 +136,101 @@
 					vert0.bitangent = vert1.bitangent = vert2.bitangent = bitangent;
 				}
 
-				MeshData meshData(m_PhysicalDevice, m_Device, vertices, mesh.indices);
+				//Reorder triangles for post-transform cache and overdraw, then vertices for fetch locality
+				MeshOptimizationStatistics cacheStatistics;
+				cacheStatistics.before = MeshOptimizer::analyzeVertexCache(mesh.indices, vertices.size());
+				size_t const vertexCntBefore = vertices.size();
+
+				vector<unsigned int> clusters;
+				MeshOptimizer::optimizeVertexCache(mesh.indices, vertices.size(), clusters);
+				cacheStatistics.clusterCnt = MeshOptimizer::optimizeOverdraw(mesh.indices, mesh.vertices, clusters);
+				MeshOptimizer::optimizeVertexFetch(vertices, mesh.indices);
+
+				cacheStatistics.after = MeshOptimizer::analyzeVertexCache(mesh.indices, vertices.size());
+
+				size_t const triangleCnt = mesh.indices.size() / 3;
+				++m_Statistics.meshCnt;
+				m_Statistics.triangleCnt += triangleCnt;
+				m_Statistics.vertexCntBefore += vertexCntBefore;
+				m_Statistics.vertexCntAfter += vertices.size();
+				m_Statistics.transformedCntBefore += static_cast<double>(cacheStatistics.before.acmr) * triangleCnt;
+				m_Statistics.transformedCntAfter += static_cast<double>(cacheStatistics.after.acmr) * triangleCnt;
+				m_Statistics.clusterCnt += cacheStatistics.clusterCnt;
+
+				//Generate LOD chain, every level halves index count and is appended to the same index buffer
+				vector<float> positions;
+				positions.reserve(vertices.size() * 3);
+
+				glm::vec3 minPos(numeric_limits<float>::max());
+				glm::vec3 maxPos(-numeric_limits<float>::max());
+
+				for (auto const& vertex : vertices)
+				{
+					positions.insert(positions.end(), { vertex.pos.x, vertex.pos.y, vertex.pos.z });
+					minPos = glm::min(minPos, vertex.pos);
+					maxPos = glm::max(maxPos, vertex.pos);
+				}
+
+				if (vertices.empty()) minPos = maxPos = glm::vec3(0.0f);
+				float const extent = glm::length(maxPos - minPos);
+
+				//sphere around AABB center is tighter than half of AABB diagonal
+				glm::vec3 const center = (minPos + maxPos) * 0.5f;
+				float radiusSq = 0.0f;
+				for (auto const& vertex : vertices) radiusSq = max(radiusSq, glm::dot(vertex.pos - center, vertex.pos - center));
+
+				vector<MeshLod> lods = { { 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f } };
+				vector<unsigned int> lodIndices = mesh.indices;
+
+				for (size_t level = 1; level < MAX_LOD_CNT; ++level)
+				{
+					float lodError = 0.0f;
+					size_t const targetIndexCnt = (mesh.indices.size() >> level) / 3 * 3;
+					vector<unsigned int> indices = MeshSimplifier::simplify(mesh.indices, positions, targetIndexCnt, extent * LOD_MAX_ERROR, lodError);
+
+					if (indices.empty() || indices.size() > lods.back().indexCount * LOD_MIN_REDUCTION) break;
+
+					MeshOptimizer::optimizeVertexCache(indices, vertices.size(), clusters);
+
+					lods.push_back({ static_cast<uint32_t>(lodIndices.size()), static_cast<uint32_t>(indices.size()), lodError });
+					lodIndices.insert(lodIndices.end(), begin(indices), end(indices));
+				}
+
+				for (size_t level = 0; level < lods.size(); ++level)
+				{
+					++m_Statistics.lodMeshCnt[level];
+					m_Statistics.lodTriangleCnt[level] += lods[level].indexCount / 3;
+					m_Statistics.lodMaxError[level] = max(m_Statistics.lodMaxError[level], lods[level].error);
+				}
+
+				//Encode vertices into GPU vertex format
+				MeshData meshData = m_VertexFormat == VertexFormatType::OCTAHEDRAL ? createMeshData<VertexOct>(vertices, lodIndices)
+					: m_VertexFormat == VertexFormatType::QTANGENT ? createMeshData<VertexQTangent>(vertices, lodIndices)
+					: createMeshData<Vertex>(vertices, lodIndices);
+				meshData.cacheStatistics = cacheStatistics;
+				meshData.lods = move(lods);
+				meshData.boundsMin = minPos;
+				meshData.boundsMax = maxPos;
+				meshData.boundingSphere = glm::vec4(center, sqrt(radiusSq));
 				newModel->meshes.push_back(move(meshData));
 
 				auto materialData = m_MaterialManager.createMaterial(mesh.material, materialDirPath);
 				newModel->materials.push_back(move(materialData));
 			}
 
-			ModelDataSharedPtr sharedPtr(newModel, [this](ModelData* modelData)
+			shared_ptr<ModelData> sharedPtr(newModel, [this](ModelData* modelData)
 				{
 					//remove from database
 					m_Models.erase(modelData->path);
 
+					//free GPU memory once frames in flight which may still draw the model are finished
+					for (auto const& mesh : modelData->meshes)
+					{
+						m_GeometryPool.retire(mesh.vertices);
+						m_GeometryPool.retire(mesh.positions);
+						m_GeometryPool.retire(mesh.indices);
+					}
+
 					//free CPU memory
 					delete modelData;
 				});
@@ -117,3 +241,56 @@
 			return sharedPtr;
 		}
 	}
+
+	bool ModelManager::defragment(VkDeviceSize maxBytes)
+	{
+		vector<GeometryRelocation> relocations = m_GeometryPool.defragment(maxBytes);
+		if (relocations.empty()) return false;
+
+		auto patch = [&relocations](GeometryRange& range)
+		{
+			auto it = find_if(begin(relocations), end(relocations), [&range](GeometryRelocation const& relocation)
+				{
+					return relocation.from.stream == range.stream && relocation.from.block == range.block && relocation.from.offset == range.offset;
+				});
+
+			if (it != end(relocations)) range = it->to;
+		};
+
+		for (auto& model : m_Models)
+		{
+			shared_ptr<ModelData> modelData = model.second.lock();
+			if (!modelData) continue;
+
+			for (auto& mesh : modelData->meshes)
+			{
+				patch(mesh.vertices);
+				patch(mesh.positions);
+				patch(mesh.indices);
+			}
+		}
+
+		return true;
+	}
+
+	float ModelManager::getFragmentation() const
+	{
+		return m_GeometryPool.getFragmentation();
+	}
+
+	void ModelManager::printStatistics() const
+	{
+		Statistics const& s = m_Statistics;
+		double const triangleCnt = static_cast<double>(max<size_t>(s.triangleCnt, 1));
+
+		cout << "Meshes: " << s.meshCnt << ", triangles: " << s.triangleCnt << ", vertices: " << s.vertexCntAfter << endl;
+		cout << "  ACMR " << s.transformedCntBefore / triangleCnt << " -> " << s.transformedCntAfter / triangleCnt
+			<< ", ATVR " << s.transformedCntBefore / max<size_t>(s.vertexCntBefore, 1) << " -> " << s.transformedCntAfter / max<size_t>(s.vertexCntAfter, 1)
+			<< ", clusters " << s.clusterCnt << endl;
+
+		for (size_t level = 0; level < MAX_LOD_CNT && s.lodMeshCnt[level] > 0; ++level)
+		{
+			cout << "  LOD " << level << ": " << s.lodMeshCnt[level] << " meshes, " << s.lodTriangleCnt[level] << " triangles, max error " << s.lodMaxError[level] << endl;
+		}
+		cout << "  geometry pool fragmentation: " << getFragmentation() << endl;
+	}
@@ -3,7 +3,10 @@
 #include "Model.h"
 #include "ModelLoader.h"
 #include "VertexFormat.h"
+#include "MeshSimplifier.h"
+#include "GeometryPool.h"
 
+#include <array>
 #include <memory>
 #include <assert.h>
 #include <unordered_map>
@@ -14,14 +17,48 @@ using ModelDataSharedPtr = shared_ptr<const ModelData>;
 class ModelManager
 {
 public:
-	ModelManager(VkPhysicalDevice physicalDevice, VkDevice device, MaterialManager& materialManager);
+	ModelManager(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing, MaterialManager& materialManager, VertexFormatType vertexFormat = VertexFormatType::FULL, PositionFormatType positionFormat = PositionFormatType::FLOAT);
 	~ModelManager();
 	ModelDataSharedPtr loadModel(string const& path);
 
+	//incremental compaction of geometry pool, call once per frame before recording command buffers
+	//returns true when ranges of meshes were moved (copies of ranges, e.g. GpuDrivenRenderer, have to be rebuilt)
+	bool defragment(VkDeviceSize maxBytes = DEFRAG_BYTES_PER_FRAME);
+	float getFragmentation() const;
+
+	//aggregated over all loaded meshes, printed once after scene is loaded
+	void printStatistics() const;
+
+	static const VkDeviceSize DEFRAG_BYTES_PER_FRAME = 4 * 1024 * 1024;
+
 private:
+	template<typename T> MeshData createMeshData(vector<Vertex> const& vertices, vector<unsigned int> const& indices);
+
+	static const size_t MAX_LOD_CNT = 4;
+	static constexpr float LOD_MAX_ERROR = 0.05f; //relative to mesh extent
+	static constexpr float LOD_MIN_REDUCTION = 0.8f; //next level has to have at most this fraction of previous level indices
+
+	struct Statistics
+	{
+		size_t meshCnt = 0;
+		size_t triangleCnt = 0;
+		size_t vertexCntBefore = 0; //vertex fetch optimization removes unreferenced vertices
+		size_t vertexCntAfter = 0;
+		double transformedCntBefore = 0.0; //post-transform cache misses, ACMR * triangles
+		double transformedCntAfter = 0.0;
+		size_t clusterCnt = 0;
+		array<size_t, MAX_LOD_CNT> lodMeshCnt = {}; //meshes which have the level
+		array<size_t, MAX_LOD_CNT> lodTriangleCnt = {};
+		array<float, MAX_LOD_CNT> lodMaxError = {};
+	};
+
 	MaterialManager& m_MaterialManager;
 
-	unordered_map<string, weak_ptr <const ModelData> > m_Models;
+	unordered_map<string, weak_ptr <ModelData> > m_Models; //non const, ranges are patched by defragmentation
 	VkPhysicalDevice m_PhysicalDevice;
 	VkDevice m_Device;
+	GeometryPool m_GeometryPool;
+	VertexFormatType m_VertexFormat;
+	PositionFormatType m_PositionFormat;
+	Statistics m_Statistics;
 };
\ No newline at end of file
@@ -0,0 +1,175 @@
+
+#include "ParallelRecorder.h"
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <assert.h>
+
+using namespace std;
+
+
+	ParallelRecorder::ParallelRecorder(VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t threadCnt) : m_Device(device)
+	{
+		m_ThreadCnt = threadCnt != 0 ? threadCnt : max(1u, thread::hardware_concurrency());
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilyIndex;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT; //whole pool is reset per frame
+
+		m_Pools.resize(framesInFlight);
+		for (auto& framePools : m_Pools)
+		{
+			framePools.resize(m_ThreadCnt);
+			for (auto& pool : framePools)
+			{
+				auto res = vkCreateCommandPool(m_Device, &poolInfo, nullptr, &pool.commandPool);
+				assert(res == VK_SUCCESS);
+				pool.usedCnt = 0;
+			}
+		}
+
+		for (uint32_t i = 1; i < m_ThreadCnt; ++i)
+			m_Workers.emplace_back(&ParallelRecorder::workerLoop, this, i);
+	}
+
+	ParallelRecorder::~ParallelRecorder()
+	{
+		{
+			lock_guard<mutex> lock(m_Mutex);
+			m_Exit = true;
+		}
+		m_JobCondition.notify_all();
+
+		for (auto& worker : m_Workers) worker.join();
+
+		for (auto& framePools : m_Pools)
+			for (auto& pool : framePools)
+				vkDestroyCommandPool(m_Device, pool.commandPool, nullptr);
+	}
+
+	uint32_t ParallelRecorder::getThreadCnt() const
+	{
+		return m_ThreadCnt;
+	}
+
+	void ParallelRecorder::beginFrame(uint32_t frameIdx)
+	{
+		m_FrameIdx = frameIdx;
+
+		for (auto& pool : m_Pools[m_FrameIdx])
+		{
+			if (pool.usedCnt == 0) continue;
+
+			auto res = vkResetCommandPool(m_Device, pool.commandPool, 0);
+			assert(res == VK_SUCCESS);
+			pool.usedCnt = 0;
+		}
+	}
+
+	void ParallelRecorder::record(VkCommandBuffer primaryCommandBuffer, VkRenderPass renderPass, uint32_t subpass, VkFramebuffer framebuffer, uint32_t threadCnt,
+		function<void(VkCommandBuffer, uint32_t)> const& func)
+	{
+		threadCnt = max(1u, min(threadCnt, m_ThreadCnt));
+
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = subpass;
+		inheritanceInfo.framebuffer = framebuffer;
+
+		vector<VkCommandBuffer> commandBuffers(threadCnt);
+
+		function<void(uint32_t)> const job = [&](uint32_t threadIdx)
+		{
+			VkCommandBuffer commandBuffer = getCommandBuffer(threadIdx);
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+			auto res = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+			assert(res == VK_SUCCESS);
+
+			func(commandBuffer, threadIdx);
+
+			res = vkEndCommandBuffer(commandBuffer);
+			assert(res == VK_SUCCESS);
+
+			commandBuffers[threadIdx] = commandBuffer;
+		};
+
+		{
+			lock_guard<mutex> lock(m_Mutex);
+			m_Job = &job;
+			m_JobThreadCnt = threadCnt;
+			m_PendingCnt = threadCnt - 1;
+			++m_JobId;
+		}
+		m_JobCondition.notify_all();
+
+		job(0);
+
+		{
+			unique_lock<mutex> lock(m_Mutex);
+			m_DoneCondition.wait(lock, [this]() { return m_PendingCnt == 0; });
+			m_Job = nullptr;
+		}
+
+		vkCmdExecuteCommands(primaryCommandBuffer, threadCnt, &commandBuffers[0]);
+	}
+
+	VkCommandBuffer ParallelRecorder::getCommandBuffer(uint32_t threadIdx)
+	{
+		//pool is touched by its thread only
+		ThreadCommandPool& pool = m_Pools[m_FrameIdx][threadIdx];
+
+		if (pool.usedCnt == pool.commandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = pool.commandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			auto res = vkAllocateCommandBuffers(m_Device, &allocInfo, &commandBuffer);
+			assert(res == VK_SUCCESS);
+
+			pool.commandBuffers.push_back(commandBuffer);
+		}
+
+		return pool.commandBuffers[pool.usedCnt++];
+	}
+
+	void ParallelRecorder::workerLoop(uint32_t threadIdx)
+	{
+		PROFILE_THREAD_NAME("recorder " + to_string(threadIdx));
+
+		uint64_t lastJobId = 0;
+
+		for (;;)
+		{
+			function<void(uint32_t)> const* job;
+			{
+				unique_lock<mutex> lock(m_Mutex);
+				m_JobCondition.wait(lock, [this, lastJobId]() { return m_Exit || m_JobId != lastJobId; });
+
+				if (m_Exit) return;
+
+				lastJobId = m_JobId;
+				if (threadIdx >= m_JobThreadCnt) continue; //job does not need this thread
+
+				job = m_Job;
+			}
+
+			(*job)(threadIdx);
+
+			{
+				lock_guard<mutex> lock(m_Mutex);
+				--m_PendingCnt;
+			}
+			m_DoneCondition.notify_one();
+		}
+	}
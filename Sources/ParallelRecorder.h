@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//Records parts of render pass on worker threads into secondary command buffers, which are executed by primary command buffer.
+//Every thread has own command pool per frame in flight, pools of frame are reset once its fence was waited (beginFrame).
+class ParallelRecorder
+{
+public:
+	//threadCnt 0 - one thread per core, calling thread is used as thread 0
+	ParallelRecorder(VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t threadCnt = 0);
+	~ParallelRecorder();
+	ParallelRecorder(ParallelRecorder const&) = delete;
+	ParallelRecorder& operator=(ParallelRecorder const&) = delete;
+
+	uint32_t getThreadCnt() const;
+
+	//command buffers recorded in frame slot before were executed by GPU, called by VulcanInstance::drawFrame
+	void beginFrame(uint32_t frameIdx);
+
+	//func(commandBuffer, threadIdx) is called once on each of threadCnt threads and returns when all are done
+	//render pass has to be begun in primary command buffer with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+	void record(VkCommandBuffer primaryCommandBuffer, VkRenderPass renderPass, uint32_t subpass, VkFramebuffer framebuffer, uint32_t threadCnt,
+		function<void(VkCommandBuffer, uint32_t)> const& func);
+
+private:
+	struct ThreadCommandPool
+	{
+		VkCommandPool commandPool;
+		vector<VkCommandBuffer> commandBuffers; //allocated on demand, reused every frame
+		size_t usedCnt;
+	};
+
+	VkCommandBuffer getCommandBuffer(uint32_t threadIdx);
+	void workerLoop(uint32_t threadIdx);
+
+	VkDevice m_Device;
+	uint32_t m_ThreadCnt;
+	uint32_t m_FrameIdx = 0;
+	vector<vector<ThreadCommandPool>> m_Pools; //per frame in flight, per thread
+
+	vector<thread> m_Workers; //threads 1 .. m_ThreadCnt - 1
+	mutex m_Mutex;
+	condition_variable m_JobCondition;
+	condition_variable m_DoneCondition;
+	function<void(uint32_t)> const* m_Job = nullptr;
+	uint64_t m_JobId = 0;
+	uint32_t m_JobThreadCnt = 0;
+	uint32_t m_PendingCnt = 0;
+	bool m_Exit = false;
+};
@@ -8,15 +8,17 @@
 	{
 		vector<Particle2> particles;
 
-		vector<Vertex> vertices(modelDataSharedPtr->meshes[i].vertexBuffer.count);
-		vector<uint32_t> indices(modelDataSharedPtr->meshes[i].indexBuffer.count);
+		MeshData const& mesh = modelDataSharedPtr->meshes[i];
 
-		modelDataSharedPtr->meshes[i].vertexBuffer.copyBuffer(&vertices[0]);
-		modelDataSharedPtr->meshes[i].indexBuffer.copyBuffer(&indices[0]);
+		vector<Vertex> vertices = modelDataSharedPtr->readVertices(i);
+		vector<uint32_t> indices = modelDataSharedPtr->readIndices(i);
 
 		glm::vec3 centerOfGravity = glm::vec3(0.0f);
 		float totalMass = 0.0f;
 
+		//only full detail LOD
+		indices.resize(mesh.lods[0].indexCount);
+
 		for (uint32_t ind = 0; ind < indices.size(); ind += 3)
 		{
 			Particle2 particle;
@@ -59,29 +61,48 @@
 	}
 
 	
-	ParticleComponent::ParticleComponent(VkPhysicalDevice physicalDevice, VkDevice device, ModelDataSharedPtr& modelDataSharedPtr, glm::vec3 const& centerOfGravityOffset, ParticleRendererData const &particleRendererData)
+	ParticleComponent::ParticleComponent(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing, ModelDataSharedPtr& modelDataSharedPtr, glm::vec3 const& centerOfGravityOffset, ParticleRendererData const &particleRendererData):m_StagingRing(stagingRing)
 	{
 		for (size_t i = 0; i < modelDataSharedPtr->meshes.size(); ++i)
 		{
 			auto particles = loadParticles(i, modelDataSharedPtr, centerOfGravityOffset);
 
-			Buffer particleBuffer(physicalDevice, device, &particles[0], particles.size(), (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT));
+			vector<Buffer> particleBuffers;
+			vector<DescriptorSet> particleSetsCompute;
+			vector<DescriptorSet> particleSets;
+
+			for (size_t j = 0; j < ParticleRendererData::PARTICLE_BUFFER_CNT; ++j)
+			{
+				particleBuffers.emplace_back(physicalDevice, device, stagingRing, &particles[0], particles.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+			}
+
+			for (size_t j = 0; j < ParticleRendererData::PARTICLE_BUFFER_CNT; ++j)
+			{
+				DescriptorSet particleSetCompute(particleRendererData.m_ParticleSetLayoutCompute);
+				particleSetCompute.createDescriptorSet();
+
+				particleSetCompute.setStorage("particlesIn", particleBuffers[j]);
+				particleSetCompute.setStorage("particlesOut", particleBuffers[(j + 1) % ParticleRendererData::PARTICLE_BUFFER_CNT]);
+				particleSetCompute.update();
 
-			DescriptorSet particleSetCompute(particleRendererData.m_ParticleSetLayoutCompute);
-			particleSetCompute.createDescriptorSet();
+				particleSetsCompute.push_back(move(particleSetCompute));
 
-			particleSetCompute.setStorage("particles", particleBuffer);
-			
 
-			DescriptorSet particleSet(particleRendererData.m_ParticleSetLayout);
-			particleSet.createDescriptorSet();
+				DescriptorSet particleSet(particleRendererData.m_ParticleSetLayout);
+				particleSet.createDescriptorSet();
 
-			particleSet.setSampler("texture", modelDataSharedPtr->materials[0]->m_DiffuseTexture->imageView, particleRendererData.m_sampler.m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-			particleSet.setStorage("particles", particleBuffer);
-			
+				particleSet.setSampler("texture", modelDataSharedPtr->materials[0]->m_DiffuseTexture->imageView, particleRendererData.m_sampler.m_Sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+				particleSet.setStorage("particles", particleBuffers[j]);
+				particleSet.update();
 
-			m_ParticleGroups.emplace_back(move(particleSet), move(particleSetCompute), modelDataSharedPtr->materials[i]->m_DiffuseTexture, move(particleBuffer));
+				particleSets.push_back(move(particleSet));
+			}
+
+			m_ParticleGroups.emplace_back(move(particleSets), move(particleSetsCompute), modelDataSharedPtr->materials[i]->m_DiffuseTexture, move(particleBuffers));
 		}
+
+		//particles are simulated on compute queue, which is not ordered with staging ring submissions
+		m_StagingRing.finish();
 	}
 
 	void ParticleComponent::reset(ParticleComponent& particleComp, ModelDataSharedPtr& modelDataSharedPtr, glm::vec3 const& centerOfGravityOffset)
@@ -89,6 +110,8 @@
 		for (size_t i = 0; i < modelDataSharedPtr->meshes.size(); ++i)
 		{
 			auto particles = loadParticles(i, modelDataSharedPtr, centerOfGravityOffset);
-			particleComp.m_ParticleGroups[i].m_Particles.updateBuffer(&particles[0]);
+			for (auto& particleBuffer : particleComp.m_ParticleGroups[i].m_Particles) particleBuffer.updateBuffer(m_StagingRing, &particles[0]);
 		}
+
+		m_StagingRing.finish();
 	}
@@ -23,15 +23,16 @@ struct Particle2
 };
 
 
+//particles are simulated ping-pong, compute of next frame writes one buffer while current frame renders the other
 struct ParticleGroup
 {
-	DescriptorSet m_DescriptorSet;
-	DescriptorSet m_DescriptorSetCompute;
+	vector<DescriptorSet> m_DescriptorSets; //[i] renders m_Particles[i]
+	vector<DescriptorSet> m_DescriptorSetsCompute; //[i] reads m_Particles[i] and writes the other buffer
 	shared_ptr<const TextureData> m_Texture;
-	Buffer m_Particles;
+	vector<Buffer> m_Particles;
 
-	ParticleGroup(DescriptorSet&& descriptorSet, DescriptorSet&& descriptorSetCompute, shared_ptr<const TextureData> texture, Buffer&& buffer) :
-		m_DescriptorSet(move(descriptorSet)), m_DescriptorSetCompute(move(descriptorSetCompute)), m_Texture(move(texture)), m_Particles(move(buffer))
+	ParticleGroup(vector<DescriptorSet>&& descriptorSets, vector<DescriptorSet>&& descriptorSetsCompute, shared_ptr<const TextureData> texture, vector<Buffer>&& buffers) :
+		m_DescriptorSets(move(descriptorSets)), m_DescriptorSetsCompute(move(descriptorSetsCompute)), m_Texture(move(texture)), m_Particles(move(buffers))
 	{};
 };
 
@@ -41,7 +42,8 @@ class ParticleComponent : public IComponent
 {
 public:
 
-	ParticleComponent(VkPhysicalDevice physicalDevice, VkDevice device, ModelDataSharedPtr& modelDataSharedPtr, glm::vec3 const& centerOfGravityOffset, ParticleRendererData const& particleRendererData);
+	ParticleComponent(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing, ModelDataSharedPtr& modelDataSharedPtr, glm::vec3 const& centerOfGravityOffset, ParticleRendererData const& particleRendererData);
+	//overwrites both particle buffers, GPU must not use them anymore (compute of next frame is not ordered with uploads)
 	void reset(ParticleComponent& particleComp, ModelDataSharedPtr& modelDataSharedPtr, glm::vec3 const& centerOfGravityOffset);
 
 
@@ -58,5 +60,7 @@ public:
 	vector<ParticleGroup> m_ParticleGroups;
 
 private:
+	StagingRing& m_StagingRing;
+
 	static vector<Particle2> loadParticles(size_t i, ModelDataSharedPtr& modelDataSharedPtr, glm::vec3 const& centerOfGravityOffset);
 };
\ No newline at end of file
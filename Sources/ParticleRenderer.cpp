@@ -2,57 +2,85 @@
 
 #include "ParticleRenderer.h"
 #include "ParticleComponent.h"
+#include "CpuProfiler.h"
 
 
-	ParticleRenderer::ParticleRenderer(VkPhysicalDevice physicalDevice, VkDevice device, VkRenderPass renderPass, int computeQueueIndex) : m_ParticleRendererData(device)
+	ParticleRenderer::ParticleRenderer(VkPhysicalDevice physicalDevice, VkDevice device, VkRenderPass renderPass, ComputeScheduler& computeScheduler, GpuProfiler& gpuProfiler) : m_ComputeScheduler(computeScheduler), m_GpuProfiler(gpuProfiler), m_ParticleRendererData(device)
 	{
+		m_SimulationScope = m_GpuProfiler.createScope("particle simulation");
 		m_Device = device;
 		m_RenderPass = renderPass;
-		createComputePipeline(physicalDevice, device, computeQueueIndex);
-		createRenderPipeline(physicalDevice, device, renderPass);
+
+		//graphics pipeline compiles on worker thread while compute pipeline is created, pipeline cache is internally synchronized
+		auto renderPipelineJob = async(launch::async, [this, physicalDevice, device, renderPass]()
+			{
+				createRenderPipeline(physicalDevice, device, renderPass);
+			});
+
+		createComputePipeline(physicalDevice, device);
+		renderPipelineJob.get();
+	}
+
+	void ParticleRenderer::setParticleComponents(vector< ParticleComponent*> const& particleComponents)
+	{
+		m_ParticleComponents = particleComponents;
 	}
 
-	void ParticleRenderer::recordComputeCommand(vector< ParticleComponent*> const& particleComponents)
+	void ParticleRenderer::recordComputeCommand(VkCommandBuffer commandBuffer, uint32_t i)
 	{
 		VkCommandBufferBeginInfo cmdBufferBeginInfo{};
 		cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		cmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-		auto res = vkBeginCommandBuffer(m_ComputeCommandBuffer, &cmdBufferBeginInfo);
+		auto res = vkBeginCommandBuffer(commandBuffer, &cmdBufferBeginInfo);
 		assert(VK_SUCCESS == res);
 
+		//previous simulation in queue wrote input and read output of this one, semaphores order only compute with graphics
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
 
-		vkCmdBindPipeline(m_ComputeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
 
-		for (ParticleComponent const* particleComp : particleComponents)
 		{
-			for (auto& group : particleComp->m_ParticleGroups)
+			GpuScope gpuScope(m_GpuProfiler, commandBuffer, m_SimulationScope);
+
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline);
+
+			for (ParticleComponent const* particleComp : m_ParticleComponents)
 			{
-				auto const& descriptorSet = group.m_DescriptorSetCompute.getDescriptorSet();
-				vkCmdBindDescriptorSets(m_ComputeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayoutCompute, 0, 1, &descriptorSet, 0, 0);
-				vkCmdDispatch(m_ComputeCommandBuffer, group.m_Particles.count / ParticleRendererData::PARTICLE_CNT_PER_GROUP, 1, 1);
+				for (auto& group : particleComp->m_ParticleGroups)
+				{
+					auto const& descriptorSet = group.m_DescriptorSetsCompute[i].getDescriptorSet();
+					vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayoutCompute, 0, 1, &descriptorSet, 0, 0);
+					vkCmdDispatch(commandBuffer, group.m_Particles[i].count / ParticleRendererData::PARTICLE_CNT_PER_GROUP, 1, 1);
+				}
 			}
 		}
 
-		vkEndCommandBuffer(m_ComputeCommandBuffer);
+		vkEndCommandBuffer(commandBuffer);
 	}
 
 	void ParticleRenderer::submitComputeCommand()
 	{
-		VkSubmitInfo submitInfo{};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_ComputeCommandBuffer;
-
-		vkQueueSubmit(m_Queue, 1, &submitInfo, m_Fence);
-		vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, UINT64_MAX);
-		vkResetFences(m_Device, 1, &m_Fence);
+		PROFILE_FUNCTION();
+
+		//command buffer of frame slot was submitted COMMAND_BUFFER_CNT frames ago, that frame's fence was waited in drawFrame
+		VkCommandBuffer commandBuffer = m_ComputeCommandBuffers[m_CommandBufferIdx];
+		recordComputeCommand(commandBuffer, m_CurrentBuffer);
+		m_ComputeScheduler.submit(commandBuffer, ParticleRendererData::PARTICLE_BUFFER_CNT);
+
+		m_CurrentBuffer = (m_CurrentBuffer + 1) % ParticleRendererData::PARTICLE_BUFFER_CNT;
+		m_CommandBufferIdx = (m_CommandBufferIdx + 1) % COMMAND_BUFFER_CNT;
 	}
 
 
-	void ParticleRenderer::createComputePipeline(VkPhysicalDevice physicalDevice, VkDevice device, int computeQueueIndex)
+	void ParticleRenderer::createComputePipeline(VkPhysicalDevice physicalDevice, VkDevice device)
 	{
 		m_ParticleRendererData.m_ParticleSetLayoutCompute = make_shared< DescriptorSetLayout>(device);
-		m_ParticleRendererData.m_ParticleSetLayoutCompute->addDescriptor("particles", 0, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		m_ParticleRendererData.m_ParticleSetLayoutCompute->addDescriptor("particlesIn", 0, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		m_ParticleRendererData.m_ParticleSetLayoutCompute->addDescriptor("particlesOut", 1, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
 		m_ParticleRendererData.m_ParticleSetLayoutCompute->createDescriptorSetLayout();
 
 		// Create pipeline		
@@ -70,7 +98,7 @@
 		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
 		shaderStage.pName = "main"; // todo : make param
-		VulkanHelpers::createShaderModuleFromFile("./../Shaders/particleCompute.spv", device, shaderStage.module);
+		shaderStage.module = PipelineRegistry::get(device).getShaderModule("./../Shaders/particleCompute.spv");
 
 		VkComputePipelineCreateInfo computePipelineCreateInfo{};
 		computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
@@ -78,42 +106,10 @@
 		computePipelineCreateInfo.flags = 0;
 		computePipelineCreateInfo.stage = shaderStage;
 
-		VkCommandPool commandPool;
-
-		// Separate command pool as queue family for compute may be different than graphics
-		VkCommandPoolCreateInfo cmdPoolInfo = {};
-		cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		cmdPoolInfo.queueFamilyIndex = computeQueueIndex; // vulcanInstance.getQueueFamilyIndex(VK_QUEUE_COMPUTE_BIT);
-		cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		m_ComputeCommandBuffers = m_ComputeScheduler.allocateCommandBuffers(COMMAND_BUFFER_CNT);
 
-		res = vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &commandPool);
+		res = vkCreateComputePipelines(device, PipelineCache::get(device).getCache(), 1, &computePipelineCreateInfo, nullptr, &m_ComputePipeline);
 		assert(VK_SUCCESS == res);
-
-		vkGetDeviceQueue(device, computeQueueIndex /*vulcanInstance.getQueueFamilyIndex(VK_QUEUE_COMPUTE_BIT)*/, 0, &m_Queue);
-
-		// Fence for compute CB sync
-
-		VkFenceCreateInfo fenceCreateInfo{};
-		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-		res = vkCreateFence(device, &fenceCreateInfo, nullptr, &m_Fence);
-		assert(VK_SUCCESS == res);
-
-		// Create a command buffer for compute operations
-
-		VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
-		commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		commandBufferAllocateInfo.commandPool = commandPool;
-		commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		commandBufferAllocateInfo.commandBufferCount = 1;
-
-		res = vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &m_ComputeCommandBuffer);
-		assert(VK_SUCCESS == res);
-
-		res = vkCreateComputePipelines(device, nullptr, 1, &computePipelineCreateInfo, nullptr, &m_ComputePipeline);
-		assert(VK_SUCCESS == res);
-
-		vkResetFences(device, 1, &m_Fence);
 	}
 
 
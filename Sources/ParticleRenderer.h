@@ -2,7 +2,10 @@
 #include "VulkanHelper.h"
 #include "MaterialManager.h"
 #include "Model.h"
+#include "ComputeScheduler.h"
+#include "GpuProfiler.h"
 #include <memory>
+#include <future>
 
 using namespace std;
 
@@ -14,6 +17,7 @@ struct ParticleRendererData
 	shared_ptr<DescriptorSetLayout> m_ParticleSetLayout;
 	shared_ptr<DescriptorSetLayout> m_ParticleSetLayoutCompute;
 	static const int PARTICLE_CNT_PER_GROUP = 4;
+	static const int PARTICLE_BUFFER_CNT = 2; //ping-pong
 };
 
 class ParticleComponent;
@@ -26,21 +30,32 @@ public:
 	VkPipeline m_ParticleRenderPipeline;
 	
 	VkPipeline m_ComputePipeline;
-	VkCommandBuffer m_ComputeCommandBuffer;
-	VkFence m_Fence;
-	VkQueue m_Queue;
+	static const uint32_t COMMAND_BUFFER_CNT = 3; //one per frame in flight, VulcanInstance::MAX_FRAMES_IN_FLIGHT
+	vector<VkCommandBuffer> m_ComputeCommandBuffers; //rerecorded every frame, GPU profiler scopes belong to frame slot
+	uint32_t m_CommandBufferIdx = 0; //frame slot
+	vector<ParticleComponent*> m_ParticleComponents;
+	uint32_t m_CurrentBuffer = 0; //particle buffer with results of last submitted simulation, rendered by current frame
+	ComputeScheduler& m_ComputeScheduler;
+	GpuProfiler& m_GpuProfiler;
+	uint32_t m_SimulationScope;
 	VkDevice m_Device;
 	VkRenderPass m_RenderPass;
 
 	ParticleRendererData m_ParticleRendererData;
 
-	ParticleRenderer(VkPhysicalDevice physicalDevice, VkDevice device, VkRenderPass renderPass, int computeQueueIndex);
+	ParticleRenderer(VkPhysicalDevice physicalDevice, VkDevice device, VkRenderPass renderPass, ComputeScheduler& computeScheduler, GpuProfiler& gpuProfiler);
 
-	void recordComputeCommand(vector< ParticleComponent*> const& particleComponents);
+	//components simulated by every following submitComputeCommand
+	void setParticleComponents(vector< ParticleComponent*> const& particleComponents);
+
+	//simulation of frame which is recorded, has to be called from drawFrame callback, CPU never waits
 	void submitComputeCommand();
 
 private:
 
-	void createComputePipeline(VkPhysicalDevice physicalDevice, VkDevice device, int computeQueueIndex);
+	//simulates from particle buffer i
+	void recordComputeCommand(VkCommandBuffer commandBuffer, uint32_t i);
+
+	void createComputePipeline(VkPhysicalDevice physicalDevice, VkDevice device);
 	void createRenderPipeline(VkPhysicalDevice physicalDevice, VkDevice device, VkRenderPass renderPass);
 };
\ No newline at end of file
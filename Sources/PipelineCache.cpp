@@ -0,0 +1,103 @@
+
+#include "PipelineCache.h"
+
+#include <assert.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+unordered_map<VkDevice, PipelineCache*> PipelineCache::s_Caches;
+
+
+	PipelineCache::PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, string const& filePath) : m_Device(device), m_FilePath(filePath)
+	{
+		assert(s_Caches.count(m_Device) == 0 && "Only one PipelineCache per device!");
+		s_Caches[m_Device] = this;
+
+		vkGetPhysicalDeviceProperties(physicalDevice, &m_Properties);
+
+		vector<char> data;
+		{
+			ifstream file(m_FilePath, ios::ate | ios::binary);
+			if (file.is_open())
+			{
+				data.resize(static_cast<size_t>(file.tellg()));
+				file.seekg(0);
+				file.read(data.data(), data.size());
+			}
+		}
+
+		if (!data.empty() && !validateHeader(data))
+		{
+			cout << "Pipeline cache " << m_FilePath << " was created by other driver or device, it is ignored" << endl;
+			data.clear();
+		}
+
+		VkPipelineCacheCreateInfo cacheInfo = {};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = data.size();
+		cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+		auto res = vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_Cache);
+		assert(res == VK_SUCCESS);
+
+		cout << "Pipeline cache: " << data.size() << " bytes loaded" << endl;
+	}
+
+	PipelineCache::~PipelineCache()
+	{
+		save();
+
+		vkDestroyPipelineCache(m_Device, m_Cache, nullptr);
+		s_Caches.erase(m_Device);
+	}
+
+	PipelineCache& PipelineCache::get(VkDevice device)
+	{
+		auto it = s_Caches.find(device);
+		assert(it != end(s_Caches) && "No PipelineCache created for device!");
+
+		return *it->second;
+	}
+
+	VkPipelineCache PipelineCache::getCache() const
+	{
+		return m_Cache;
+	}
+
+	void PipelineCache::save() const
+	{
+		size_t size = 0;
+		auto res = vkGetPipelineCacheData(m_Device, m_Cache, &size, nullptr);
+		assert(res == VK_SUCCESS);
+
+		vector<char> data(size);
+		res = vkGetPipelineCacheData(m_Device, m_Cache, &size, data.data());
+		assert(res == VK_SUCCESS);
+
+		ofstream file(m_FilePath, ios::binary | ios::trunc);
+		if (!file.is_open())
+		{
+			cout << "Pipeline cache " << m_FilePath << " can't be written" << endl;
+			return;
+		}
+
+		file.write(data.data(), size);
+	}
+
+	bool PipelineCache::validateHeader(vector<char> const& data) const
+	{
+		//VkPipelineCacheHeaderVersionOne: headerSize, headerVersion, vendorID, deviceID, pipelineCacheUUID
+		size_t const headerSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+		if (data.size() < headerSize) return false;
+
+		uint32_t header[4];
+		memcpy(header, data.data(), sizeof(header));
+
+		return header[0] >= headerSize && header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			header[2] == m_Properties.vendorID && header[3] == m_Properties.deviceID &&
+			memcmp(data.data() + sizeof(header), m_Properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
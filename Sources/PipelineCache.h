@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//VkPipelineCache loaded from disk on start and saved on shutdown, file from other driver / device is ignored.
+//Cache is internally synchronized, so pipelines can be created from worker threads.
+class PipelineCache
+{
+public:
+	PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, string const& filePath);
+	~PipelineCache();
+	PipelineCache(PipelineCache const&) = delete;
+	PipelineCache& operator=(PipelineCache const&) = delete;
+
+	//cache registered for device, VulkanHelpers only know VkDevice
+	static PipelineCache& get(VkDevice device);
+
+	VkPipelineCache getCache() const;
+	void save() const;
+
+private:
+	bool validateHeader(vector<char> const& data) const;
+
+	VkDevice m_Device;
+	VkPhysicalDeviceProperties m_Properties;
+	VkPipelineCache m_Cache = VK_NULL_HANDLE;
+	string m_FilePath;
+
+	static unordered_map<VkDevice, PipelineCache*> s_Caches;
+};
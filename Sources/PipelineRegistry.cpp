@@ -0,0 +1,118 @@
+
+#include "PipelineRegistry.h"
+#include "VulkanHelper.h"
+
+#include <assert.h>
+#include <iostream>
+
+using namespace std;
+
+unordered_map<VkDevice, PipelineRegistry*> PipelineRegistry::s_Registries;
+
+
+	PipelineRegistry::PipelineRegistry(VkDevice device) : m_Device(device)
+	{
+		assert(s_Registries.count(m_Device) == 0 && "Only one PipelineRegistry per device!");
+		s_Registries[m_Device] = this;
+	}
+
+	PipelineRegistry::~PipelineRegistry()
+	{
+		for (auto& pipeline : m_Pipelines) vkDestroyPipeline(m_Device, pipeline.second, nullptr);
+		for (auto& pipelineLayout : m_PipelineLayouts) vkDestroyPipelineLayout(m_Device, pipelineLayout.second, nullptr);
+		for (auto& shaderModule : m_ShaderModules) vkDestroyShaderModule(m_Device, shaderModule.second, nullptr);
+
+		s_Registries.erase(m_Device);
+	}
+
+	PipelineRegistry& PipelineRegistry::get(VkDevice device)
+	{
+		auto it = s_Registries.find(device);
+		assert(it != end(s_Registries) && "No PipelineRegistry created for device!");
+
+		return *it->second;
+	}
+
+	VkShaderModule PipelineRegistry::getShaderModule(string const& filePath)
+	{
+		lock_guard<mutex> lock(m_Mutex);
+
+		auto it = m_ShaderModules.find(filePath);
+		if (it != end(m_ShaderModules)) return it->second;
+
+		VkShaderModule shaderModule;
+		VulkanHelpers::createShaderModuleFromFile(filePath.c_str(), m_Device, shaderModule);
+		m_ShaderModules[filePath] = shaderModule;
+
+		return shaderModule;
+	}
+
+	VkPipelineLayout PipelineRegistry::getPipelineLayout(vector<VkDescriptorSetLayout> const& descriptorSetLayouts, vector<VkPushConstantRange> const& pushConstants)
+	{
+		string key;
+		appendKey(key, descriptorSetLayouts.data(), descriptorSetLayouts.size());
+		appendKey(key, pushConstants.data(), pushConstants.size());
+
+		lock_guard<mutex> lock(m_Mutex);
+
+		auto it = m_PipelineLayouts.find(key);
+		if (it != end(m_PipelineLayouts)) return it->second;
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+		if (!descriptorSetLayouts.empty())
+		{
+			pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+			pipelineLayoutInfo.pSetLayouts = &descriptorSetLayouts[0];
+		}
+
+		if (!pushConstants.empty())
+		{
+			pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstants.size());
+			pipelineLayoutInfo.pPushConstantRanges = &pushConstants[0];
+		}
+
+		VkPipelineLayout pipelineLayout;
+		auto res = vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+		assert(VK_SUCCESS == res);
+
+		m_PipelineLayouts[key] = pipelineLayout;
+
+		return pipelineLayout;
+	}
+
+	VkPipeline PipelineRegistry::getPipeline(string const& key, function<VkPipeline()> const& create)
+	{
+		{
+			lock_guard<mutex> lock(m_Mutex);
+			++m_PipelineRequestCnt;
+
+			auto it = m_Pipelines.find(key);
+			if (it != end(m_Pipelines)) return it->second;
+		}
+
+		//compiled without lock, so other pipelines are not blocked
+		VkPipeline pipeline = create();
+
+		lock_guard<mutex> lock(m_Mutex);
+
+		auto it = m_Pipelines.find(key);
+		if (it != end(m_Pipelines))
+		{
+			//same pipeline was finished by other thread meanwhile
+			vkDestroyPipeline(m_Device, pipeline, nullptr);
+			return it->second;
+		}
+
+		m_Pipelines[key] = pipeline;
+
+		return pipeline;
+	}
+
+	void PipelineRegistry::printStatistics() const
+	{
+		lock_guard<mutex> lock(m_Mutex);
+
+		cout << "Pipelines: " << m_Pipelines.size() << " created for " << m_PipelineRequestCnt << " requests, layouts: " << m_PipelineLayouts.size() << ", shader modules: " << m_ShaderModules.size() << endl;
+	}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//Shader modules, pipeline layouts and pipelines shared by all renderers. Each SPIR-V file is loaded once and
+//pipelines / layouts with identical state are created once. Everything is owned until registry is destroyed.
+//Thread safe, different pipelines can be created concurrently.
+class PipelineRegistry
+{
+public:
+	PipelineRegistry(VkDevice device);
+	~PipelineRegistry();
+	PipelineRegistry(PipelineRegistry const&) = delete;
+	PipelineRegistry& operator=(PipelineRegistry const&) = delete;
+
+	//registry registered for device, VulkanHelpers only know VkDevice
+	static PipelineRegistry& get(VkDevice device);
+
+	VkShaderModule getShaderModule(string const& filePath);
+	VkPipelineLayout getPipelineLayout(vector<VkDescriptorSetLayout> const& descriptorSetLayouts, vector<VkPushConstantRange> const& pushConstants);
+
+	//key has to describe whole pipeline state, create is called only when key is not registered yet
+	VkPipeline getPipeline(string const& key, function<VkPipeline()> const& create);
+
+	//raw bytes of trivially copyable state appended to pipeline key
+	template<typename T> static void appendKey(string& key, T const* data, size_t cnt)
+	{
+		key.append(reinterpret_cast<char const*>(data), sizeof(T) * cnt);
+	}
+
+	static void appendKey(string& key, string const& value)
+	{
+		key.append(value);
+		key.push_back('\0');
+	}
+
+	void printStatistics() const;
+
+private:
+	VkDevice m_Device;
+
+	mutable mutex m_Mutex;
+	unordered_map<string, VkShaderModule> m_ShaderModules; //by file path
+	unordered_map<string, VkPipelineLayout> m_PipelineLayouts;
+	unordered_map<string, VkPipeline> m_Pipelines;
+	size_t m_PipelineRequestCnt = 0;
+
+	static unordered_map<VkDevice, PipelineRegistry*> s_Registries;
+};
@@ -2,24 +2,27 @@
 
 #include "RayTracer.h"
 #include "ParticleComponent.h"
+#include "CpuProfiler.h"
 
 
-	RayTracer::RayTracer(VkPhysicalDevice physicalDevice, VkDevice device, int computeQueueIndex, VkCommandPool commandPool, VkQueue queue, VkRenderPass renderPass, size_t resX, size_t resY):m_ComputeDescriptorSet(make_shared<DescriptorSetLayout>(device)), m_Sampler(device)
+	RayTracer::RayTracer(VkPhysicalDevice physicalDevice, VkDevice device, ComputeScheduler& computeScheduler, GpuProfiler& gpuProfiler, VkCommandPool commandPool, VkQueue queue, StagingRing& stagingRing, VkRenderPass renderPass, size_t resX, size_t resY):m_ComputeDescriptorSet(make_shared<DescriptorSetLayout>(device)), m_ComputeScheduler(computeScheduler), m_GpuProfiler(gpuProfiler), m_StagingRing(stagingRing), m_Sampler(device)
 	{
 		m_Device = device;
 		m_PhysicalDevice = physicalDevice;
 		m_RenderPass = renderPass;
-		createComputePipeline(physicalDevice, device, computeQueueIndex);
+		m_TraceScope = m_GpuProfiler.createScope("ray tracing");
+		createComputePipeline(physicalDevice, device);
 
 		VkImage image;
-		VkDeviceMemory imageMemory;
+		MemoryAllocation imageMemory;
 		VkImageView imageView;
 
 		
 
 		VulkanHelpers::createImage(physicalDevice, device, resX, resY, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
 
-		VulkanHelpers::transitionImageLayout(device, commandPool, queue, image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+		//batched with scene uploads, submitComputeCommand finishes staging ring before compute uses image
+		m_StagingRing.transitionImage(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
 
 		VulkanHelpers::createImageView(imageView, device, image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
 
@@ -35,6 +38,8 @@
 		m_UniformBufferMappingPtr->resY = resY;
 
 		createRenderPass(m_PhysicalDevice, m_Device);
+		m_ComputePipelineJob.get();
+		m_RenderPipelineJob.get();
 	}
 
 	void RayTracer::setTextures( vector<VkImageView> const & imageViews)
@@ -50,26 +55,36 @@
 
 	void RayTracer::recordComputeCommand()
 	{
+		VkCommandBuffer commandBuffer = m_ComputeCommandBuffers[m_CommandBufferIdx];
+
 		VkCommandBufferBeginInfo cmdBufferBeginInfo{};
 		cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		cmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-		auto res = vkBeginCommandBuffer(m_ComputeCommandBuffer, &cmdBufferBeginInfo);
+		auto res = vkBeginCommandBuffer(commandBuffer, &cmdBufferBeginInfo);
 		assert(VK_SUCCESS == res);
 
-		vkCmdBindPipeline(m_ComputeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline);
+		//scene buffers are set one by one from setters, all are written at once before recording
+		m_ComputeDescriptorSet.update();
+
+		{
+			GpuScope gpuScope(m_GpuProfiler, commandBuffer, m_TraceScope);
+
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline);
+
+			vkCmdPushConstants(commandBuffer, m_PipelineLayoutCompute, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(m_ViewMatrix), &m_ViewMatrix);
+
+			auto const& descriptorSet = m_ComputeDescriptorSet.getDescriptorSet();
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayoutCompute, 0, 1, &descriptorSet, 0, 0);
+			vkCmdDispatch(commandBuffer, (m_UniformBufferMappingPtr->resX * m_UniformBufferMappingPtr->resY) / RAYS_PER_GROUP, 1, 1);
+		}
 
-		vkCmdPushConstants(m_ComputeCommandBuffer, m_PipelineLayoutCompute, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(m_ViewMatrix), &m_ViewMatrix);
-			
-		auto const& descriptorSet = m_ComputeDescriptorSet.getDescriptorSet();
-		vkCmdBindDescriptorSets(m_ComputeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayoutCompute, 0, 1, &descriptorSet, 0, 0);
-		vkCmdDispatch(m_ComputeCommandBuffer, (m_UniformBufferMappingPtr->resX * m_UniformBufferMappingPtr->resY) / RAYS_PER_GROUP, 1, 1);
-			
-		vkEndCommandBuffer(m_ComputeCommandBuffer);
+		vkEndCommandBuffer(commandBuffer);
 	}
 
 	void RayTracer::setTriangles(vector<Triangle>  const & triangles)
 	{
-		m_TriangleBuffer = make_unique<Buffer>(m_PhysicalDevice, m_Device, &triangles[0], triangles.size(), (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT));
+		m_TriangleBuffer = make_unique<Buffer>(m_PhysicalDevice, m_Device, m_StagingRing, &triangles[0], triangles.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
 		m_ComputeDescriptorSet.setStorage("triangles", *m_TriangleBuffer);
 
 		m_UniformBufferMappingPtr->triangleCnt = triangles.size();
@@ -86,7 +101,7 @@
 
 	void RayTracer::setSpheres(vector<Sphere> const& spheres)
 	{
-		m_SphereBuffer = make_unique<Buffer>(m_PhysicalDevice, m_Device, &spheres[0], spheres.size(), (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT));
+		m_SphereBuffer = make_unique<Buffer>(m_PhysicalDevice, m_Device, m_StagingRing, &spheres[0], spheres.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
 		m_ComputeDescriptorSet.setStorage("spheres", *m_SphereBuffer);
 
 		m_UniformBufferMappingPtr->sphereCnt = spheres.size();
@@ -95,26 +110,25 @@
 
 	void RayTracer::setMaterials(vector<Material> const& materials)
 	{
-		m_MaterialBuffer = make_unique<Buffer>(m_PhysicalDevice, m_Device, &materials[0], materials.size(), (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT));
+		m_MaterialBuffer = make_unique<Buffer>(m_PhysicalDevice, m_Device, m_StagingRing, &materials[0], materials.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
 		m_ComputeDescriptorSet.setStorage("materials", *m_MaterialBuffer);
 	}
 
 	void RayTracer::submitComputeCommand()
 	{
-		VkSubmitInfo submitInfo{};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_ComputeCommandBuffer;
+		PROFILE_FUNCTION();
 
-		//viewMatrix
+		//scene buffers have to be uploaded before compute reads them, compute queue is not ordered with staging ring queue
+		m_StagingRing.finish();
 
-		vkQueueSubmit(m_Queue, 1, &submitInfo, m_Fence);
-		vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, UINT64_MAX);
-		vkResetFences(m_Device, 1, &m_Fence);
+		//image is traced in place, so compute waits for previous frame which displays it, CPU doesn't wait
+		m_ComputeScheduler.submit(m_ComputeCommandBuffers[m_CommandBufferIdx], 1);
+
+		m_CommandBufferIdx = (m_CommandBufferIdx + 1) % COMMAND_BUFFER_CNT;
 	}
 
 
-	void RayTracer::createComputePipeline(VkPhysicalDevice physicalDevice, VkDevice device, int computeQueueIndex)
+	void RayTracer::createComputePipeline(VkPhysicalDevice physicalDevice, VkDevice device)
 	{
 		m_ComputeDescriptorSet.getDescriptorSetlayout()->addDescriptor("dstImage", 0, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
 		m_ComputeDescriptorSet.getDescriptorSetlayout()->addDescriptor("settings", 1, VK_SHADER_STAGE_COMPUTE_BIT, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
@@ -150,7 +164,7 @@
 		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
 		shaderStage.pName = "main"; // todo : make param
-		VulkanHelpers::createShaderModuleFromFile("./../Shaders/rayTracerCompute.spv", device, shaderStage.module);
+		shaderStage.module = PipelineRegistry::get(device).getShaderModule("./../Shaders/rayTracerCompute.spv");
 
 		VkComputePipelineCreateInfo computePipelineCreateInfo{};
 		computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
@@ -159,39 +173,14 @@
 		computePipelineCreateInfo.stage = shaderStage;
 
 
-		VkCommandPool commandPool;
-
-		VkCommandPoolCreateInfo cmdPoolInfo = {};
-		cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		cmdPoolInfo.queueFamilyIndex = computeQueueIndex;
-		cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-
-		res = vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &commandPool);
-		assert(VK_SUCCESS == res);
-
-		vkGetDeviceQueue(device, computeQueueIndex, 0, &m_Queue);
-
-		// Fence for compute CB sync
-		VkFenceCreateInfo fenceCreateInfo{};
-		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-		res = vkCreateFence(device, &fenceCreateInfo, nullptr, &m_Fence);
-		assert(VK_SUCCESS == res);
-
-		// Create a command buffer for compute operations
-		VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
-		commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		commandBufferAllocateInfo.commandPool = commandPool;
-		commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		commandBufferAllocateInfo.commandBufferCount = 1;
-
-		res = vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &m_ComputeCommandBuffer);
-		assert(VK_SUCCESS == res);
-
-		res = vkCreateComputePipelines(device, nullptr, 1, &computePipelineCreateInfo, nullptr, &m_ComputePipeline);
-		assert(VK_SUCCESS == res);
+		m_ComputeCommandBuffers = m_ComputeScheduler.allocateCommandBuffers(COMMAND_BUFFER_CNT);
 
-		vkResetFences(device, 1, &m_Fence);
+		//only device and shader files are touched, pipeline cache is internally synchronized
+		m_ComputePipelineJob = async(launch::async, [this, device, computePipelineCreateInfo]()
+			{
+				auto res = vkCreateComputePipelines(device, PipelineCache::get(device).getCache(), 1, &computePipelineCreateInfo, nullptr, &m_ComputePipeline);
+				assert(VK_SUCCESS == res);
+			});
 	}
 
 	void RayTracer::createRenderPass(VkPhysicalDevice physicalDevice, VkDevice device)
@@ -207,6 +196,7 @@
 		m_RenderDescriptor->createDescriptorSet();
 
 		m_RenderDescriptor->setSampler("image", m_DstImage->imageView,  m_Sampler.m_Sampler, VK_IMAGE_LAYOUT_GENERAL);
+		m_RenderDescriptor->update();
 		
 		//GRAPHIC PIPELINE
 		ShaderSet shaderData;
@@ -222,7 +212,10 @@
 		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 		inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-		VulkanHelpers::createGraphicsPipeline(m_Device, m_RenderPass, 1, { 1024, 1024 }, shaderData, true, inputAssembly, m_RenderPipelineLayout, m_RenderPipeline);
+		m_RenderPipelineJob = async(launch::async, [this, shaderData, inputAssembly]()
+			{
+				VulkanHelpers::createGraphicsPipeline(m_Device, m_RenderPass, 1, { 1024, 1024 }, shaderData, true, inputAssembly, m_RenderPipelineLayout, m_RenderPipeline);
+			});
 	}
 
 	
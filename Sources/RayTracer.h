@@ -3,18 +3,21 @@
 #include "VulkanHelper.h"
 #include "MaterialManager.h"
 #include "Model.h"
+#include "ComputeScheduler.h"
+#include "GpuProfiler.h"
 #include <memory>
+#include <future>
 
 using namespace std;
 
 struct Image
 {
 	VkImage image;
-	VkDeviceMemory imageMemory;
+	MemoryAllocation imageMemory;
 	VkImageView imageView;
 	VkDevice device;
 
-	Image(VkImage image, VkDeviceMemory memory, VkImageView view, VkDevice device):image(image), imageMemory(memory), imageView(view), device(device)
+	Image(VkImage image, MemoryAllocation memory, VkImageView view, VkDevice device):image(image), imageMemory(memory), imageView(view), device(device)
 	{}
 
 	~Image()
@@ -46,7 +49,7 @@ private:
 		{
 			vkDestroyImageView(device, imageView, nullptr);
 			vkDestroyImage(device, image, nullptr);
-			vkFreeMemory(device, imageMemory, nullptr);
+			MemoryAllocator::get(device).free(imageMemory);
 			device = VK_NULL_HANDLE;
 		}
 	}
@@ -108,7 +111,7 @@ struct RayTracerUBO
 class RayTracer
 {
 public:
-	RayTracer(VkPhysicalDevice physicalDevice, VkDevice device, int computeQueueIndex, VkCommandPool commandPool, VkQueue queue, VkRenderPass renderpass, size_t resX, size_t resY);
+	RayTracer(VkPhysicalDevice physicalDevice, VkDevice device, ComputeScheduler& computeScheduler, GpuProfiler& gpuProfiler, VkCommandPool commandPool, VkQueue queue, StagingRing& stagingRing, VkRenderPass renderpass, size_t resX, size_t resY);
 
 	void setResolution(size_t x, size_t y);
 	void setTriangles(vector<Triangle> const &triangles);
@@ -119,17 +122,22 @@ public:
 	void setView(glm::mat4 const& matrix);
 	void setTextures(vector<VkImageView> const& imageViews);
 
+	//both have to be called from drawFrame callback, command buffer of frame slot is reused after its fence was waited
 	void recordComputeCommand();
 	void submitComputeCommand();
 
 //private:
 
 	static const size_t RAYS_PER_GROUP = 8;
+	static const uint32_t COMMAND_BUFFER_CNT = 3; //one per frame in flight, VulcanInstance::MAX_FRAMES_IN_FLIGHT
 
 	
 	VkPipelineLayout m_PipelineLayoutCompute;
 	VkPipeline m_ComputePipeline;
-	VkCommandBuffer m_ComputeCommandBuffer;
+	future<void> m_ComputePipelineJob; //both pipelines compile on worker threads while image and buffers are created
+	future<void> m_RenderPipelineJob;
+	vector<VkCommandBuffer> m_ComputeCommandBuffers;
+	uint32_t m_CommandBufferIdx = 0;
 
 	DescriptorSet m_ComputeDescriptorSet;
 
@@ -137,10 +145,12 @@ public:
 	unique_ptr<Buffer>  m_SphereBuffer;
 	unique_ptr<Buffer> m_MaterialBuffer;
 
-	VkFence m_Fence;
-	VkQueue m_Queue;
+	ComputeScheduler& m_ComputeScheduler;
+	GpuProfiler& m_GpuProfiler;
+	uint32_t m_TraceScope;
 	VkDevice m_Device;
 	VkPhysicalDevice m_PhysicalDevice;
+	StagingRing& m_StagingRing;
 
 	Sampler m_Sampler;
 	unique_ptr< Image> m_DstImage;
@@ -156,5 +166,5 @@ public:
 	glm::mat4 m_ViewMatrix;
 
 	void createRenderPass(VkPhysicalDevice physicalDevice, VkDevice device);
-	void createComputePipeline(VkPhysicalDevice physicalDevice, VkDevice device, int computeQueueIndex);
+	void createComputePipeline(VkPhysicalDevice physicalDevice, VkDevice device);
 }; 
\ No newline at end of file
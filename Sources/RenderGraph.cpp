@@ -0,0 +1,448 @@
+
+#include "RenderGraph.h"
+#include "VulkanHelper.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <iostream>
+
+using namespace std;
+
+//any attachment write or sampled read of graph resource happens in these stages
+static const VkPipelineStageFlags s_GraphStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+	VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+static const VkAccessFlags s_GraphWriteAccess = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+
+	RenderGraph::RenderGraph(VkPhysicalDevice physicalDevice, VkDevice device, GpuProfiler* profiler) : m_PhysicalDevice(physicalDevice), m_Device(device), m_Profiler(profiler)
+	{
+	}
+
+	RenderGraph::~RenderGraph()
+	{
+		vkDeviceWaitIdle(m_Device); //images may be used by frames in flight
+
+		for (auto& pass : m_Passes)
+		{
+			if (pass.framebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(m_Device, pass.framebuffer, nullptr);
+			if (pass.renderPass != VK_NULL_HANDLE) vkDestroyRenderPass(m_Device, pass.renderPass, nullptr);
+		}
+
+		for (auto& resource : m_Resources)
+		{
+			if (resource.view != VK_NULL_HANDLE) vkDestroyImageView(m_Device, resource.view, nullptr);
+			if (resource.image != VK_NULL_HANDLE) vkDestroyImage(m_Device, resource.image, nullptr);
+		}
+
+		for (auto& slot : m_MemorySlots) MemoryAllocator::get(m_Device).free(slot.memory);
+	}
+
+	RenderGraph::ResourceId RenderGraph::createAttachment(string const& name, VkFormat format, VkExtent2D extent, VkImageAspectFlags aspect)
+	{
+		assert(!m_Compiled);
+
+		Resource resource;
+		resource.name = name;
+		resource.format = format;
+		resource.extent = extent;
+		resource.aspect = aspect;
+		m_Resources.push_back(resource);
+
+		return static_cast<ResourceId>(m_Resources.size() - 1);
+	}
+
+	RenderGraph::PassId RenderGraph::addPass(string const& name, vector<ResourceId> const& colorAttachments, optional<ResourceId> depthAttachment, vector<ResourceId> const& sampledImages,
+		bool output, function<void(VkCommandBuffer)> record, VkSubpassContents contents)
+	{
+		assert(!m_Compiled);
+
+		Pass pass;
+		pass.name = name;
+		pass.colorAttachments = colorAttachments;
+		pass.depthAttachment = depthAttachment;
+		pass.sampledImages = sampledImages;
+		pass.output = output;
+		pass.record = record;
+		pass.contents = contents;
+		m_Passes.push_back(pass);
+
+		return static_cast<PassId>(m_Passes.size() - 1);
+	}
+
+	void RenderGraph::compile()
+	{
+		assert(!m_Compiled);
+
+		cullPasses();
+		createImages();
+		aliasMemory();
+		createBarriers();
+		createRenderPasses();
+
+		if (m_Profiler)
+			for (auto passId : m_ExecutedPasses) m_Passes[passId].gpuScope = m_Profiler->createScope(m_Passes[passId].name);
+
+		m_Compiled = true;
+	}
+
+	void RenderGraph::execute(VkCommandBuffer commandBuffer) const
+	{
+		assert(m_Compiled);
+
+		for (auto passId : m_ExecutedPasses)
+		{
+			Pass const& pass = m_Passes[passId];
+
+			if (!pass.barriers.empty())
+				vkCmdPipelineBarrier(commandBuffer, pass.srcStages, pass.dstStages, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(pass.barriers.size()), &pass.barriers[0]);
+
+			if (m_Profiler) m_Profiler->begin(commandBuffer, pass.gpuScope);
+
+			if (pass.renderPass == VK_NULL_HANDLE)
+			{
+				pass.record(commandBuffer);
+				if (m_Profiler) m_Profiler->end(commandBuffer, pass.gpuScope);
+				continue;
+			}
+
+			VkRenderPassBeginInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = pass.renderPass;
+			renderPassInfo.framebuffer = pass.framebuffer;
+			renderPassInfo.renderArea.offset = { 0, 0 };
+			renderPassInfo.renderArea.extent = pass.extent;
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+			renderPassInfo.pClearValues = &pass.clearValues[0];
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, pass.contents);
+			pass.record(commandBuffer);
+			vkCmdEndRenderPass(commandBuffer);
+
+			if (m_Profiler) m_Profiler->end(commandBuffer, pass.gpuScope);
+		}
+	}
+
+	VkImageView RenderGraph::getImageView(ResourceId resource) const
+	{
+		assert(m_Compiled && m_Resources[resource].used);
+		return m_Resources[resource].view;
+	}
+
+	VkRenderPass RenderGraph::getRenderPass(PassId pass) const
+	{
+		assert(m_Compiled && !m_Passes[pass].culled);
+		return m_Passes[pass].renderPass;
+	}
+
+	VkFramebuffer RenderGraph::getFramebuffer(PassId pass) const
+	{
+		assert(m_Compiled && !m_Passes[pass].culled);
+		return m_Passes[pass].framebuffer;
+	}
+
+	void RenderGraph::printStatistics() const
+	{
+		VkDeviceSize resourcesSize = 0;
+		size_t usedCnt = 0;
+		for (auto const& resource : m_Resources)
+		{
+			if (!resource.used) continue;
+			resourcesSize += resource.requirements.size;
+			++usedCnt;
+		}
+
+		VkDeviceSize aliasedSize = 0;
+		for (auto const& slot : m_MemorySlots) aliasedSize += slot.requirements.size;
+
+		float const mb = 1024.0f * 1024.0f;
+		cout << "Render graph: " << m_ExecutedPasses.size() << " passes (" << m_Passes.size() - m_ExecutedPasses.size() << " culled), " << usedCnt << " attachments: "
+			<< resourcesSize / mb << " MB, aliased into " << m_MemorySlots.size() << " allocations: " << aliasedSize / mb << " MB (saved " << (resourcesSize - aliasedSize) / mb << " MB)" << endl;
+	}
+
+	RenderGraph::Usage RenderGraph::getAttachmentUsage(Resource const& resource)
+	{
+		if (resource.aspect & VK_IMAGE_ASPECT_DEPTH_BIT)
+			return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, true };
+
+		return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, true };
+	}
+
+	RenderGraph::Usage RenderGraph::getSampledUsage(Resource const& resource)
+	{
+		VkImageLayout const layout = resource.aspect & VK_IMAGE_ASPECT_DEPTH_BIT ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		return { layout, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, false };
+	}
+
+	void RenderGraph::cullPasses()
+	{
+		//backwards, pass is needed when it is output or writes resource read by needed pass later
+		vector<bool> readLater(m_Resources.size(), false);
+
+		for (size_t i = m_Passes.size(); i-- > 0;)
+		{
+			Pass& pass = m_Passes[i];
+
+			vector<ResourceId> writes = pass.colorAttachments;
+			if (pass.depthAttachment) writes.push_back(*pass.depthAttachment);
+
+			bool needed = pass.output;
+			for (auto resource : writes) needed = needed || readLater[resource];
+
+			pass.culled = !needed;
+			if (pass.culled) continue;
+
+			//attachments are cleared, so earlier content of written resources is not needed
+			for (auto resource : writes) readLater[resource] = false;
+			for (auto resource : pass.sampledImages) readLater[resource] = true;
+		}
+
+		for (uint32_t i = 0; i < m_Passes.size(); ++i)
+			if (!m_Passes[i].culled) m_ExecutedPasses.push_back(i);
+	}
+
+	void RenderGraph::createImages()
+	{
+		for (uint32_t i = 0; i < m_ExecutedPasses.size(); ++i)
+		{
+			Pass const& pass = m_Passes[m_ExecutedPasses[i]];
+
+			vector<ResourceId> resources = pass.colorAttachments;
+			if (pass.depthAttachment) resources.push_back(*pass.depthAttachment);
+			resources.insert(end(resources), begin(pass.sampledImages), end(pass.sampledImages));
+
+			for (auto id : resources)
+			{
+				Resource& resource = m_Resources[id];
+				if (!resource.used) resource.firstPass = i;
+				resource.lastPass = i;
+				resource.used = true;
+			}
+		}
+
+		for (auto& resource : m_Resources)
+		{
+			if (!resource.used) continue; //only passes which were culled use it
+
+			VkImageUsageFlags const attachmentUsage = resource.aspect & VK_IMAGE_ASPECT_DEPTH_BIT ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+			VkImageCreateInfo imageInfo = {};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.extent.width = resource.extent.width;
+			imageInfo.extent.height = resource.extent.height;
+			imageInfo.extent.depth = 1;
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.format = resource.format;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageInfo.usage = attachmentUsage | VK_IMAGE_USAGE_SAMPLED_BIT;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			auto res = vkCreateImage(m_Device, &imageInfo, nullptr, &resource.image);
+			assert(res == VK_SUCCESS);
+
+			vkGetImageMemoryRequirements(m_Device, resource.image, &resource.requirements);
+		}
+	}
+
+	void RenderGraph::aliasMemory()
+	{
+		//biggest first, each resource goes to first slot with compatible memory type whose resources are not alive meanwhile
+		vector<ResourceId> order;
+		for (uint32_t i = 0; i < m_Resources.size(); ++i)
+			if (m_Resources[i].used) order.push_back(i);
+
+		sort(begin(order), end(order), [this](ResourceId a, ResourceId b) { return m_Resources[a].requirements.size > m_Resources[b].requirements.size; });
+
+		for (auto id : order)
+		{
+			Resource const& resource = m_Resources[id];
+
+			auto overlaps = [this, &resource](ResourceId other)
+			{
+				return resource.firstPass <= m_Resources[other].lastPass && m_Resources[other].firstPass <= resource.lastPass;
+			};
+
+			MemorySlot* found = nullptr;
+			for (auto& slot : m_MemorySlots)
+			{
+				if ((slot.requirements.memoryTypeBits & resource.requirements.memoryTypeBits) == 0) continue;
+				if (any_of(begin(slot.resources), end(slot.resources), overlaps)) continue;
+
+				found = &slot;
+				break;
+			}
+
+			if (found == nullptr)
+			{
+				m_MemorySlots.push_back({ resource.requirements, {}, {} });
+				found = &m_MemorySlots.back();
+			}
+
+			found->requirements.size = max(found->requirements.size, resource.requirements.size);
+			found->requirements.alignment = max(found->requirements.alignment, resource.requirements.alignment);
+			found->requirements.memoryTypeBits &= resource.requirements.memoryTypeBits;
+			found->resources.push_back(id);
+		}
+
+		for (auto& slot : m_MemorySlots)
+		{
+			slot.memory = MemoryAllocator::get(m_Device).allocate(slot.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+
+			for (auto id : slot.resources)
+			{
+				Resource& resource = m_Resources[id];
+
+				auto res = vkBindImageMemory(m_Device, resource.image, slot.memory.memory, slot.memory.offset);
+				assert(res == VK_SUCCESS);
+
+				VulkanHelpers::createImageView(resource.view, m_Device, resource.image, resource.format, resource.aspect);
+			}
+		}
+	}
+
+	void RenderGraph::createBarriers()
+	{
+		//last use of every resource while walking passes in execution order
+		struct State
+		{
+			bool valid;
+			Usage usage;
+		};
+		vector<State> states(m_Resources.size(), { false, {} });
+
+		for (auto passId : m_ExecutedPasses)
+		{
+			Pass& pass = m_Passes[passId];
+
+			vector<pair<ResourceId, Usage>> usages;
+			for (auto id : pass.colorAttachments) usages.push_back({ id, getAttachmentUsage(m_Resources[id]) });
+			if (pass.depthAttachment) usages.push_back({ *pass.depthAttachment, getAttachmentUsage(m_Resources[*pass.depthAttachment]) });
+			for (auto id : pass.sampledImages) usages.push_back({ id, getSampledUsage(m_Resources[id]) });
+
+			for (auto& idUsage : usages)
+			{
+				Resource const& resource = m_Resources[idUsage.first];
+				Usage const& usage = idUsage.second;
+				State& state = states[idUsage.first];
+
+				VkImageMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.newLayout = usage.layout;
+				barrier.dstAccessMask = usage.access;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = resource.image;
+				barrier.subresourceRange = { resource.aspect, 0, 1, 0, 1 };
+
+				if (!state.valid)
+				{
+					//first use in frame, content is discarded, wait for previous frame or resource sharing memory
+					barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					barrier.srcAccessMask = s_GraphWriteAccess;
+					pass.srcStages |= s_GraphStages;
+				}
+				else
+				{
+					//read after read in the same layout needs no barrier
+					if (!state.usage.write && !usage.write && state.usage.layout == usage.layout)
+					{
+						state.usage.stages |= usage.stages;
+						continue;
+					}
+
+					barrier.oldLayout = state.usage.layout;
+					barrier.srcAccessMask = state.usage.write ? state.usage.access : 0;
+					pass.srcStages |= state.usage.stages;
+				}
+
+				pass.dstStages |= usage.stages;
+				pass.barriers.push_back(barrier);
+
+				state.valid = true;
+				state.usage = usage;
+			}
+		}
+	}
+
+	bool RenderGraph::isReadLater(ResourceId resource, uint32_t executedPassIdx) const
+	{
+		for (uint32_t i = executedPassIdx + 1; i < m_ExecutedPasses.size(); ++i)
+		{
+			Pass const& pass = m_Passes[m_ExecutedPasses[i]];
+
+			if (find(begin(pass.sampledImages), end(pass.sampledImages), resource) != end(pass.sampledImages)) return true;
+			if (find(begin(pass.colorAttachments), end(pass.colorAttachments), resource) != end(pass.colorAttachments)) return false;
+			if (pass.depthAttachment == resource) return false;
+		}
+
+		return false;
+	}
+
+	void RenderGraph::createRenderPasses()
+	{
+		for (uint32_t i = 0; i < m_ExecutedPasses.size(); ++i)
+		{
+			Pass& pass = m_Passes[m_ExecutedPasses[i]];
+			if (pass.colorAttachments.empty() && !pass.depthAttachment) continue;
+
+			//layouts are changed by graph barriers, render pass keeps attachment layout and has no external dependencies
+			vector<VkAttachmentDescription> attachments;
+			vector<VkAttachmentReference> colorReferences;
+			VkAttachmentReference depthReference = {};
+			vector<VkImageView> views;
+
+			vector<ResourceId> resources = pass.colorAttachments;
+			if (pass.depthAttachment) resources.push_back(*pass.depthAttachment);
+
+			for (auto id : resources)
+			{
+				Resource const& resource = m_Resources[id];
+				Usage const usage = getAttachmentUsage(resource);
+
+				VkAttachmentDescription attachment = {};
+				attachment.format = resource.format;
+				attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+				attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+				attachment.storeOp = isReadLater(id, i) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachment.initialLayout = usage.layout;
+				attachment.finalLayout = usage.layout;
+
+				VkAttachmentReference reference = { static_cast<uint32_t>(attachments.size()), usage.layout };
+				if (resource.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) depthReference = reference;
+				else colorReferences.push_back(reference);
+
+				VkClearValue clearValue = {};
+				if (resource.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) clearValue.depthStencil = { 1.0f, 0 };
+				else clearValue.color = { 0.0f, 0.0f, 0.0f, 0.0f };
+				pass.clearValues.push_back(clearValue);
+
+				attachments.push_back(attachment);
+				views.push_back(resource.view);
+				pass.extent = resource.extent;
+			}
+
+			VkSubpassDescription subpass = {};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+			subpass.pColorAttachments = colorReferences.empty() ? nullptr : &colorReferences[0];
+			subpass.pDepthStencilAttachment = pass.depthAttachment ? &depthReference : nullptr;
+
+			VkRenderPassCreateInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			renderPassInfo.pAttachments = &attachments[0];
+			renderPassInfo.subpassCount = 1;
+			renderPassInfo.pSubpasses = &subpass;
+
+			auto res = vkCreateRenderPass(m_Device, &renderPassInfo, nullptr, &pass.renderPass);
+			assert(res == VK_SUCCESS);
+
+			VulkanHelpers::createFramebuffer(pass.framebuffer, pass.renderPass, views, m_Device, pass.extent);
+		}
+	}
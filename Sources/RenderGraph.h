@@ -0,0 +1,124 @@
+#pragma once
+
+#include "MemoryAllocator.h"
+#include "GpuProfiler.h"
+
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//Frame described as passes which declare attachments they write and images they sample. compile() culls passes whose results
+//are never used by output pass, creates render passes and barriers from declared usage and aliases memory of attachments
+//which are not alive at the same time. Graph is static, it is compiled once and executed every frame.
+class RenderGraph
+{
+public:
+	using ResourceId = uint32_t;
+	using PassId = uint32_t;
+
+	//with profiler GPU time of every executed pass is measured under its name
+	RenderGraph(VkPhysicalDevice physicalDevice, VkDevice device, GpuProfiler* profiler = nullptr);
+	~RenderGraph();
+	RenderGraph(RenderGraph const&) = delete;
+	RenderGraph& operator=(RenderGraph const&) = delete;
+
+	//transient attachment owned by graph, content is valid only inside one frame, sampled by later passes
+	ResourceId createAttachment(string const& name, VkFormat format, VkExtent2D extent, VkImageAspectFlags aspect);
+
+	//attachments are cleared and written (colors to 0, depth to 1), sampled images are read in fragment shader
+	//pass without attachments begins its own render pass in record (e.g. into swapchain framebuffer)
+	//output pass has effects outside of graph and is never culled
+	//with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS record may only execute secondary command buffers (see getFramebuffer)
+	PassId addPass(string const& name, vector<ResourceId> const& colorAttachments, optional<ResourceId> depthAttachment, vector<ResourceId> const& sampledImages,
+		bool output, function<void(VkCommandBuffer)> record, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+
+	void compile();
+	void execute(VkCommandBuffer commandBuffer) const;
+
+	//valid after compile
+	VkImageView getImageView(ResourceId resource) const;
+	VkRenderPass getRenderPass(PassId pass) const;
+	VkFramebuffer getFramebuffer(PassId pass) const; //for inheritance info of secondary command buffers
+
+	void printStatistics() const;
+
+private:
+	struct Resource
+	{
+		string name;
+		VkFormat format;
+		VkExtent2D extent;
+		VkImageAspectFlags aspect;
+
+		VkImage image = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		VkMemoryRequirements requirements = {};
+		uint32_t firstPass = 0; //lifetime in executed passes
+		uint32_t lastPass = 0;
+		bool used = false;
+	};
+
+	struct Pass
+	{
+		string name;
+		vector<ResourceId> colorAttachments;
+		optional<ResourceId> depthAttachment;
+		vector<ResourceId> sampledImages;
+		bool output;
+		function<void(VkCommandBuffer)> record;
+		VkSubpassContents contents;
+		uint32_t gpuScope = 0;
+
+		bool culled = false;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkExtent2D extent = {};
+		vector<VkClearValue> clearValues;
+
+		//recorded before pass
+		vector<VkImageMemoryBarrier> barriers;
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+	};
+
+	//memory shared by resources with disjoint lifetimes
+	struct MemorySlot
+	{
+		VkMemoryRequirements requirements;
+		MemoryAllocation memory;
+		vector<ResourceId> resources;
+	};
+
+	//layout, stages and access of one use of resource by pass
+	struct Usage
+	{
+		VkImageLayout layout;
+		VkPipelineStageFlags stages;
+		VkAccessFlags access;
+		bool write;
+	};
+
+	static Usage getAttachmentUsage(Resource const& resource);
+	static Usage getSampledUsage(Resource const& resource);
+
+	void cullPasses();
+	void createImages();
+	void aliasMemory();
+	void createBarriers();
+	void createRenderPasses();
+	bool isReadLater(ResourceId resource, uint32_t executedPassIdx) const;
+
+	VkPhysicalDevice m_PhysicalDevice;
+	VkDevice m_Device;
+	GpuProfiler* m_Profiler;
+
+	vector<Resource> m_Resources;
+	vector<Pass> m_Passes;
+	vector<PassId> m_ExecutedPasses; //in declaration order, without culled passes
+	vector<MemorySlot> m_MemorySlots;
+	bool m_Compiled = false;
+};
@@ -18,6 +18,18 @@ public:
 			});
 	}
 
+	//objects [first, last) in enumeration order, lets threads take disjoint ranges
+	template<typename Func> void enumerate(size_t first, size_t last, Func func)
+	{
+		for (size_t i = first; i < last; ++i)
+			func(m_SceneObjects[i].get());
+	}
+
+	size_t size() const
+	{
+		return m_SceneObjects.size();
+	}
+
 	void clear();
 private:
 	vector<unique_ptr<SceneObject>> m_SceneObjects;
@@ -9,14 +9,10 @@
 using namespace std;
 
 
-ShadowRenderer::ShadowRenderer(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent) : m_Device(device), m_PhysicalDevice(physicalDevice), m_Extent(extent)
+ShadowRenderer::ShadowRenderer(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent, PositionFormatType positionFormat, RenderGraph& renderGraph) : m_Device(device), m_PhysicalDevice(physicalDevice), m_Extent(extent)
 {
 	VulkanHelpers::createRenderPass(m_ShadowRenderPass, m_Device, VkFormat::VK_FORMAT_END_RANGE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ATTACHMENT_LOAD_OP_CLEAR, 0, true, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
-	VulkanHelpers::createAttachmnent(m_ShadowAttachment, m_PhysicalDevice, m_Device, VK_FORMAT_D16_UNORM, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_DEPTH_BIT, m_Extent);
-
-	vector<VkImageView> attachments = { m_ShadowAttachment.view };
-
-	VulkanHelpers::createFramebuffer(m_ShadowFramebuffer, m_ShadowRenderPass, attachments, m_Device, m_Extent);
+	m_ShadowMap = renderGraph.createAttachment("shadowMap", VK_FORMAT_D16_UNORM, m_Extent, VK_IMAGE_ASPECT_DEPTH_BIT);
 
 	//DESCRIPTOR SET
 	shared_ptr<DescriptorSetLayout> descriptorSetLayout = make_shared< DescriptorSetLayout>(m_Device);
@@ -29,7 +25,7 @@ ShadowRenderer::ShadowRenderer(VkDevice device, VkPhysicalDevice physicalDevice,
 
 	//GRAPHIC PIPELINE
 	ShaderSet shaderData;
-	shaderData.vertexInputBindingDescription = Vertex::getBindingDescription();
+	shaderData.vertexInputBindingDescription = VertexFormat::getPositionBindingDescription(positionFormat);
 	shaderData.vertexShaderPath = string("./../Shaders/shadowShaderVert.spv");
 	shaderData.fragmentShaderPath = string("./../Shaders/shadowShaderFrag.spv");
 	shaderData.pushConstant.resize(1);
@@ -38,15 +34,25 @@ ShadowRenderer::ShadowRenderer(VkDevice device, VkPhysicalDevice physicalDevice,
 	shaderData.pushConstant[0].size = sizeof(glm::mat4) * 3;
 	shaderData.descriptorSetLayout.push_back(m_ShadowDescriptorSet->getDescriptorSetlayout()->getLayout());
 
-	for (auto& attribute : Vertex::getAttributeDescriptions())
-		shaderData.vertexInputAttributeDescription.push_back(attribute);
+	//depth only, fetches MeshData::positions
+	shaderData.vertexInputAttributeDescription.push_back(VertexFormat::getPositionAttributeDescription(positionFormat));
 	
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
 	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-	VulkanHelpers::createGraphicsPipeline(m_Device, m_ShadowRenderPass, 0, m_Extent, shaderData, false, inputAssembly, m_ShadowPipelineLayout, m_ShadowGraphicPipeline);
+	//only device and shader files are touched, pipeline cache is internally synchronized
+	m_PipelineJob = async(launch::async, [this, shaderData, inputAssembly]()
+		{
+			VulkanHelpers::createGraphicsPipeline(m_Device, m_ShadowRenderPass, 0, m_Extent, shaderData, false, inputAssembly, m_ShadowPipelineLayout, m_ShadowGraphicPipeline);
+		});
+}
+
+void ShadowRenderer::waitForPipeline()
+{
+	if (m_PipelineJob.valid())
+		m_PipelineJob.get();
 }
 
 
@@ -2,26 +2,32 @@
 
 #include "VulkanHelper.h"
 #include "MaterialManager.h"
+#include "VertexFormat.h"
+#include "RenderGraph.h"
 #include <memory>
+#include <future>
 
 
 class ShadowRenderer
 {
 
 public:
-	ShadowRenderer(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent);
+	ShadowRenderer(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent, PositionFormatType positionFormat, RenderGraph& renderGraph);
+
+	//pipeline compiles on worker thread while other renderers are created, has to be called before first frame is recorded
+	void waitForPipeline();
 
 public:
 	VkExtent2D m_Extent;
 	VkDevice m_Device;
 	VkPhysicalDevice m_PhysicalDevice;
-	VkFramebuffer m_ShadowFramebuffer;
 
-	VkRenderPass m_ShadowRenderPass;
-	AttachmentData m_ShadowAttachment;
+	VkRenderPass m_ShadowRenderPass; //compatible with graph pass writing m_ShadowMap, only for pipeline creation
+	RenderGraph::ResourceId m_ShadowMap;
 	shared_ptr<DescriptorSet> m_ShadowDescriptorSet;
 
 	VkPipelineLayout m_ShadowPipelineLayout;
 	VkPipeline m_ShadowGraphicPipeline;
+	future<void> m_PipelineJob;
 
 };
@@ -0,0 +1,503 @@
+
+#include "StagingRing.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+
+namespace
+{
+	VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	VkImageMemoryBarrier imageBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+
+		return barrier;
+	}
+}
+
+
+	StagingRing::StagingRing(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue queue, uint32_t queueFamilyIndex,
+		VkCommandPool transferCommandPool, VkQueue transferQueue, uint32_t transferQueueFamilyIndex, VkDeviceSize size) :
+		m_PhysicalDevice(physicalDevice), m_Device(device), m_CommandPool(commandPool), m_Queue(queue), m_QueueFamilyIndex(queueFamilyIndex),
+		m_TransferCommandPool(transferCommandPool), m_TransferQueue(transferQueue), m_TransferQueueFamilyIndex(transferQueueFamilyIndex), m_Size(size)
+	{
+		//uploads read ring on transfer queue, read backs write it on graphics queue
+		vector<uint32_t> queueFamilies = { m_QueueFamilyIndex };
+		if (hasDedicatedTransferQueue()) queueFamilies.push_back(m_TransferQueueFamilyIndex);
+
+		VulkanHelpers::allocateBuffer(m_Buffer, m_Memory, m_PhysicalDevice, m_Device, m_Size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, queueFamilies);
+
+		m_MappedPtr = static_cast<uint8_t*>(m_Memory.mappedPtr);
+	}
+
+	StagingRing::~StagingRing()
+	{
+		finish();
+
+		vkDestroyBuffer(m_Device, m_Buffer, nullptr);
+		MemoryAllocator::get(m_Device).free(m_Memory);
+	}
+
+	VkDeviceSize StagingRing::getSize() const
+	{
+		return m_Size;
+	}
+
+	bool StagingRing::hasDedicatedTransferQueue() const
+	{
+		return m_TransferQueueFamilyIndex != m_QueueFamilyIndex;
+	}
+
+	VkDeviceSize StagingRing::getMaxChunkSize() const
+	{
+		return m_Size / 2;
+	}
+
+	bool StagingRing::hasPendingCopies() const
+	{
+		return !m_PendingBufferCopies.empty() || !m_PendingImageCopies.empty() || !m_PendingDeviceCopies.empty() || !m_PendingImageTransitions.empty();
+	}
+
+	bool StagingRing::tryReserve(VkDeviceSize size, VkDeviceSize& outOffset)
+	{
+		if (m_Head == m_Tail) m_Head = m_Tail = 0;
+
+		VkDeviceSize const offset = alignUp(m_Head, ALIGNMENT);
+
+		if (m_Tail <= m_Head)
+		{
+			//free space is [head, size) and [0, tail), head must not reach tail again or ring would look empty
+			if (offset + size <= m_Size) outOffset = offset;
+			else if (size < m_Tail) outOffset = 0;
+			else return false;
+		}
+		else
+		{
+			if (offset + size < m_Tail) outOffset = offset;
+			else return false;
+		}
+
+		m_Head = outOffset + size;
+
+		return true;
+	}
+
+	VkDeviceSize StagingRing::reserve(VkDeviceSize size)
+	{
+		assert(size <= getMaxChunkSize());
+
+		retireSubmissions(false);
+
+		VkDeviceSize offset;
+		while (!tryReserve(size, offset))
+		{
+			//space can be held by copies which were not submitted yet
+			if (m_Submissions.empty()) flush();
+
+			retireSubmissions(true);
+		}
+
+		return offset;
+	}
+
+	void StagingRing::retireSubmissions(bool waitOldest)
+	{
+		if (waitOldest && !m_Submissions.empty())
+		{
+			auto res = vkWaitForFences(m_Device, 1, &m_Submissions.front().fence, VK_TRUE, UINT64_MAX);
+			assert(res == VK_SUCCESS);
+		}
+
+		while (!m_Submissions.empty() && vkGetFenceStatus(m_Device, m_Submissions.front().fence) == VK_SUCCESS)
+		{
+			Submission const& submission = m_Submissions.front();
+
+			m_Tail = submission.end;
+
+			vkDestroyFence(m_Device, submission.fence, nullptr);
+			vkFreeCommandBuffers(m_Device, m_CommandPool, 1, &submission.commandBuffer);
+
+			if (submission.transferCommandBuffer != VK_NULL_HANDLE)
+			{
+				vkFreeCommandBuffers(m_Device, m_TransferCommandPool, 1, &submission.transferCommandBuffer);
+				vkDestroySemaphore(m_Device, submission.semaphore, nullptr);
+			}
+
+			m_Submissions.pop_front();
+		}
+	}
+
+	void StagingRing::copyToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, void const* data, VkDeviceSize size)
+	{
+		//regions of one vkCmdCopyBuffer must not overlap, e.g. freed and reallocated pool range
+		auto it = m_PendingBufferCopies.find(dstBuffer);
+		if (it != end(m_PendingBufferCopies))
+		{
+			bool const overlaps = any_of(begin(it->second), end(it->second), [dstOffset, size](VkBufferCopy const& region)
+				{
+					return region.dstOffset < dstOffset + size && dstOffset < region.dstOffset + region.size;
+				});
+
+			if (overlaps) flush();
+		}
+
+		uint8_t const* src = static_cast<uint8_t const*>(data);
+
+		for (VkDeviceSize copied = 0; copied < size;)
+		{
+			VkDeviceSize const chunkSize = min(size - copied, getMaxChunkSize());
+			VkDeviceSize const offset = reserve(chunkSize);
+
+			memcpy(m_MappedPtr + offset, src + copied, chunkSize);
+
+			VkBufferCopy region = {};
+			region.srcOffset = offset;
+			region.dstOffset = dstOffset + copied;
+			region.size = chunkSize;
+
+			m_PendingBufferCopies[dstBuffer].push_back(region);
+
+			copied += chunkSize;
+		}
+	}
+
+	void StagingRing::copyToImage(VkImage dstImage, uint32_t width, uint32_t height, void const* data, VkDeviceSize size)
+	{
+		VkDeviceSize const rowSize = size / height;
+		uint32_t const rowsPerChunk = static_cast<uint32_t>(max<VkDeviceSize>(1, getMaxChunkSize() / rowSize));
+
+		uint8_t const* src = static_cast<uint8_t const*>(data);
+
+		for (uint32_t row = 0; row < height; row += rowsPerChunk)
+		{
+			uint32_t const rowCnt = min(rowsPerChunk, height - row);
+			VkDeviceSize const chunkSize = rowSize * rowCnt;
+			VkDeviceSize const offset = reserve(chunkSize);
+
+			memcpy(m_MappedPtr + offset, src + rowSize * row, chunkSize);
+
+			ImageCopy copy = {};
+			copy.image = dstImage;
+			copy.region.bufferOffset = offset;
+			copy.region.bufferRowLength = 0;
+			copy.region.bufferImageHeight = 0;
+			copy.region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copy.region.imageSubresource.mipLevel = 0;
+			copy.region.imageSubresource.baseArrayLayer = 0;
+			copy.region.imageSubresource.layerCount = 1;
+			copy.region.imageOffset = { 0, static_cast<int32_t>(row), 0 };
+			copy.region.imageExtent = { width, rowCnt, 1 };
+			copy.first = row == 0;
+			copy.last = row + rowCnt == height;
+
+			m_PendingImageCopies.push_back(copy);
+		}
+	}
+
+	void StagingRing::copyBuffer(VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size)
+	{
+		//source may not be uploaded yet and destination may still have stale upload of reused range
+		if (m_PendingBufferCopies.count(srcBuffer) > 0 || m_PendingBufferCopies.count(dstBuffer) > 0) flush();
+
+		DeviceCopy copy;
+		copy.srcBuffer = srcBuffer;
+		copy.dstBuffer = dstBuffer;
+		copy.region.srcOffset = srcOffset;
+		copy.region.dstOffset = dstOffset;
+		copy.region.size = size;
+
+		m_PendingDeviceCopies.push_back(copy);
+	}
+
+	void StagingRing::transitionImage(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
+	{
+		ImageTransition transition;
+		transition.image = image;
+		transition.oldLayout = oldLayout;
+		transition.newLayout = newLayout;
+
+		m_PendingImageTransitions.push_back(transition);
+	}
+
+	void StagingRing::copyFromBuffer(VkBuffer srcBuffer, VkDeviceSize srcOffset, void* outData, VkDeviceSize size)
+	{
+		finish();
+
+		uint8_t* dst = static_cast<uint8_t*>(outData);
+
+		for (VkDeviceSize copied = 0; copied < size;)
+		{
+			VkDeviceSize const chunkSize = min(size - copied, getMaxChunkSize());
+			VkDeviceSize const offset = reserve(chunkSize);
+
+			VkCommandBuffer commandBuffer = VulkanHelpers::beginSingleTimeCommands(m_Device, m_CommandPool);
+
+			VkBufferCopy region = {};
+			region.srcOffset = srcOffset + copied;
+			region.dstOffset = offset;
+			region.size = chunkSize;
+
+			vkCmdCopyBuffer(commandBuffer, srcBuffer, m_Buffer, 1, &region);
+
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+			VulkanHelpers::endSingleTimeCommands(m_Device, m_CommandPool, m_Queue, commandBuffer);
+
+			memcpy(dst + copied, m_MappedPtr + offset, chunkSize);
+
+			//nothing else is in flight, whole ring is free again
+			m_Head = m_Tail = 0;
+
+			copied += chunkSize;
+		}
+	}
+
+	void StagingRing::recordUploads(VkCommandBuffer commandBuffer)
+	{
+		//one copy command per destination buffer
+		for (auto const& bufferCopies : m_PendingBufferCopies)
+		{
+			vkCmdCopyBuffer(commandBuffer, m_Buffer, bufferCopies.first, static_cast<uint32_t>(bufferCopies.second.size()), &bufferCopies.second[0]);
+		}
+
+		for (auto const& copy : m_PendingImageCopies)
+		{
+			vkCmdCopyBufferToImage(commandBuffer, m_Buffer, copy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy.region);
+		}
+	}
+
+	void StagingRing::getOwnershipBarriers(vector<VkBufferMemoryBarrier>& outBufferBarriers, vector<VkImageMemoryBarrier>& outImageBarriers) const
+	{
+		//only uploaded ranges change owner, rest of buffer (e.g. other meshes of pool) stays with graphics family
+		for (auto const& bufferCopies : m_PendingBufferCopies)
+		{
+			for (auto const& region : bufferCopies.second)
+			{
+				VkBufferMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				barrier.srcQueueFamilyIndex = m_TransferQueueFamilyIndex;
+				barrier.dstQueueFamilyIndex = m_QueueFamilyIndex;
+				barrier.buffer = bufferCopies.first;
+				barrier.offset = region.dstOffset;
+				barrier.size = region.size;
+
+				outBufferBarriers.push_back(barrier);
+			}
+		}
+
+		for (auto const& copy : m_PendingImageCopies)
+		{
+			if (!copy.last) continue;
+
+			VkImageMemoryBarrier barrier = imageBarrier(copy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, 0);
+			barrier.srcQueueFamilyIndex = m_TransferQueueFamilyIndex;
+			barrier.dstQueueFamilyIndex = m_QueueFamilyIndex;
+
+			outImageBarriers.push_back(barrier);
+		}
+	}
+
+	void StagingRing::flush()
+	{
+		if (!hasPendingCopies()) return;
+
+		bool const transferQueueUsed = hasDedicatedTransferQueue() && (!m_PendingBufferCopies.empty() || !m_PendingImageCopies.empty());
+
+		VkAccessFlags const readAccess = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+		VkCommandBuffer commandBuffer = VulkanHelpers::beginSingleTimeCommands(m_Device, m_CommandPool);
+
+		{	//earlier GPU work may still read or write destinations (e.g. particles updated by compute)
+			VkMemoryBarrier memoryBarrier = {};
+			memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+			memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+			vector<VkImageMemoryBarrier> imageBarriers;
+			for (auto const& copy : m_PendingImageCopies)
+			{
+				if (copy.first && !transferQueueUsed) imageBarriers.push_back(imageBarrier(copy.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+			}
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, nullptr,
+				static_cast<uint32_t>(imageBarriers.size()), imageBarriers.empty() ? nullptr : &imageBarriers[0]);
+		}
+
+		for (auto const& copy : m_PendingDeviceCopies)
+		{
+			vkCmdCopyBuffer(commandBuffer, copy.srcBuffer, copy.dstBuffer, 1, &copy.region);
+		}
+
+		VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
+		vector<VkBufferMemoryBarrier> acquireBufferBarriers;
+		vector<VkImageMemoryBarrier> acquireImageBarriers;
+
+		if (transferQueueUsed)
+		{
+			transferCommandBuffer = VulkanHelpers::beginSingleTimeCommands(m_Device, m_TransferCommandPool);
+
+			//destinations are not used by GPU yet, only images need layout for copy
+			vector<VkImageMemoryBarrier> imageBarriers;
+			for (auto const& copy : m_PendingImageCopies)
+			{
+				if (copy.first) imageBarriers.push_back(imageBarrier(copy.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+			}
+
+			if (!imageBarriers.empty())
+			{
+				vkCmdPipelineBarrier(transferCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+					static_cast<uint32_t>(imageBarriers.size()), &imageBarriers[0]);
+			}
+
+			recordUploads(transferCommandBuffer);
+
+			//release half of ownership transfer
+			vector<VkBufferMemoryBarrier> releaseBufferBarriers;
+			vector<VkImageMemoryBarrier> releaseImageBarriers;
+			getOwnershipBarriers(releaseBufferBarriers, releaseImageBarriers);
+
+			for (auto& barrier : releaseBufferBarriers) barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			for (auto& barrier : releaseImageBarriers) barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+			vkCmdPipelineBarrier(transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+				static_cast<uint32_t>(releaseBufferBarriers.size()), releaseBufferBarriers.empty() ? nullptr : &releaseBufferBarriers[0],
+				static_cast<uint32_t>(releaseImageBarriers.size()), releaseImageBarriers.empty() ? nullptr : &releaseImageBarriers[0]);
+
+			auto res = vkEndCommandBuffer(transferCommandBuffer);
+			assert(res == VK_SUCCESS);
+
+			//acquire half is part of trailing barrier on graphics queue
+			getOwnershipBarriers(acquireBufferBarriers, acquireImageBarriers);
+
+			for (auto& barrier : acquireBufferBarriers) barrier.dstAccessMask = readAccess;
+			for (auto& barrier : acquireImageBarriers) barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		}
+		else recordUploads(commandBuffer);
+
+		{	//make uploads visible to every later consumer in queue
+			VkMemoryBarrier memoryBarrier = {};
+			memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memoryBarrier.dstAccessMask = readAccess;
+
+			vector<VkImageMemoryBarrier> imageBarriers = acquireImageBarriers;
+			for (auto const& copy : m_PendingImageCopies)
+			{
+				if (copy.last && !transferQueueUsed) imageBarriers.push_back(imageBarrier(copy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+			}
+
+			//content is not preserved, previous users are ordered by leading barrier
+			for (auto const& transition : m_PendingImageTransitions)
+			{
+				imageBarriers.push_back(imageBarrier(transition.image, transition.oldLayout, transition.newLayout, 0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT));
+			}
+
+			VkPipelineStageFlags const dstStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStages, 0, 1, &memoryBarrier,
+				static_cast<uint32_t>(acquireBufferBarriers.size()), acquireBufferBarriers.empty() ? nullptr : &acquireBufferBarriers[0],
+				static_cast<uint32_t>(imageBarriers.size()), imageBarriers.empty() ? nullptr : &imageBarriers[0]);
+		}
+
+		auto res = vkEndCommandBuffer(commandBuffer);
+		assert(res == VK_SUCCESS);
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		Submission submission;
+		submission.commandBuffer = commandBuffer;
+		submission.transferCommandBuffer = transferCommandBuffer;
+		submission.semaphore = VK_NULL_HANDLE;
+		submission.end = m_Head;
+		submission.id = ++m_SubmissionCnt;
+
+		res = vkCreateFence(m_Device, &fenceInfo, nullptr, &submission.fence);
+		assert(res == VK_SUCCESS);
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+
+		//acquire barriers chain with semaphore wait in transfer stage
+		VkPipelineStageFlags const waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		if (transferQueueUsed)
+		{
+			VkSemaphoreCreateInfo semaphoreInfo = {};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+			res = vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &submission.semaphore);
+			assert(res == VK_SUCCESS);
+
+			VkSubmitInfo transferSubmitInfo = {};
+			transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			transferSubmitInfo.commandBufferCount = 1;
+			transferSubmitInfo.pCommandBuffers = &transferCommandBuffer;
+			transferSubmitInfo.signalSemaphoreCount = 1;
+			transferSubmitInfo.pSignalSemaphores = &submission.semaphore;
+
+			res = vkQueueSubmit(m_TransferQueue, 1, &transferSubmitInfo, VK_NULL_HANDLE);
+			assert(res == VK_SUCCESS);
+
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &submission.semaphore;
+			submitInfo.pWaitDstStageMask = &waitStage;
+		}
+
+		res = vkQueueSubmit(m_Queue, 1, &submitInfo, submission.fence);
+		assert(res == VK_SUCCESS);
+
+		m_Submissions.push_back(submission);
+
+		m_PendingBufferCopies.clear();
+		m_PendingImageCopies.clear();
+		m_PendingDeviceCopies.clear();
+		m_PendingImageTransitions.clear();
+	}
+
+	void StagingRing::finish()
+	{
+		flush();
+
+		while (!m_Submissions.empty()) retireSubmissions(true);
+	}
+
+	uint64_t StagingRing::getTicket() const
+	{
+		return hasPendingCopies() ? m_SubmissionCnt + 1 : m_SubmissionCnt;
+	}
+
+	void StagingRing::wait(uint64_t ticket)
+	{
+		if (ticket > m_SubmissionCnt) flush();
+
+		//submissions finish in order, later ones are left running
+		while (!m_Submissions.empty() && m_Submissions.front().id <= ticket) retireSubmissions(true);
+	}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "VulkanHelper.h"
+
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//Persistently mapped host visible ring buffer, uploads into device local buffers and images are recorded
+//into one command buffer per flush and ring space is reused once fence of that submission is signaled.
+//With dedicated transfer queue family uploads run on transfer queue, uploaded ranges are released to graphics family
+//and acquired by small graphics submission waiting on semaphore, so copies don't occupy graphics queue.
+//Upload destinations must not be in use by GPU (new resources or retired ranges), transfer queue is not ordered with frames.
+class StagingRing
+{
+public:
+	StagingRing(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue queue, uint32_t queueFamilyIndex,
+		VkCommandPool transferCommandPool, VkQueue transferQueue, uint32_t transferQueueFamilyIndex, VkDeviceSize size = DEFAULT_SIZE);
+	~StagingRing();
+	StagingRing(StagingRing const&) = delete;
+	StagingRing& operator=(StagingRing const&) = delete;
+
+	//data is copied to ring immediately, GPU copy is deferred until flush
+	void copyToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, void const* data, VkDeviceSize size);
+
+	//whole mip 0 of RGBA8 image, image ends in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	void copyToImage(VkImage dstImage, uint32_t width, uint32_t height, void const* data, VkDeviceSize size);
+
+	//GPU side copy between device buffers, always on graphics queue, recorded before uploads of the same flush
+	void copyBuffer(VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size);
+
+	//layout transition of color image without upload (e.g. storage image to GENERAL), recorded after copies of the same flush
+	void transitionImage(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
+
+	//blocking read back, waits for all pending uploads first
+	void copyFromBuffer(VkBuffer srcBuffer, VkDeviceSize srcOffset, void* outData, VkDeviceSize size);
+
+	//submits pending copies, has to be called before first use of uploaded resources on GPU
+	void flush();
+
+	//flush and wait until all uploads are finished (e.g. resource is used by other queue)
+	void finish();
+
+	//id of submission which will carry everything recorded so far, later wait(ticket) blocks only until that submission is done
+	uint64_t getTicket() const;
+	void wait(uint64_t ticket);
+
+	VkDeviceSize getSize() const;
+	bool hasDedicatedTransferQueue() const;
+
+	static const VkDeviceSize DEFAULT_SIZE = 32 * 1024 * 1024;
+
+private:
+	struct Submission
+	{
+		VkFence fence; //of graphics submission, which waits for transfer submission
+		VkCommandBuffer commandBuffer;
+		VkCommandBuffer transferCommandBuffer; //VK_NULL_HANDLE when nothing was uploaded on transfer queue
+		VkSemaphore semaphore;
+		VkDeviceSize end; //ring offset released by this submission
+		uint64_t id;
+	};
+
+	//big images are split into row bands, layout transitions are recorded only with first and last band
+	struct ImageCopy
+	{
+		VkImage image;
+		VkBufferImageCopy region;
+		bool first;
+		bool last;
+	};
+
+	struct DeviceCopy
+	{
+		VkBuffer srcBuffer;
+		VkBuffer dstBuffer;
+		VkBufferCopy region;
+	};
+
+	struct ImageTransition
+	{
+		VkImage image;
+		VkImageLayout oldLayout;
+		VkImageLayout newLayout;
+	};
+
+	static const VkDeviceSize ALIGNMENT = 256; //covers optimalBufferCopyOffsetAlignment of common GPUs and texel size
+
+	//returns ring offset of size bytes, waits for oldest submissions if ring is full
+	VkDeviceSize reserve(VkDeviceSize size);
+	bool tryReserve(VkDeviceSize size, VkDeviceSize& outOffset);
+	void retireSubmissions(bool waitOldest);
+	bool hasPendingCopies() const;
+	void recordUploads(VkCommandBuffer commandBuffer);
+
+	//ownership transfer of uploaded ranges from transfer to graphics family, same barriers are recorded on both queues
+	void getOwnershipBarriers(vector<VkBufferMemoryBarrier>& outBufferBarriers, vector<VkImageMemoryBarrier>& outImageBarriers) const;
+
+	//uploads bigger than this are split, so one upload never has to wait for itself
+	VkDeviceSize getMaxChunkSize() const;
+
+	VkPhysicalDevice m_PhysicalDevice;
+	VkDevice m_Device;
+	VkCommandPool m_CommandPool;
+	VkQueue m_Queue;
+	uint32_t m_QueueFamilyIndex;
+	VkCommandPool m_TransferCommandPool;
+	VkQueue m_TransferQueue;
+	uint32_t m_TransferQueueFamilyIndex;
+
+	VkBuffer m_Buffer;
+	MemoryAllocation m_Memory;
+	uint8_t* m_MappedPtr;
+	VkDeviceSize m_Size;
+
+	VkDeviceSize m_Head = 0; //next free byte
+	VkDeviceSize m_Tail = 0; //first byte still used by pending or in flight copies, ring is empty when equal to m_Head
+
+	unordered_map<VkBuffer, vector<VkBufferCopy>> m_PendingBufferCopies;
+	vector<ImageCopy> m_PendingImageCopies;
+	vector<DeviceCopy> m_PendingDeviceCopies;
+	vector<ImageTransition> m_PendingImageTransitions;
+	deque<Submission> m_Submissions;
+	uint64_t m_SubmissionCnt = 0; //id of last submission
+};
@@ -5,12 +5,10 @@
 using namespace std;
 
 
-	TextureManager::TextureManager(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue graphicQueue)
+	TextureManager::TextureManager(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing):m_StagingRing(stagingRing)
 	{
 		m_PhysicalDevice = physicalDevice;
 		m_Device = device;
-		m_CommandPool = commandPool;
-		m_GraphicQueue = graphicQueue;
 	}
 
 	TextureManager::~TextureManager()
@@ -30,7 +28,7 @@ using namespace std;
 			TextureData* newTexture = new TextureData();
 			newTexture->path = path;
 
-			VulkanHelpers::createTextureImage(m_PhysicalDevice, m_CommandPool, m_GraphicQueue, newTexture->image, newTexture->deviceMemory, path.c_str(), m_Device, VK_FORMAT_R8G8B8A8_UNORM);
+			VulkanHelpers::createTextureImage(m_PhysicalDevice, m_StagingRing, newTexture->image, newTexture->deviceMemory, path.c_str(), m_Device, VK_FORMAT_R8G8B8A8_UNORM);
 			VulkanHelpers::createImageView(newTexture->imageView, m_Device, newTexture->image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
 
 			TextureDataSharedPtr sharedPtr(newTexture, [this](TextureData* texData)
@@ -38,7 +36,7 @@ using namespace std;
 					//free GPU memory
 					vkDestroyImageView(m_Device, texData->imageView, nullptr);
 					vkDestroyImage(m_Device, texData->image, nullptr);
-					vkFreeMemory(m_Device, texData->deviceMemory, nullptr);
+					MemoryAllocator::get(m_Device).free(texData->deviceMemory);
 
 					//remove from database
 					m_TextureData.erase(texData->path);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "VulkanHelper.h"
+#include "StagingRing.h"
 
 #include <string>
 #include <unordered_map>
@@ -11,7 +12,7 @@ struct TextureData
 {
 	VkImageView imageView;
 	VkImage image;
-	VkDeviceMemory deviceMemory;
+	MemoryAllocation deviceMemory;
 	string path;
 };
 
@@ -20,14 +21,13 @@ using TextureDataSharedPtr = shared_ptr<const TextureData>;
 class TextureManager
 {
 public:
-	TextureManager(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue graphicQueue);
+	TextureManager(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing);
 	~TextureManager();
 	TextureDataSharedPtr loadTexture(string const& path);
 
 private:
 	VkPhysicalDevice m_PhysicalDevice;
-	VkCommandPool m_CommandPool;
-	VkQueue m_GraphicQueue;
+	StagingRing& m_StagingRing;
 	VkDevice m_Device;
 
 	unordered_map<string, weak_ptr <const TextureData> > m_TextureData;
@@ -0,0 +1,53 @@
+
+#include "UniformRing.h"
+
+#include <assert.h>
+#include <cstring>
+
+using namespace std;
+
+
+	UniformRing::UniformRing(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t frameCnt, VkDeviceSize sliceSize) : m_Device(device)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		m_Alignment = properties.limits.minUniformBufferOffsetAlignment;
+
+		m_SliceSize = (sliceSize + m_Alignment - 1) / m_Alignment * m_Alignment;
+
+		VulkanHelpers::allocateBuffer(m_Buffer, m_Memory, physicalDevice, m_Device, m_SliceSize * frameCnt, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_MappedPtr = static_cast<uint8_t*>(m_Memory.mappedPtr);
+	}
+
+	UniformRing::~UniformRing()
+	{
+		vkDestroyBuffer(m_Device, m_Buffer, nullptr);
+		MemoryAllocator::get(m_Device).free(m_Memory);
+	}
+
+	void UniformRing::beginFrame(uint32_t frameIdx)
+	{
+		m_SliceBegin = m_Head = m_SliceSize * frameIdx;
+	}
+
+	uint32_t UniformRing::allocate(void const* data, VkDeviceSize size)
+	{
+		VkDeviceSize const offset = (m_Head + m_Alignment - 1) / m_Alignment * m_Alignment;
+		assert(offset + size <= m_SliceBegin + m_SliceSize && "Uniform ring slice overflow!");
+
+		memcpy(m_MappedPtr + offset, data, size);
+		m_Head = offset + size;
+
+		return static_cast<uint32_t>(offset);
+	}
+
+	void* UniformRing::getMappedData(uint32_t offset) const
+	{
+		assert(offset >= m_SliceBegin && offset < m_Head);
+		return m_MappedPtr + offset;
+	}
+
+	VkBuffer UniformRing::getBuffer() const
+	{
+		return m_Buffer;
+	}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "VulkanHelper.h"
+
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+//Persistently mapped host visible uniform buffer with one slice per frame in flight, per frame data is appended
+//to slice of current frame and bound through VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC offsets
+class UniformRing
+{
+public:
+	UniformRing(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t frameCnt, VkDeviceSize sliceSize = DEFAULT_SLICE_SIZE);
+	~UniformRing();
+	UniformRing(UniformRing const&) = delete;
+	UniformRing& operator=(UniformRing const&) = delete;
+
+	//slice of frameIdx is reused, fence of frame which used it last has to be already waited
+	void beginFrame(uint32_t frameIdx);
+
+	//copies data into current slice, returns dynamic offset
+	uint32_t allocate(void const* data, VkDeviceSize size);
+
+	template<typename T> uint32_t push(T const& data)
+	{
+		return allocate(&data, sizeof(T));
+	}
+
+	//mapped memory of data allocated in current slice, can be rewritten until frame is submitted (late latching)
+	void* getMappedData(uint32_t offset) const;
+
+	VkBuffer getBuffer() const;
+
+	static const VkDeviceSize DEFAULT_SLICE_SIZE = 1024 * 1024;
+
+private:
+	VkDevice m_Device;
+
+	VkBuffer m_Buffer;
+	MemoryAllocation m_Memory;
+	uint8_t* m_MappedPtr;
+
+	VkDeviceSize m_SliceSize;
+	VkDeviceSize m_Alignment; //minUniformBufferOffsetAlignment
+	VkDeviceSize m_SliceBegin = 0;
+	VkDeviceSize m_Head = 0;
+};
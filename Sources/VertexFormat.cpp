@@ -1,6 +1,67 @@
 
 #include "VertexFormat.h"
 
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <limits>
+
+namespace
+{
+	//octahedral mapping of unit vector to [-1, 1]^2
+	glm::vec2 octEncode(glm::vec3 const& v)
+	{
+		float const l1Norm = glm::abs(v.x) + glm::abs(v.y) + glm::abs(v.z);
+		if (l1Norm == 0.0f) return glm::vec2(0.0f);
+
+		glm::vec3 const n = v / l1Norm;
+		if (n.z >= 0.0f) return glm::vec2(n.x, n.y);
+
+		return glm::vec2((1.0f - glm::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f), (1.0f - glm::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+	}
+
+	glm::vec3 octDecode(glm::vec2 const& p)
+	{
+		glm::vec3 n(p.x, p.y, 1.0f - glm::abs(p.x) - glm::abs(p.y));
+		if (n.z < 0.0f)
+		{
+			n.x = (1.0f - glm::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f);
+			n.y = (1.0f - glm::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f);
+		}
+
+		return glm::normalize(n);
+	}
+
+	//orthonormal tangent frame, returns sign of bitangent relative to cross(normal, tangent)
+	float orthonormalize(Vertex const& vertex, glm::vec3& normal, glm::vec3& tangent)
+	{
+		normal = glm::length(vertex.normal) > 0.0f ? glm::normalize(vertex.normal) : glm::vec3(0.0f, 0.0f, 1.0f);
+		tangent = vertex.tangent - normal * glm::dot(normal, vertex.tangent);
+
+		if (!(glm::length(tangent) > 1e-6f)) //also catches NaN from degenerate UVs
+		{
+			tangent = glm::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			tangent = tangent - normal * glm::dot(normal, tangent);
+		}
+
+		tangent = glm::normalize(tangent);
+
+		return glm::dot(glm::cross(normal, tangent), vertex.bitangent) < 0.0f ? -1.0f : 1.0f;
+	}
+
+	template<typename T> vector<Vertex> decode(void const* data, size_t vertexCnt)
+	{
+		T const* encoded = static_cast<T const*>(data);
+
+		vector<Vertex> vertices;
+		vertices.reserve(vertexCnt);
+
+		for (size_t i = 0; i < vertexCnt; ++i) vertices.push_back(encoded[i].toVertex());
+
+		return vertices;
+	}
+}
+
 
 	VkVertexInputBindingDescription Vertex::getBindingDescription()
 	{
@@ -49,3 +110,265 @@
 		return attributeDescriptions;
 	}
 
+
+	VkVertexInputBindingDescription VertexOct::getBindingDescription()
+	{
+		VkVertexInputBindingDescription bindingDescription = {};
+		bindingDescription.binding = 0;
+		bindingDescription.stride = sizeof(VertexOct);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescription;
+	}
+
+	array<VkVertexInputAttributeDescription, 4> VertexOct::getAttributeDescriptions()
+	{
+		array<VkVertexInputAttributeDescription, 4> attributeDescriptions = {};
+
+		attributeDescriptions[0].binding = 0;
+		attributeDescriptions[0].location = 0;
+		attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+		attributeDescriptions[0].offset = offsetof(VertexOct, pos);
+
+		attributeDescriptions[1].binding = 0;
+		attributeDescriptions[1].location = 2;
+		attributeDescriptions[1].format = VK_FORMAT_R16G16_SFLOAT;
+		attributeDescriptions[1].offset = offsetof(VertexOct, texCoord);
+
+		attributeDescriptions[2].binding = 0;
+		attributeDescriptions[2].location = 3;
+		attributeDescriptions[2].format = VK_FORMAT_R16G16_SNORM;
+		attributeDescriptions[2].offset = offsetof(VertexOct, normal);
+
+		attributeDescriptions[3].binding = 0;
+		attributeDescriptions[3].location = 4;
+		attributeDescriptions[3].format = VK_FORMAT_R8G8B8A8_SNORM;
+		attributeDescriptions[3].offset = offsetof(VertexOct, tangent);
+
+		return attributeDescriptions;
+	}
+
+	VertexOct VertexOct::fromVertex(Vertex const& vertex)
+	{
+		glm::vec3 normal, tangent;
+		float const bitangentSign = orthonormalize(vertex, normal, tangent);
+
+		glm::vec2 const octNormal = octEncode(normal);
+		glm::vec2 const octTangent = octEncode(tangent);
+
+		VertexOct result;
+		result.pos = vertex.pos;
+		result.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+		result.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+		result.normal[0] = static_cast<int16_t>(glm::packSnorm1x16(octNormal.x));
+		result.normal[1] = static_cast<int16_t>(glm::packSnorm1x16(octNormal.y));
+		result.tangent[0] = static_cast<int8_t>(glm::packSnorm1x8(octTangent.x));
+		result.tangent[1] = static_cast<int8_t>(glm::packSnorm1x8(octTangent.y));
+		result.tangent[2] = static_cast<int8_t>(glm::packSnorm1x8(bitangentSign));
+		result.tangent[3] = 0;
+
+		return result;
+	}
+
+	Vertex VertexOct::toVertex() const
+	{
+		Vertex result;
+		result.pos = pos;
+		result.color = glm::vec3(1.0f, 1.0f, 1.0f);
+		result.texCoord = glm::vec2(glm::unpackHalf1x16(texCoord[0]), glm::unpackHalf1x16(texCoord[1]));
+		result.normal = octDecode(glm::vec2(glm::unpackSnorm1x16(static_cast<uint16_t>(normal[0])), glm::unpackSnorm1x16(static_cast<uint16_t>(normal[1]))));
+		result.tangent = octDecode(glm::vec2(glm::unpackSnorm1x8(static_cast<uint8_t>(tangent[0])), glm::unpackSnorm1x8(static_cast<uint8_t>(tangent[1]))));
+		result.bitangent = glm::cross(result.normal, result.tangent) * (tangent[2] < 0 ? -1.0f : 1.0f);
+
+		return result;
+	}
+
+	VkVertexInputBindingDescription VertexQTangent::getBindingDescription()
+	{
+		VkVertexInputBindingDescription bindingDescription = {};
+		bindingDescription.binding = 0;
+		bindingDescription.stride = sizeof(VertexQTangent);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescription;
+	}
+
+	array<VkVertexInputAttributeDescription, 3> VertexQTangent::getAttributeDescriptions()
+	{
+		array<VkVertexInputAttributeDescription, 3> attributeDescriptions = {};
+
+		attributeDescriptions[0].binding = 0;
+		attributeDescriptions[0].location = 0;
+		attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+		attributeDescriptions[0].offset = offsetof(VertexQTangent, pos);
+
+		attributeDescriptions[1].binding = 0;
+		attributeDescriptions[1].location = 2;
+		attributeDescriptions[1].format = VK_FORMAT_R16G16_SFLOAT;
+		attributeDescriptions[1].offset = offsetof(VertexQTangent, texCoord);
+
+		attributeDescriptions[2].binding = 0;
+		attributeDescriptions[2].location = 3;
+		attributeDescriptions[2].format = VK_FORMAT_R16G16B16A16_SNORM;
+		attributeDescriptions[2].offset = offsetof(VertexQTangent, qTangent);
+
+		return attributeDescriptions;
+	}
+
+	VertexQTangent VertexQTangent::fromVertex(Vertex const& vertex)
+	{
+		glm::vec3 normal, tangent;
+		float const bitangentSign = orthonormalize(vertex, normal, tangent);
+
+		//rotation of (x, y, z) axes to (tangent, bitangent, normal)
+		glm::quat q = glm::normalize(glm::quat_cast(glm::mat3(tangent, glm::cross(normal, tangent), normal)));
+		if (q.w < 0.0f) q = -q;
+
+		//w must not quantize to zero, its sign carries bitangent sign
+		float const bias = 1.0f / 32767.0f;
+		if (q.w < bias)
+		{
+			float const xyzScale = sqrt(1.0f - bias * bias) / glm::length(glm::vec3(q.x, q.y, q.z));
+			q = glm::quat(bias, q.x * xyzScale, q.y * xyzScale, q.z * xyzScale);
+		}
+
+		if (bitangentSign < 0.0f) q = -q;
+
+		VertexQTangent result;
+		result.pos = vertex.pos;
+		result.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+		result.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+		result.qTangent[0] = static_cast<int16_t>(glm::packSnorm1x16(q.x));
+		result.qTangent[1] = static_cast<int16_t>(glm::packSnorm1x16(q.y));
+		result.qTangent[2] = static_cast<int16_t>(glm::packSnorm1x16(q.z));
+		result.qTangent[3] = static_cast<int16_t>(glm::packSnorm1x16(q.w));
+
+		return result;
+	}
+
+	Vertex VertexQTangent::toVertex() const
+	{
+		glm::quat q(glm::unpackSnorm1x16(static_cast<uint16_t>(qTangent[3])), glm::unpackSnorm1x16(static_cast<uint16_t>(qTangent[0])),
+			glm::unpackSnorm1x16(static_cast<uint16_t>(qTangent[1])), glm::unpackSnorm1x16(static_cast<uint16_t>(qTangent[2])));
+		q = glm::normalize(q);
+
+		Vertex result;
+		result.pos = pos;
+		result.color = glm::vec3(1.0f, 1.0f, 1.0f);
+		result.texCoord = glm::vec2(glm::unpackHalf1x16(texCoord[0]), glm::unpackHalf1x16(texCoord[1]));
+		result.tangent = glm::vec3(1.0f - 2.0f * (q.y * q.y + q.z * q.z), 2.0f * (q.x * q.y + q.w * q.z), 2.0f * (q.x * q.z - q.w * q.y));
+		result.normal = glm::vec3(2.0f * (q.x * q.z + q.w * q.y), 2.0f * (q.y * q.z - q.w * q.x), 1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+		result.bitangent = glm::cross(result.normal, result.tangent) * (q.w < 0.0f ? -1.0f : 1.0f);
+
+		return result;
+	}
+
+	VkVertexInputBindingDescription VertexFormat::getBindingDescription(VertexFormatType type)
+	{
+		switch (type)
+		{
+		case VertexFormatType::OCTAHEDRAL: return VertexOct::getBindingDescription();
+		case VertexFormatType::QTANGENT: return VertexQTangent::getBindingDescription();
+		default: return Vertex::getBindingDescription();
+		}
+	}
+
+	vector<VkVertexInputAttributeDescription> VertexFormat::getAttributeDescriptions(VertexFormatType type)
+	{
+		switch (type)
+		{
+		case VertexFormatType::OCTAHEDRAL:
+		{
+			auto attributes = VertexOct::getAttributeDescriptions();
+			return vector<VkVertexInputAttributeDescription>(begin(attributes), end(attributes));
+		}
+		case VertexFormatType::QTANGENT:
+		{
+			auto attributes = VertexQTangent::getAttributeDescriptions();
+			return vector<VkVertexInputAttributeDescription>(begin(attributes), end(attributes));
+		}
+		default:
+		{
+			auto attributes = Vertex::getAttributeDescriptions();
+			return vector<VkVertexInputAttributeDescription>(begin(attributes), end(attributes));
+		}
+		}
+	}
+
+	VkVertexInputBindingDescription VertexFormat::getPositionBindingDescription(PositionFormatType type)
+	{
+		VkVertexInputBindingDescription bindingDescription = {};
+		bindingDescription.binding = 0;
+		bindingDescription.stride = type == PositionFormatType::UNORM16 ? sizeof(PositionUnorm16) : sizeof(PositionFloat);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescription;
+	}
+
+	VkVertexInputAttributeDescription VertexFormat::getPositionAttributeDescription(PositionFormatType type)
+	{
+		VkVertexInputAttributeDescription attributeDescription = {};
+		attributeDescription.binding = 0;
+		attributeDescription.location = 0;
+		attributeDescription.format = type == PositionFormatType::UNORM16 ? VK_FORMAT_R16G16B16A16_UNORM : VK_FORMAT_R32G32B32_SFLOAT;
+		attributeDescription.offset = 0;
+
+		return attributeDescription;
+	}
+
+	vector<PositionUnorm16> VertexFormat::quantizePositions(vector<Vertex> const& vertices, glm::mat4& outDequantization)
+	{
+		glm::vec3 minPos(numeric_limits<float>::max());
+		glm::vec3 maxPos(-numeric_limits<float>::max());
+
+		for (auto const& vertex : vertices)
+		{
+			minPos = glm::min(minPos, vertex.pos);
+			maxPos = glm::max(maxPos, vertex.pos);
+		}
+
+		glm::vec3 extent = maxPos - minPos;
+		for (int i = 0; i < 3; ++i)
+		{
+			if (!(extent[i] > 0.0f)) extent[i] = 1.0f;
+		}
+
+		outDequantization = glm::mat4(1.0f);
+		outDequantization[0][0] = extent.x;
+		outDequantization[1][1] = extent.y;
+		outDequantization[2][2] = extent.z;
+		outDequantization[3] = glm::vec4(vertices.empty() ? glm::vec3(0.0f) : minPos, 1.0f);
+
+		vector<PositionUnorm16> quantized;
+		quantized.reserve(vertices.size());
+
+		for (auto const& vertex : vertices)
+		{
+			glm::vec3 const normalized = (vertex.pos - minPos) / extent;
+
+			PositionUnorm16 position;
+			position.pos[0] = glm::packUnorm1x16(normalized.x);
+			position.pos[1] = glm::packUnorm1x16(normalized.y);
+			position.pos[2] = glm::packUnorm1x16(normalized.z);
+			position.pos[3] = 0;
+
+			quantized.push_back(position);
+		}
+
+		return quantized;
+	}
+
+	size_t VertexFormat::getStride(VertexFormatType type)
+	{
+		return getBindingDescription(type).stride;
+	}
+
+	vector<Vertex> VertexFormat::decodeVertices(VertexFormatType type, void const* data, size_t vertexCnt)
+	{
+		switch (type)
+		{
+		case VertexFormatType::OCTAHEDRAL: return decode<VertexOct>(data, vertexCnt);
+		case VertexFormatType::QTANGENT: return decode<VertexQTangent>(data, vertexCnt);
+		default: return decode<Vertex>(data, vertexCnt);
+		}
+	}
@@ -2,11 +2,22 @@
 
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
+#include <glm/mat4x4.hpp>
 #include <vulkan/vulkan.h>
 
 #include <array>
+#include <vector>
+#include <stdint.h>
 using namespace std;
 
+enum class VertexFormatType
+{
+	FULL,		//Vertex, 68 bytes of fp32
+	OCTAHEDRAL,	//VertexOct, 24 bytes: oct encoded normal and tangent, half float UV
+	QTANGENT	//VertexQTangent, 24 bytes: tangent frame as quaternion, half float UV
+};
+
+//Uncompressed vertex, every other format is converted from it
 struct Vertex
 {
 	glm::vec3 pos;
@@ -16,6 +27,95 @@ struct Vertex
 	glm::vec3 tangent;
 	glm::vec3 bitangent;
 
+	static const VertexFormatType s_Type = VertexFormatType::FULL;
+
 	static VkVertexInputBindingDescription getBindingDescription();
 	static array<VkVertexInputAttributeDescription, 6> getAttributeDescriptions();
+
+	static Vertex fromVertex(Vertex const& vertex) { return vertex; }
+	Vertex toVertex() const { return *this; }
+};
+
+//No color, normal stored as octahedral snorm16x2, tangent as octahedral snorm8x2 + bitangent sign
+struct VertexOct
+{
+	glm::vec3 pos;
+	uint16_t texCoord[2]; //half float
+	int16_t normal[2];
+	int8_t tangent[4]; //xy octahedral, z bitangent sign, w unused
+
+	static const VertexFormatType s_Type = VertexFormatType::OCTAHEDRAL;
+
+	static VkVertexInputBindingDescription getBindingDescription();
+	static array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions();
+
+	static VertexOct fromVertex(Vertex const& vertex);
+	Vertex toVertex() const;
+};
+
+//No color, whole tangent frame stored as snorm16 quaternion, sign of w is bitangent sign
+struct VertexQTangent
+{
+	glm::vec3 pos;
+	uint16_t texCoord[2]; //half float
+	int16_t qTangent[4];
+
+	static const VertexFormatType s_Type = VertexFormatType::QTANGENT;
+
+	static VkVertexInputBindingDescription getBindingDescription();
+	static array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions();
+
+	static VertexQTangent fromVertex(Vertex const& vertex);
+	Vertex toVertex() const;
+};
+
+enum class PositionFormatType
+{
+	FLOAT,	//PositionFloat, 12 bytes
+	UNORM16	//PositionUnorm16, 8 bytes normalized to mesh bounding box
+};
+
+//Element of separate position stream used by depth only passes
+struct PositionFloat
+{
+	glm::vec3 pos;
+
+	static const PositionFormatType s_Type = PositionFormatType::FLOAT;
+
+	static PositionFloat fromVertex(Vertex const& vertex) { return { vertex.pos }; }
+};
+
+struct PositionUnorm16
+{
+	uint16_t pos[4]; //w unused, keeps attribute 4 byte aligned
+
+	static const PositionFormatType s_Type = PositionFormatType::UNORM16;
+};
+
+//Runtime selection of vertex format, position is always location 0 at offset 0
+class VertexFormat
+{
+public:
+	static VkVertexInputBindingDescription getBindingDescription(VertexFormatType type);
+	static vector<VkVertexInputAttributeDescription> getAttributeDescriptions(VertexFormatType type);
+	static VkVertexInputBindingDescription getPositionBindingDescription(PositionFormatType type);
+	static VkVertexInputAttributeDescription getPositionAttributeDescription(PositionFormatType type = PositionFormatType::FLOAT);
+
+	static size_t getStride(VertexFormatType type);
+
+	//decodes vertexCnt vertices of given format (e.g. mapped vertex buffer)
+	static vector<Vertex> decodeVertices(VertexFormatType type, void const* data, size_t vertexCnt);
+
+	//positions relative to bounding box of vertices, outDequantization transforms them back to object space
+	static vector<PositionUnorm16> quantizePositions(vector<Vertex> const& vertices, glm::mat4& outDequantization);
+
+	template<typename T> static vector<T> encodeVertices(vector<Vertex> const& vertices)
+	{
+		vector<T> encoded;
+		encoded.reserve(vertices.size());
+
+		for (auto const& vertex : vertices) encoded.push_back(T::fromVertex(vertex));
+
+		return encoded;
+	}
 };
@@ -3,6 +3,8 @@
 #include "SceneObject.h"
 #include "ModelManager.h"
 #include <vector>
+#include <algorithm>
+#include <glm/glm.hpp>
 
 using namespace std;
 
@@ -27,20 +29,52 @@ public:
 		m_ModelData = model;
 	}
 
-	void draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const
+	//pixels per object space unit at position of object, used to project LOD error to screen
+	static float calculateLodErrorScale(glm::mat4 const& modelMatrix, glm::vec3 const& viewPos, glm::mat4 const& projectionMatrix, float viewportHeight)
+	{
+		glm::vec3 const objectPos = modelMatrix[3];
+		float const scale = max(glm::length(glm::vec3(modelMatrix[0])), max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+		float const distance = max(glm::length(objectPos - viewPos), 1.0f);
+
+		return scale * glm::abs(projectionMatrix[1][1]) * 0.5f * viewportHeight / distance;
+	}
+
+	//meshVisibility - per mesh flags from FrustumCuller, nullptr draws all meshes
+	void draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, float lodErrorScale, float lodPixelThreshold, GeometryBindings& bindings, uint8_t const* meshVisibility = nullptr) const
 	{
 		for (size_t i = 0; i < m_ModelData->meshes.size(); ++i)
 		{
+			if (meshVisibility && !meshVisibility[i]) continue;
+
 			auto descriptorSet = m_ModelData->materials[i]->m_ShaderParams.getDescriptorSet();
 			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
 
-			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_ModelData->meshes[i].vertexBuffer.buffer, offsets);
-
-			vkCmdBindIndexBuffer(commandBuffer, m_ModelData->meshes[i].indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-			vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(m_ModelData->meshes[i].indexBuffer.count), 1, 0, 0, 0);
+			drawGeometry(commandBuffer, i, lodErrorScale, lodPixelThreshold, bindings);
 		}
 	}
 
+	//draws selected LOD of mesh, material has to be bound by caller (if any)
+	void drawGeometry(VkCommandBuffer commandBuffer, size_t meshIdx, float lodErrorScale, float lodPixelThreshold, GeometryBindings& bindings) const
+	{
+		MeshData const& mesh = m_ModelData->meshes[meshIdx];
+		drawLod(commandBuffer, mesh, mesh.vertices, lodErrorScale, lodPixelThreshold, bindings);
+	}
+
+	//same as drawGeometry but fetches position stream only, caller has to apply MeshData::positionDequantization
+	void drawPositions(VkCommandBuffer commandBuffer, size_t meshIdx, float lodErrorScale, float lodPixelThreshold, GeometryBindings& bindings) const
+	{
+		MeshData const& mesh = m_ModelData->meshes[meshIdx];
+		drawLod(commandBuffer, mesh, mesh.positions, lodErrorScale, lodPixelThreshold, bindings);
+	}
+
+private:
+	static void drawLod(VkCommandBuffer commandBuffer, MeshData const& mesh, GeometryRange const& vertices, float lodErrorScale, float lodPixelThreshold, GeometryBindings& bindings)
+	{
+		MeshLod const& lod = mesh.lods[mesh.selectLod(lodErrorScale, lodPixelThreshold)];
+
+		bindings.bind(commandBuffer, vertices.buffer, mesh.indices.buffer, mesh.getIndexType());
+		vkCmdDrawIndexed(commandBuffer, lod.indexCount, 1, mesh.indices.offset + lod.firstIndex, static_cast<int32_t>(vertices.offset), 0);
+	}
+
 
 };
\ No newline at end of file
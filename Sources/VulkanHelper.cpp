@@ -1,6 +1,7 @@
 #pragma once
 
 #include "VulkanHelper.h"
+#include "StagingRing.h"
 #include <assert.h>
 #include <optional>
 #include <fstream>
@@ -86,38 +87,63 @@ using namespace std;
 
 	 void VulkanHelpers::createGraphicsPipeline(VkDevice device, VkRenderPass renderPass, int colorAttachmentCnt, VkExtent2D extent, ShaderSet const& shaderSet, bool blending, VkPipelineInputAssemblyStateCreateInfo const &inputAssemblyInfo, VkPipelineLayout& outPipelineLayout, VkPipeline& outPipeline)
 	{
+		auto& registry = PipelineRegistry::get(device);
+
+		//key covers shader set and every fixed function state which is parameter of buildGraphicsPipeline
+		string key;
+		PipelineRegistry::appendKey(key, &renderPass, 1);
+		PipelineRegistry::appendKey(key, &colorAttachmentCnt, 1);
+		PipelineRegistry::appendKey(key, &extent, 1);
+		PipelineRegistry::appendKey(key, &blending, 1);
+		PipelineRegistry::appendKey(key, &inputAssemblyInfo.topology, 1);
+		PipelineRegistry::appendKey(key, &inputAssemblyInfo.primitiveRestartEnable, 1);
+		PipelineRegistry::appendKey(key, shaderSet.vertexShaderPath);
+		PipelineRegistry::appendKey(key, shaderSet.fragmentShaderPath);
+		PipelineRegistry::appendKey(key, shaderSet.geometryShaderPath);
+		PipelineRegistry::appendKey(key, shaderSet.descriptorSetLayout.data(), shaderSet.descriptorSetLayout.size());
+		PipelineRegistry::appendKey(key, shaderSet.pushConstant.data(), shaderSet.pushConstant.size());
+		PipelineRegistry::appendKey(key, shaderSet.vertexInputAttributeDescription.data(), shaderSet.vertexInputAttributeDescription.size());
+
+		//binding description is not initialized by every renderer, it is used only with attributes
+		if (!shaderSet.vertexInputAttributeDescription.empty()) PipelineRegistry::appendKey(key, &shaderSet.vertexInputBindingDescription, 1);
+
+		outPipelineLayout = registry.getPipelineLayout(shaderSet.descriptorSetLayout, shaderSet.pushConstant);
+		outPipeline = registry.getPipeline(key, [&]()
+			{
+				return buildGraphicsPipeline(device, renderPass, colorAttachmentCnt, extent, shaderSet, blending, inputAssemblyInfo, outPipelineLayout);
+			});
+	}
+
+	VkPipeline VulkanHelpers::buildGraphicsPipeline(VkDevice device, VkRenderPass renderPass, int colorAttachmentCnt, VkExtent2D extent, ShaderSet const& shaderSet, bool blending, VkPipelineInputAssemblyStateCreateInfo const& inputAssemblyInfo, VkPipelineLayout pipelineLayout)
+	{
+		auto& registry = PipelineRegistry::get(device);
+
 		vector< VkPipelineShaderStageCreateInfo> shaders;
 
 		{
-			VkShaderModule vertShader;
-			VulkanHelpers::createShaderModuleFromFile(shaderSet.vertexShaderPath.c_str(), device, vertShader);
 			VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
 			vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 			vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-			vertShaderStageInfo.module = vertShader;
+			vertShaderStageInfo.module = registry.getShaderModule(shaderSet.vertexShaderPath);
 			vertShaderStageInfo.pName = "main";
 			shaders.push_back(vertShaderStageInfo);
 		}
 
 		{
-			VkShaderModule fragShader;
-			VulkanHelpers::createShaderModuleFromFile(shaderSet.fragmentShaderPath.c_str(), device, fragShader);
 			VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
 			fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 			fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-			fragShaderStageInfo.module = fragShader;
+			fragShaderStageInfo.module = registry.getShaderModule(shaderSet.fragmentShaderPath);
 			fragShaderStageInfo.pName = "main";
 			shaders.push_back(fragShaderStageInfo);
 		}
 		
 		if (!shaderSet.geometryShaderPath.empty())
 		{
-			VkShaderModule geomShader;
-			VulkanHelpers::createShaderModuleFromFile(shaderSet.geometryShaderPath.c_str(), device, geomShader);
 			VkPipelineShaderStageCreateInfo geomShaderStageInfo = {};
 			geomShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 			geomShaderStageInfo.stage = VK_SHADER_STAGE_GEOMETRY_BIT;
-			geomShaderStageInfo.module = geomShader;
+			geomShaderStageInfo.module = registry.getShaderModule(shaderSet.geometryShaderPath);
 			geomShaderStageInfo.pName = "main";
 			shaders.push_back(geomShaderStageInfo);
 		}
@@ -208,26 +234,6 @@ using namespace std;
 		colorBlending.blendConstants[2] = 0.0f; // Optional
 		colorBlending.blendConstants[3] = 0.0f; // Optional
 
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-
-		if (!shaderSet.descriptorSetLayout.empty())
-		{
-			pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(shaderSet.descriptorSetLayout.size());
-			pipelineLayoutInfo.pSetLayouts = &shaderSet.descriptorSetLayout[0];
-		}
-	
-
-		if (!shaderSet.pushConstant.empty())
-		{
-			pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(shaderSet.pushConstant.size());
-			pipelineLayoutInfo.pPushConstantRanges = &shaderSet.pushConstant[0];
-		}
-
-
-		auto res = vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &outPipelineLayout);
-		assert(VK_SUCCESS == res);
-
 		VkPipelineDepthStencilStateCreateInfo depthStencil = {};
 		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 		depthStencil.depthTestEnable = VK_TRUE;
@@ -254,19 +260,17 @@ using namespace std;
 		pipelineInfo.pDepthStencilState = &depthStencil;
 		pipelineInfo.pColorBlendState = &colorBlending;
 		pipelineInfo.pDynamicState = nullptr; // Optional
-		pipelineInfo.layout = outPipelineLayout;
+		pipelineInfo.layout = pipelineLayout;
 		pipelineInfo.renderPass = renderPass;
 		pipelineInfo.subpass = 0;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 		pipelineInfo.basePipelineIndex = -1; // Optional
 
-		res = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &outPipeline);
+		VkPipeline pipeline;
+		auto res = vkCreateGraphicsPipelines(device, PipelineCache::get(device).getCache(), 1, &pipelineInfo, nullptr, &pipeline);
 		assert(res == VK_SUCCESS);
 
-		for (auto& shader : shaders)
-		{
-			vkDestroyShaderModule(device, shader.module, nullptr);
-		}
+		return pipeline;
 	}
 
 	void VulkanHelpers::createRenderPass(VkRenderPass &outRenderPass, VkDevice device, VkFormat colorAttachmentFormat, VkImageLayout colroAttachmnetImagelayout, VkAttachmentLoadOp colorAttachmentLoadOp, size_t colorAttachmentCnt,  bool depthAttachment, VkImageLayout depthAttachmentImageLayout)
@@ -426,9 +430,21 @@ using namespace std;
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffer;
 
-		vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(graphicsQueue);
+		//waits only for this command buffer, not for frames in flight on the same queue
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		VkFence fence;
+		auto res = vkCreateFence(device, &fenceInfo, nullptr, &fence);
+		assert(res == VK_SUCCESS);
 
+		res = vkQueueSubmit(graphicsQueue, 1, &submitInfo, fence);
+		assert(res == VK_SUCCESS);
+
+		res = vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+		assert(res == VK_SUCCESS);
+
+		vkDestroyFence(device, fence, nullptr);
 		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
 	}
 
@@ -450,7 +466,7 @@ using namespace std;
 	}
 
 
-	void VulkanHelpers::createTextureImage(VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicQueue, VkImage& outImage, VkDeviceMemory& outDeviceMemory, const char* imagePath, VkDevice device, VkFormat imageFormat )
+	void VulkanHelpers::createTextureImage(VkPhysicalDevice physicalDevice, StagingRing& stagingRing, VkImage& outImage, MemoryAllocation& outDeviceMemory, const char* imagePath, VkDevice device, VkFormat imageFormat )
 	{
 		int texWidth, texHeight, texChannels;
 		stbi_uc* pixels = stbi_load(imagePath, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
@@ -458,23 +474,15 @@ using namespace std;
 
 		assert(pixels != nullptr);
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-
-		createBuffer(stagingBuffer, stagingBufferMemory, physicalDevice, device, pixels, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-		stbi_image_free(pixels);
-
 		//VK_FORMAT_R8G8B8A8_UNORM
 		createImage(physicalDevice, device, texWidth, texHeight, imageFormat , VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, outImage, outDeviceMemory);
-		transitionImageLayout(device, commandPool, graphicQueue, outImage, imageFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		copyBufferToImage(device, commandPool, graphicQueue, stagingBuffer, outImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-		transitionImageLayout(device, commandPool, graphicQueue, outImage, imageFormat, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
+		//layout transitions are recorded by ring together with copy
+		stagingRing.copyToImage(outImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), pixels, imageSize);
+		stbi_image_free(pixels);
 	}
 
-	void VulkanHelpers::createImage(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+	void VulkanHelpers::createImage(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory)
 	{
 		VkImageCreateInfo imageInfo = {};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -494,19 +502,7 @@ using namespace std;
 		auto res = vkCreateImage(device, &imageInfo, nullptr, &image);
 		assert(res == VK_SUCCESS);
 
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(device, image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-
-		allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties);
-
-		res = vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory);
-		assert(res == VK_SUCCESS);
-
-		vkBindImageMemory(device, image, imageMemory, 0);
+		imageMemory = MemoryAllocator::get(device).allocateImage(image, properties, tiling == VK_IMAGE_TILING_OPTIMAL);
 	}
 
 	void VulkanHelpers::writeImage(const char *filePath, size_t width, size_t height, size_t channels, void const *data)
@@ -593,28 +589,26 @@ using namespace std;
 		endSingleTimeCommands(device, commandPool, graphicQueue, commandBuffer);
 	}
 
-	void VulkanHelpers::copyBufferToImage(VkDevice device, VkCommandPool commandPool, VkQueue graphicQueue, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+	void VulkanHelpers::allocateBuffer(VkBuffer& outBuffer, MemoryAllocation& outMemory, VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize size, VkBufferUsageFlags bufferUsageFlag, VkMemoryPropertyFlags memoryProperties,
+		vector<uint32_t> const& queueFamilies)
 	{
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands(device, commandPool);
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = bufferUsageFlag;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		VkBufferImageCopy region = {};
-		region.bufferOffset = 0;
-		region.bufferRowLength = 0;
-		region.bufferImageHeight = 0;
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = 1;
-		region.imageOffset = { 0, 0, 0 };
-		region.imageExtent = {
-			width,
-			height,
-			1
-		};
-
-		vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+		if (queueFamilies.size() > 1)
+		{
+			bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+			bufferInfo.pQueueFamilyIndices = &queueFamilies[0];
+		}
 
-		endSingleTimeCommands(device, commandPool, graphicQueue, commandBuffer);
+		auto res = vkCreateBuffer(device, &bufferInfo, nullptr, &outBuffer);
+		assert(VK_SUCCESS == res);
+
+		outMemory = MemoryAllocator::get(device).allocateBuffer(outBuffer, memoryProperties);
 	}
 
 
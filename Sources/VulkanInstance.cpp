@@ -1,15 +1,32 @@
 #include "VulkanInstance.h"
+#include "CpuProfiler.h"
+#include <algorithm>
 #include <fstream>
+#include <iostream>
 
-	VulcanInstance::VulcanInstance(GLFWwindow& window, size_t resX, size_t resY)
+	VulcanInstance::VulcanInstance(GLFWwindow& window, size_t resX, size_t resY, FrameSettings const& frameSettings) : m_FrameSettings(frameSettings)
 	{
+		assert(frameSettings.framesInFlight >= 1 && frameSettings.framesInFlight <= MAX_FRAMES_IN_FLIGHT);
+		m_FramesInFlight = frameSettings.framesInFlight;
+
 		createInstance();
 		createSurface(window);
 
-		const vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+		vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 		selectPhysicalDevice(deviceExtensions);
 
+		//optional, descriptor sets are updated by batched vkUpdateDescriptorSets without it
+		if (checkPhysicalDeviceExtensions(m_PhysicalDevice, { VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME })) deviceExtensions.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+
+		//optional, GPU driven rendering draws whole command range of batch without it
+		m_DrawIndirectCount = checkPhysicalDeviceExtensions(m_PhysicalDevice, { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME });
+		if (m_DrawIndirectCount) deviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
 		createDevice(deviceExtensions);
+		m_MemoryAllocator = make_unique<MemoryAllocator>(m_PhysicalDevice, m_Device);
+		m_DescriptorAllocator = make_unique<DescriptorAllocator>(m_Device, m_FramesInFlight);
+		m_PipelineCache = make_unique<PipelineCache>(m_PhysicalDevice, m_Device, PIPELINE_CACHE_PATH);
+		m_PipelineRegistry = make_unique<PipelineRegistry>(m_Device);
 
 		VkExtent2D extent = { static_cast<uint32_t>(resX), static_cast<uint32_t>(resY)};
 
@@ -17,6 +34,13 @@
 		createImageViews();
 		createRenderPass();
 		createCommandPool();
+		m_StagingRing = make_unique<StagingRing>(m_PhysicalDevice, m_Device, m_CommandPool, m_GraphicQueue, m_GraphicQueueFamilyIndex, m_TransferCommandPool, m_TransferQueue, m_TransferQueueFamilyIndex);
+		m_UniformRing = make_unique<UniformRing>(m_PhysicalDevice, m_Device, m_FramesInFlight);
+		m_ComputeScheduler = make_unique<ComputeScheduler>(m_Device, m_ComputeQueue, m_ComputeQueueFamilyIndex);
+		m_GpuProfiler = make_unique<GpuProfiler>(m_PhysicalDevice, m_Device, m_CommandPool, m_GraphicQueue, m_GraphicQueueFamilyIndex);
+		m_ParallelRecorder = make_unique<ParallelRecorder>(m_Device, m_GraphicQueueFamilyIndex, m_FramesInFlight);
+		PROFILE_THREAD_NAME("main");
+		cout << "Command recording threads: " << m_ParallelRecorder->getThreadCnt() << endl;
 
 		createDepthResources();
 		createFramebuffers();
@@ -28,7 +52,13 @@
 	{
 		vkDeviceWaitIdle(m_Device);
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		m_StagingRing.reset();
+		m_UniformRing.reset();
+		m_ComputeScheduler.reset();
+		m_ParallelRecorder.reset();
+		m_GpuProfiler.reset();
+
+		for (size_t i = 0; i < m_FramesInFlight; i++)
 		{
 			vkDestroySemaphore(m_Device, m_RenderFinishedSemaphores[i], nullptr);
 			vkDestroySemaphore(m_Device, m_ImageAvailableSemaphores[i], nullptr);
@@ -41,7 +71,9 @@
 		//m_Models[0].destroy();
 		//m_Models.clear();
 
+		for (auto commandPool : m_FrameCommandPools) vkDestroyCommandPool(m_Device, commandPool, nullptr);
 		vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+		vkDestroyCommandPool(m_Device, m_TransferCommandPool, nullptr);
 
 		for (auto framebuffer : m_SwapChainFramebuffers) vkDestroyFramebuffer(m_Device, framebuffer, nullptr);
 
@@ -54,39 +86,107 @@
 
 		for (auto imageView : m_SwapChainImageViews) vkDestroyImageView(m_Device, imageView, nullptr);
 
+		vkDestroyImageView(m_Device, m_DepthImageView, nullptr);
+		vkDestroyImage(m_Device, m_DepthImage, nullptr);
+		m_MemoryAllocator->free(m_DepthImageMemory);
+
 		vkDestroySwapchainKHR(m_Device, m_SwapChain, nullptr);
+		m_PipelineRegistry.reset();
+		m_PipelineCache.reset(); //saved to disk
+		m_DescriptorAllocator.reset();
+		m_MemoryAllocator.reset();
 		vkDestroyDevice(m_Device, nullptr);
 		vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
 		vkDestroyInstance(m_Instance, nullptr);
 	}
 
 	
-	void VulcanInstance::drawFrame(function<void(VkCommandBuffer, VkFramebuffer, VkImage)> func)
+	void VulcanInstance::drawFrame(function<void(VkCommandBuffer, VkFramebuffer, VkImage)> func, LateLatch const& lateLatch)
 	{
-		vkWaitForFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+		PROFILE_FUNCTION();
+
+		auto const frameStart = chrono::steady_clock::now();
+
+		{
+			PROFILE_SCOPE("wait for frame fence");
+			vkWaitForFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+		}
 		vkResetFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame]);
 
-		uint32_t imageIndex;
-		auto res = vkAcquireNextImageKHR(m_Device, m_SwapChain, UINT64_MAX, m_ImageAvailableSemaphores[m_CurrentFrame], VK_NULL_HANDLE, &imageIndex);
+		auto const fenceTime = chrono::steady_clock::now();
+
+		//command buffer of this slot was executed, all its memory is released at once
+		auto res = vkResetCommandPool(m_Device, m_FrameCommandPools[m_CurrentFrame], 0);
 		assert(res == VK_SUCCESS);
 
-		func(m_CommandBuffers[imageIndex], m_SwapChainFramebuffers[imageIndex], m_SwapChainImages[imageIndex]);
+		//frame which used this slice last is finished
+		m_UniformRing->beginFrame(static_cast<uint32_t>(m_CurrentFrame));
+		m_DescriptorAllocator->beginFrame(static_cast<uint32_t>(m_CurrentFrame));
+		m_ParallelRecorder->beginFrame(static_cast<uint32_t>(m_CurrentFrame));
+		m_GpuProfiler->beginFrame(static_cast<uint32_t>(m_CurrentFrame));
+
+		uint32_t imageIndex;
+		{
+			PROFILE_SCOPE("acquire image");
+			res = vkAcquireNextImageKHR(m_Device, m_SwapChain, UINT64_MAX, m_ImageAvailableSemaphores[m_CurrentFrame], VK_NULL_HANDLE, &imageIndex);
+			assert(res == VK_SUCCESS);
+		}
+
+		auto const acquireTime = chrono::steady_clock::now();
+
+		if (m_FrameCnt > 0)
+		{
+			auto const toMs = [](chrono::steady_clock::duration duration) { return chrono::duration<double, milli>(duration).count(); };
+
+			double const intervalMs = toMs(frameStart - m_LastFrameStart);
+			double const latencyMs = m_FrameCnt >= m_FramesInFlight ? toMs(fenceTime - m_SubmitTimes[m_CurrentFrame]) : 0.0;
+			m_FrameStatistics.addFrame(intervalMs, toMs(fenceTime - frameStart), toMs(acquireTime - fenceTime), latencyMs);
+
+			PROFILE_COUNTER("frame interval (ms)", intervalMs);
+		}
+		m_LastFrameStart = frameStart;
+
+		{
+			PROFILE_SCOPE("record frame");
+			func(m_CommandBuffers[m_CurrentFrame], m_SwapChainFramebuffers[imageIndex], m_SwapChainImages[imageIndex]);
+		}
+
+		//compute submitted by latch (ray tracer) is still waited by this frame
+		chrono::steady_clock::time_point inputTime;
+		if (lateLatch)
+		{
+			PROFILE_SCOPE("late latch");
+			inputTime = lateLatch();
+		}
 
+		//uploads queued since last frame are submitted before frame which uses them
+		m_StagingRing->flush();
 
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &m_ImageAvailableSemaphores[m_CurrentFrame];
-		submitInfo.pWaitDstStageMask = waitStages;
+		vector<VkSemaphore> waitSemaphores = { m_ImageAvailableSemaphores[m_CurrentFrame] };
+		vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		vector<VkSemaphore> signalSemaphores = { m_RenderFinishedSemaphores[m_CurrentFrame] };
+
+		//compute submitted by func for this frame, and compute of later frames waiting for this one
+		m_ComputeScheduler->getFrameSemaphores(waitSemaphores, waitStages, signalSemaphores);
+
+		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+		submitInfo.pWaitSemaphores = &waitSemaphores[0];
+		submitInfo.pWaitDstStageMask = &waitStages[0];
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_CommandBuffers[imageIndex];
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = &m_RenderFinishedSemaphores[m_CurrentFrame];
+		submitInfo.pCommandBuffers = &m_CommandBuffers[m_CurrentFrame];
+		submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+		submitInfo.pSignalSemaphores = &signalSemaphores[0];
 
-		res = vkQueueSubmit(m_GraphicQueue, 1, &submitInfo, m_InFlightFences[m_CurrentFrame]);
-		assert(res == VK_SUCCESS);
+		{
+			PROFILE_SCOPE("submit");
+			res = vkQueueSubmit(m_GraphicQueue, 1, &submitInfo, m_InFlightFences[m_CurrentFrame]);
+			assert(res == VK_SUCCESS);
+		}
+		m_SubmitTimes[m_CurrentFrame] = chrono::steady_clock::now();
+		auto const submitTime = m_SubmitTimes[m_CurrentFrame];
 
 
 		//==========
@@ -102,11 +202,21 @@
 		presentInfo.pImageIndices = &imageIndex;
 		presentInfo.pResults = nullptr; // Optional
 
-		res = vkQueuePresentKHR(m_PresentationQueue, &presentInfo);
-		assert(res == VK_SUCCESS);
+		{
+			PROFILE_SCOPE("present");
+			res = vkQueuePresentKHR(m_PresentationQueue, &presentInfo);
+			assert(res == VK_SUCCESS);
+		}
+
+		if (m_FrameSettings.measureInputLatency && inputTime != chrono::steady_clock::time_point())
+		{
+			auto const presentTime = chrono::steady_clock::now();
+			m_FrameStatistics.addInputLatency(chrono::duration<double, milli>(submitTime - inputTime).count(), chrono::duration<double, milli>(presentTime - inputTime).count());
+		}
 
 
-		m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+		++m_FrameCnt;
 	}
 
 	void VulcanInstance::createDepthResources()
@@ -124,7 +234,12 @@
 		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		m_ImageAvailableSemaphores.resize(m_FramesInFlight);
+		m_RenderFinishedSemaphores.resize(m_FramesInFlight);
+		m_InFlightFences.resize(m_FramesInFlight);
+		m_SubmitTimes.resize(m_FramesInFlight);
+
+		for (size_t i = 0; i < m_FramesInFlight; i++)
 		{
 			auto res = vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_ImageAvailableSemaphores[i]);
 			assert(res == VK_SUCCESS);
@@ -156,23 +271,47 @@
 
 	void VulcanInstance::createCommandBuffers()
 	{
-		m_CommandBuffers = allocateCommandBuffers(static_cast<uint32_t>(m_SwapChainFramebuffers.size()));
+		//command buffers follow frames in flight, not swapchain images, so buffer is never recorded while its frame is executed
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = m_GraphicQueueFamilyIndex;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		m_FrameCommandPools.resize(m_FramesInFlight);
+		m_CommandBuffers.resize(m_FramesInFlight);
+
+		for (uint32_t i = 0; i < m_FramesInFlight; ++i)
+		{
+			auto res = vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_FrameCommandPools[i]);
+			assert(res == VK_SUCCESS);
 
-		/*
-		for (size_t i = 0; i < m_CommandBuffers.size(); i++)
-			recordCommandBuffer(m_CommandBuffers[i], m_SwapChainFramebuffers[i], func);
-			*/
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = m_FrameCommandPools[i];
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+
+			res = vkAllocateCommandBuffers(m_Device, &allocInfo, &m_CommandBuffers[i]);
+			assert(res == VK_SUCCESS);
+		}
 	}
 
 	void VulcanInstance::createCommandPool()
 	{
 		VkCommandPoolCreateInfo poolInfo = {};
 		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		poolInfo.queueFamilyIndex = getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT);
+		poolInfo.queueFamilyIndex = m_GraphicQueueFamilyIndex;
 		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
 		auto res = vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_CommandPool);
 		assert(res == VK_SUCCESS);
+
+		//upload command buffers are short lived
+		poolInfo.queueFamilyIndex = m_TransferQueueFamilyIndex;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		res = vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_TransferCommandPool);
+		assert(res == VK_SUCCESS);
 	}
 
 	void VulcanInstance::createFramebuffers()
@@ -263,6 +402,26 @@
 		return static_cast<uint32_t>(distance(begin(queueFamilies), it));
 	}
 
+	bool VulcanInstance::findQueueFamilyIndex(int flags, int excludedFlags, uint32_t& outIndex) const
+	{
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, nullptr);
+
+		vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		auto it = find_if(begin(queueFamilies), end(queueFamilies), [flags, excludedFlags](VkQueueFamilyProperties const& properties)
+			{
+				return (properties.queueFlags & flags) == static_cast<VkQueueFlags>(flags) && (properties.queueFlags & excludedFlags) == 0 && properties.queueCount > 0;
+			});
+
+		if (it == end(queueFamilies)) return false;
+
+		outIndex = static_cast<uint32_t>(distance(begin(queueFamilies), it));
+
+		return true;
+	}
+
 	void VulcanInstance::createSurface(GLFWwindow& window)
 	{
 		VkResult res = glfwCreateWindowSurface(m_Instance, &window, nullptr, &m_Surface);
@@ -354,23 +513,44 @@
 
 	void VulcanInstance::createDevice(vector<const char*> const& deviceExtensions)
 	{
-		unsigned int const queueFamilyIndex = getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT);
+		m_GraphicQueueFamilyIndex = getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT);
+
+		//DMA engine family copies without taking time from graphics queue
+		if (!findQueueFamilyIndex(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, m_TransferQueueFamilyIndex)) m_TransferQueueFamilyIndex = m_GraphicQueueFamilyIndex;
+
+		//async compute uses second queue of graphics family, so compute shares resources with graphics without ownership transfers
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, nullptr);
+
+		vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		m_ComputeQueueFamilyIndex = m_GraphicQueueFamilyIndex;
+		uint32_t const graphicQueueCnt = min(2u, queueFamilies[m_GraphicQueueFamilyIndex].queueCount);
+
+		float const queuePriorities[] = { 1.0f, 1.0f };
 
-		VkDeviceQueueCreateInfo queueCreateInfo = {};
-		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-		queueCreateInfo.queueFamilyIndex = queueFamilyIndex;
-		queueCreateInfo.queueCount = 1;
+		vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+		for (uint32_t queueFamilyIndex : { m_GraphicQueueFamilyIndex, m_TransferQueueFamilyIndex })
+		{
+			if (!queueCreateInfos.empty() && queueCreateInfos[0].queueFamilyIndex == queueFamilyIndex) continue;
+
+			VkDeviceQueueCreateInfo queueCreateInfo = {};
+			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueCreateInfo.queueFamilyIndex = queueFamilyIndex;
+			queueCreateInfo.queueCount = queueFamilyIndex == m_GraphicQueueFamilyIndex ? graphicQueueCnt : 1;
+			queueCreateInfo.pQueuePriorities = queuePriorities;
 
-		float const queuePriority = 1.0f;
-		queueCreateInfo.pQueuePriorities = &queuePriority;
+			queueCreateInfos.push_back(queueCreateInfo);
+		}
 
 		VkPhysicalDeviceFeatures physicalDeviceFeatures;
 		vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &physicalDeviceFeatures);
 
 		VkDeviceCreateInfo deviceCreateInfo = {};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-		deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
-		deviceCreateInfo.queueCreateInfoCount = 1;
+		deviceCreateInfo.pQueueCreateInfos = &queueCreateInfos[0];
+		deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		deviceCreateInfo.pEnabledFeatures = &physicalDeviceFeatures;
 		deviceCreateInfo.ppEnabledExtensionNames = &deviceExtensions[0];
 		deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
@@ -378,11 +558,17 @@
 		VkResult result = vkCreateDevice(m_PhysicalDevice, &deviceCreateInfo, nullptr, &m_Device);
 		assert(result == VK_SUCCESS);
 
-		vkGetDeviceQueue(m_Device, queueFamilyIndex, 0, &m_GraphicQueue);
+		vkGetDeviceQueue(m_Device, m_GraphicQueueFamilyIndex, 0, &m_GraphicQueue);
+		vkGetDeviceQueue(m_Device, m_TransferQueueFamilyIndex, 0, &m_TransferQueue);
+		vkGetDeviceQueue(m_Device, m_ComputeQueueFamilyIndex, graphicQueueCnt - 1, &m_ComputeQueue);
 		m_PresentationQueue = m_GraphicQueue;
 
+		cout << "Compute queue: " << (m_ComputeQueue != m_GraphicQueue ? "async" : "shared with graphics") << endl;
+
+		cout << "Transfer queue family: " << m_TransferQueueFamilyIndex << (m_TransferQueueFamilyIndex != m_GraphicQueueFamilyIndex ? " (dedicated)" : " (graphics)") << endl;
+
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(m_PhysicalDevice, queueFamilyIndex, m_Surface, &presentSupport);
+		vkGetPhysicalDeviceSurfaceSupportKHR(m_PhysicalDevice, m_GraphicQueueFamilyIndex, m_Surface, &presentSupport);
 		assert(presentSupport != 0);
 	}
 
@@ -398,12 +584,42 @@
 		return availableFormats[0];
 	}
 
-	VkPresentModeKHR VulcanInstance::chooseSwapPresentMode(vector<VkPresentModeKHR> const& availablePresentModes)
+	VkPresentModeKHR VulcanInstance::chooseSwapPresentMode(vector<VkPresentModeKHR> const& availablePresentModes) const
+	{
+		vector<VkPresentModeKHR> preferred;
+		if (m_FrameSettings.presentMode != VK_PRESENT_MODE_MAX_ENUM_KHR) preferred.push_back(m_FrameSettings.presentMode);
+
+		switch (m_FrameSettings.presentPolicy)
+		{
+		case PresentPolicy::LOW_LATENCY: preferred.push_back(VK_PRESENT_MODE_MAILBOX_KHR); break;
+		case PresentPolicy::MAX_THROUGHPUT: preferred.insert(end(preferred), { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR }); break;
+		case PresentPolicy::VSYNC: break;
+		}
+
+		for (auto presentMode : preferred)
+		{
+			if (end(availablePresentModes) != find(begin(availablePresentModes), end(availablePresentModes), presentMode))
+				return presentMode;
+		}
+
+		//always supported
+		return VK_PRESENT_MODE_FIFO_KHR;
+	}
+
+	void VulcanInstance::printFrameStatistics() const
 	{
-		if (end(availablePresentModes) != find(begin(availablePresentModes), end(availablePresentModes), VK_PRESENT_MODE_MAILBOX_KHR))
-			return VK_PRESENT_MODE_MAILBOX_KHR;
-		else
-			return VK_PRESENT_MODE_FIFO_KHR;
+		char const* presentModeName = "other";
+		switch (m_PresentMode)
+		{
+		case VK_PRESENT_MODE_IMMEDIATE_KHR: presentModeName = "immediate"; break;
+		case VK_PRESENT_MODE_MAILBOX_KHR: presentModeName = "mailbox"; break;
+		case VK_PRESENT_MODE_FIFO_KHR: presentModeName = "fifo"; break;
+		case VK_PRESENT_MODE_FIFO_RELAXED_KHR: presentModeName = "fifo relaxed"; break;
+		default: break;
+		}
+
+		m_FrameStatistics.printStatistics(string("Frame pacing (present mode ") + presentModeName + ", " + to_string(m_FramesInFlight) + " frames in flight, "
+			+ to_string(m_SwapChainImages.size()) + " swapchain images):");
 	}
 
 	void VulcanInstance::createSwapChain(VkExtent2D extent)
@@ -421,6 +637,7 @@
 		vkGetPhysicalDeviceSurfacePresentModesKHR(m_PhysicalDevice, m_Surface, &presentModeCount, &presentModes[0]);
 
 		VkPresentModeKHR presentMode = chooseSwapPresentMode(presentModes);
+		m_PresentMode = presentMode;
 
 		uint32_t formatCount;
 		vkGetPhysicalDeviceSurfaceFormatsKHR(m_PhysicalDevice, m_Surface, &formatCount, nullptr);
@@ -432,7 +649,9 @@
 		VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(formats);
 		m_SwapChainImageFormat = surfaceFormat.format;
 
-		uint32_t imageCount = min(capabilities.minImageCount + 1, capabilities.maxImageCount);
+		//one image more than frames in flight, so acquire doesn't block while every frame in flight holds one; maxImageCount 0 - no limit
+		uint32_t imageCount = max(capabilities.minImageCount + 1, m_FramesInFlight + 1);
+		if (capabilities.maxImageCount != 0) imageCount = min(imageCount, capabilities.maxImageCount);
 		assert(imageCount != 0);
 
 		assert(m_PresentationQueue == m_GraphicQueue);
@@ -1,9 +1,18 @@
 #pragma once
 
 #include "VulkanHelper.h"
+#include "StagingRing.h"
+#include "UniformRing.h"
+#include "DescriptorAllocator.h"
+#include "ComputeScheduler.h"
+#include "ParallelRecorder.h"
+#include "GpuProfiler.h"
+#include "FrameStatistics.h"
 #include <vector>
 #include <functional>
 #include <array>
+#include <chrono>
+#include <memory>
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
@@ -11,6 +20,22 @@
 using namespace std;
 
 
+//swapchain present mode preference, explicit FrameSettings::presentMode wins when surface supports it
+enum class PresentPolicy
+{
+	LOW_LATENCY, //mailbox, newest frame replaces queued one, no tearing, GPU never waits for vertical blank; fifo fallback
+	MAX_THROUGHPUT, //immediate, tearing, nothing waits for vertical blank; mailbox, fifo fallback
+	VSYNC, //fifo, CPU is throttled by display, steadiest pacing and most latency
+};
+
+struct FrameSettings
+{
+	uint32_t framesInFlight = 2; //1 .. VulcanInstance::MAX_FRAMES_IN_FLIGHT, fewer frames queued ahead mean less input latency
+	PresentPolicy presentPolicy = PresentPolicy::LOW_LATENCY;
+	VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAX_ENUM_KHR; //from policy
+	bool measureInputLatency = false; //input to submit / present in frame statistics
+};
+
 struct RenderContext
 {
 	VkRenderPass renderPass;
@@ -22,10 +47,15 @@ struct RenderContext
 class VulcanInstance
 {
 public:
-	VulcanInstance(GLFWwindow& window, size_t resX, size_t resY);
+	VulcanInstance(GLFWwindow& window, size_t resX, size_t resY, FrameSettings const& frameSettings = FrameSettings());
 	~VulcanInstance();
 
-	void drawFrame(function<void(VkCommandBuffer, VkFramebuffer, VkImage)> func);
+	//samples input and writes camera dependent data which recorded commands read from mapped memory
+	//returns arrival of oldest input it applied, time_point() without input
+	using LateLatch = function<chrono::steady_clock::time_point()>;
+
+	//lateLatch is called after func recorded frame, right before it is submitted
+	void drawFrame(function<void(VkCommandBuffer, VkFramebuffer, VkImage)> func, LateLatch const& lateLatch = nullptr);
 	void createDepthResources();
 	void createSyncPrimitives();
 	vector<VkCommandBuffer> allocateCommandBuffers(uint32_t count);
@@ -37,21 +67,29 @@ public:
 	void createRenderPass();
 	void createImageViews();
 	unsigned int getQueueFamilyIndex(int flags) const;
+	bool findQueueFamilyIndex(int flags, int excludedFlags, uint32_t& outIndex) const;
 	void createSurface(GLFWwindow& window);
 	vector<const char*> getRequiredExtensions()  const;
 	void createInstance();
 	bool checkPhysicalDeviceExtensions(VkPhysicalDevice physicalDevice, vector<char const*> const& requiredExtensions);
 	void createDevice(vector<const char*> const& deviceExtensions);
 	VkSurfaceFormatKHR chooseSwapSurfaceFormat(vector<VkSurfaceFormatKHR> const& availableFormats);
-	VkPresentModeKHR chooseSwapPresentMode(vector<VkPresentModeKHR> const& availablePresentModes);
+	VkPresentModeKHR chooseSwapPresentMode(vector<VkPresentModeKHR> const& availablePresentModes) const;
+	void printFrameStatistics() const;
 	void createSwapChain(VkExtent2D extent);
 	void selectPhysicalDevice(vector<char const*> const& extensions);
 
 	VkInstance m_Instance = VK_NULL_HANDLE;
 	VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
 	VkDevice m_Device = VK_NULL_HANDLE;
+	bool m_DrawIndirectCount = false; //VK_KHR_draw_indirect_count is enabled
 
 	VkQueue m_GraphicQueue = VK_NULL_HANDLE;
+	uint32_t m_GraphicQueueFamilyIndex = 0;
+	VkQueue m_TransferQueue = VK_NULL_HANDLE; //queue of dedicated transfer family if device has one, otherwise graphic queue
+	uint32_t m_TransferQueueFamilyIndex = 0;
+	VkQueue m_ComputeQueue = VK_NULL_HANDLE; //second queue of graphics family if available, otherwise graphic queue
+	uint32_t m_ComputeQueueFamilyIndex = 0;
 	VkSurfaceKHR m_Surface = VK_NULL_HANDLE;
 	VkQueue m_PresentationQueue = VK_NULL_HANDLE;
 	VkSwapchainKHR m_SwapChain = VK_NULL_HANDLE;
@@ -64,15 +102,36 @@ public:
 
 	vector<VkFramebuffer> m_SwapChainFramebuffers;
 	VkCommandPool m_CommandPool;
-	vector<VkCommandBuffer> m_CommandBuffers;
+	VkCommandPool m_TransferCommandPool; //for m_TransferQueueFamilyIndex
+	vector<VkCommandPool> m_FrameCommandPools; //per frame in flight, reset as a whole once frame fence was waited
+	vector<VkCommandBuffer> m_CommandBuffers; //per frame in flight, recorded by drawFrame callback every frame
+
+	unique_ptr<MemoryAllocator> m_MemoryAllocator; //all device memory is sub-allocated from it, has to outlive every resource
+	unique_ptr<DescriptorAllocator> m_DescriptorAllocator; //shared descriptor pools, transient pools of current frame are reset in drawFrame
+	unique_ptr<PipelineCache> m_PipelineCache; //used by every pipeline creation, persisted in PIPELINE_CACHE_PATH
+	unique_ptr<PipelineRegistry> m_PipelineRegistry; //owns shader modules, pipeline layouts and graphics pipelines
+	unique_ptr<StagingRing> m_StagingRing; //uploads into device local memory, flushed with every frame
+	unique_ptr<UniformRing> m_UniformRing; //per frame uniform data, slice of current frame is reset in drawFrame
+	unique_ptr<ComputeScheduler> m_ComputeScheduler; //compute submitted in drawFrame callback is waited by that frame on GPU only
+	unique_ptr<GpuProfiler> m_GpuProfiler; //timestamps of render passes and dispatches, results are collected in drawFrame
+	unique_ptr<ParallelRecorder> m_ParallelRecorder; //secondary command buffers recorded on worker threads, pools of current frame are reset in drawFrame
 
 	VkImage m_DepthImage;
-	VkDeviceMemory m_DepthImageMemory;
+	MemoryAllocation m_DepthImageMemory;
 	VkImageView m_DepthImageView;
 
-	static const size_t MAX_FRAMES_IN_FLIGHT = 2;
-	array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> m_ImageAvailableSemaphores;
-	array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> m_RenderFinishedSemaphores;
-	array<VkFence, MAX_FRAMES_IN_FLIGHT> m_InFlightFences;
+	static const uint32_t MAX_FRAMES_IN_FLIGHT = 3; //compute command buffers of RayTracer, ParticleRenderer and query ranges of GpuProfiler are sized for it
+	static constexpr char const* PIPELINE_CACHE_PATH = "pipelineCache.bin";
+	FrameSettings m_FrameSettings;
+	uint32_t m_FramesInFlight;
+	VkPresentModeKHR m_PresentMode;
+	vector<VkSemaphore> m_ImageAvailableSemaphores;
+	vector<VkSemaphore> m_RenderFinishedSemaphores;
+	vector<VkFence> m_InFlightFences;
 	size_t m_CurrentFrame = 0;
+
+	vector<chrono::steady_clock::time_point> m_SubmitTimes; //per frame in flight, for submit to fence latency
+	chrono::steady_clock::time_point m_LastFrameStart;
+	uint64_t m_FrameCnt = 0;
+	FrameStatistics m_FrameStatistics;
 };
\ No newline at end of file
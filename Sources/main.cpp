@@ -3,10 +3,47 @@
 #include "mainParticles.h"
 #include "mainDeferredRenderWithShadowMapping.h"
 
-int main()
+#include <iostream>
+#include <string>
+
+//-vertexFormat full|oct|qtangent
+static VertexFormatType parseVertexFormat(int argc, char* argv[])
+{
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (string(argv[i]) != "-vertexFormat") continue;
+
+		string const format = argv[i + 1];
+		if (format == "oct") return VertexFormatType::OCTAHEDRAL;
+		if (format == "qtangent") return VertexFormatType::QTANGENT;
+		if (format != "full") cout << "Unknown vertex format " << format << ", using full" << endl;
+	}
+
+	return VertexFormatType::FULL;
+}
+
+//-positionFormat float|unorm16, position stream of depth only passes, unorm16 is quantized to mesh bounds (step of 1/65535 of mesh size)
+static PositionFormatType parsePositionFormat(int argc, char* argv[])
 {
-	runRayTracing();
-	//runDeferredRenderWithShadowMapping();
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (string(argv[i]) != "-positionFormat") continue;
+
+		string const format = argv[i + 1];
+		if (format == "unorm16") return PositionFormatType::UNORM16;
+		if (format != "float") cout << "Unknown position format " << format << ", using float" << endl;
+	}
+
+	return PositionFormatType::FLOAT;
+}
+
+int main(int argc, char* argv[])
+{
+	VertexFormatType const vertexFormat = parseVertexFormat(argc, argv);
+	PositionFormatType const positionFormat = parsePositionFormat(argc, argv);
+
+	//runRayTracing();
+	runDeferredRenderWithShadowMapping(vertexFormat, positionFormat);
 	//runParticles();
 	return 0;
 }
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "mainCommon.h"
+#include "CpuProfiler.h"
+
+#include <atomic>
 
 array<bool, 128> keyDown;
 bool mouseButtonLeftDown = false;
@@ -8,11 +11,11 @@ Camera* camera;
 unsigned int resX = 1024;
 unsigned int resY = 1024;
 
-SceneObjectFactory::SceneObjectFactory(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool  commandPool, VkQueue graphicQueue)
+SceneObjectFactory::SceneObjectFactory(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing, VertexFormatType vertexFormat, PositionFormatType positionFormat)
 {
-	m_TextureManager = make_unique<TextureManager>(physicalDevice, device, commandPool, graphicQueue);
-	m_MaterialManager = make_unique<MaterialManager>(*m_TextureManager, device, physicalDevice);
-	m_ModelManager = make_unique<ModelManager>(physicalDevice, device, *m_MaterialManager);
+	m_TextureManager = make_unique<TextureManager>(physicalDevice, device, stagingRing);
+	m_MaterialManager = make_unique<MaterialManager>(*m_TextureManager, stagingRing, device, physicalDevice);
+	m_ModelManager = make_unique<ModelManager>(physicalDevice, device, stagingRing, *m_MaterialManager, vertexFormat, positionFormat);
 }
 
 unique_ptr<SceneObject> SceneObjectFactory::createSceneObjectFromFile(string const& path)
@@ -31,24 +34,96 @@ MaterialManager* SceneObjectFactory::getMaterialManager() const
 	return &*m_MaterialManager;
 }
 
-SceneDescription::SceneDescription(VkPhysicalDevice physicalDevice, VkDevice device, shared_ptr<DescriptorSetLayout> descriptorSetLayout)
-	:m_UniformBuffer(physicalDevice, device, &m_Data, 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT),
+ModelManager* SceneObjectFactory::getModelManager() const
+{
+	return &*m_ModelManager;
+}
+
+SceneDescription::SceneDescription(UniformRing& uniformRing, shared_ptr<DescriptorSetLayout> descriptorSetLayout)
+	:m_UniformRing(uniformRing),
 	m_DescriptorSet(move(descriptorSetLayout))
 	//m_DescriptorSet(device, descriptorSetLayout, vector<variant< VkDescriptorImageInfo, VkDescriptorBufferInfo>>(1, VkDescriptorBufferInfo{ m_UniformBuffer.buffer, 0, sizeof(SceneData)}) )
 {
 	m_DescriptorSet.createDescriptorSet();
-	m_DescriptorSet.setBuffer("sceneBuffer", m_UniformBuffer);
+	m_DescriptorSet.setDynamicBuffer("sceneBuffer", m_UniformRing.getBuffer(), sizeof(SceneData));
+	m_DescriptorSet.update();
 	
 }
 
 void SceneContext::recordCommandBuffer(VkCommandBuffer commandBuffer)
 {
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline);
+	PROFILE_FUNCTION();
+
+	bindSceneState(commandBuffer, pushSceneData());
+
+	GeometryBindings bindings;
+	size_t objectIdx = 0;
+
+	m_SceneObjectManager.enumerate([&](SceneObject* sceneObj)
+		{
+			recordObject(commandBuffer, sceneObj, objectIdx++, bindings);
+		});
+}
+
+void SceneContext::recordCommandBuffer(VkCommandBuffer commandBuffer, ParallelRecorder& recorder, VkRenderPass renderPass, VkFramebuffer framebuffer)
+{
+	PROFILE_FUNCTION();
+
+	//uniform ring is not thread safe, scene data is pushed once and shared by all secondary command buffers
+	uint32_t const sceneOffset = pushSceneData();
 
+	size_t const objectCnt = m_SceneObjectManager.size();
+	uint32_t const threadCnt = static_cast<uint32_t>(min<size_t>(recorder.getThreadCnt(), (objectCnt + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE));
+	atomic<size_t> nextObject(0);
+
+	recorder.record(commandBuffer, renderPass, 0, framebuffer, threadCnt, [&](VkCommandBuffer secondaryCommandBuffer, uint32_t threadIdx)
+		{
+			PROFILE_SCOPE("record scene objects");
+
+			//secondary command buffer inherits no state
+			bindSceneState(secondaryCommandBuffer, sceneOffset);
+
+			GeometryBindings bindings;
+
+			for (size_t first = nextObject.fetch_add(PARALLEL_CHUNK_SIZE); first < objectCnt; first = nextObject.fetch_add(PARALLEL_CHUNK_SIZE))
+			{
+				size_t objectIdx = first;
+				m_SceneObjectManager.enumerate(first, min(first + PARALLEL_CHUNK_SIZE, objectCnt), [&](SceneObject* sceneObj)
+					{
+						recordObject(secondaryCommandBuffer, sceneObj, objectIdx++, bindings);
+					});
+			}
+		});
+}
+
+void SceneContext::recordCommandBuffer(VkCommandBuffer commandBuffer, GpuDrivenRenderer const& gpuDrivenRenderer, uint32_t frame)
+{
+	PROFILE_FUNCTION();
+
+	gpuDrivenRenderer.draw(commandBuffer, frame, m_SceneDescription->m_DescriptorSet.getDescriptorSet(), pushSceneData());
+}
+
+void SceneContext::cull()
+{
+	//camera latched after recording can move a little, meshes entering view at frustum border appear one frame later
+	vector<glm::mat4> viewProjections = { m_ProjectionMatrix * m_Camera.getInvMatrix() };
+	for (auto& light : m_Lights) viewProjections.push_back(m_ProjectionMatrix * light.getInvMatrix());
+
+	m_FrustumCuller.cull(m_SceneObjectManager, viewProjections);
+}
+
+void SceneContext::latchCamera()
+{
+	for (auto sceneData : m_LatchedSceneData) writeCamera(*sceneData);
+	m_LatchedSceneData.clear();
+}
+
+uint32_t SceneContext::pushSceneData()
+{
 	//static glm::vec3 moveDir(1.0f, 3.0f, 2.0f);
 	static glm::vec3 moveDir(0.0f, 0.0f, 0.0f);
 
-	m_SceneDescription->m_Data.lightPos = m_Camera.getMatrix()[3]; // glm::vec3(0.0f, 0.0f, 100.0f);
+	writeCamera(m_SceneDescription->m_Data);
 	//m_SceneDescription->m_Data.lightPos += moveDir;
 
 	if (abs(m_SceneDescription->m_Data.lightPos.x) > 500.0f)
@@ -62,21 +137,42 @@ void SceneContext::recordCommandBuffer(VkCommandBuffer commandBuffer)
 
 	m_SceneDescription->m_Data.lightColor = glm::vec3(1.0f, 1.0f, 1.0f);
 	m_SceneDescription->m_Data.lightCount = 1;
-	m_SceneDescription->m_Data.cameraPos = m_Camera.getMatrix()[3];
 
-	m_SceneDescription->m_UniformBuffer.updateBuffer(&m_SceneDescription->m_Data);
+	UniformRing& uniformRing = m_SceneDescription->m_UniformRing;
+	uint32_t const offset = uniformRing.push(m_SceneDescription->m_Data);
+	m_LatchedSceneData.push_back(static_cast<SceneData*>(uniformRing.getMappedData(offset)));
+
+	return offset;
+}
+
+void SceneContext::writeCamera(SceneData& data)
+{
+	data.lightPos = m_Camera.getMatrix()[3]; // glm::vec3(0.0f, 0.0f, 100.0f);
+	data.cameraPos = m_Camera.getMatrix()[3];
+	data.proj = m_ProjectionMatrix;
+	data.view = m_Camera.getInvMatrix();
+}
+
+void SceneContext::bindSceneState(VkCommandBuffer commandBuffer, uint32_t sceneOffset)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline);
 
 	auto descriptorSet = m_SceneDescription->m_DescriptorSet.getDescriptorSet();
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 1, 1, &descriptorSet, 0, nullptr);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 1, 1, &descriptorSet, 1, &sceneOffset);
+}
 
-	m_SceneObjectManager.enumerate([&](SceneObject* sceneObj)
-		{
-			array<glm::mat4, 3> matrices = { m_ProjectionMatrix, m_Camera.getInvMatrix(), sceneObj->getMatrix() };
-			vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(matrices), &matrices[0]);
+void SceneContext::recordObject(VkCommandBuffer commandBuffer, SceneObject* sceneObj, size_t objectIdx, GeometryBindings& bindings)
+{
+	//projection and view are per frame in scene UBO, only model matrix is pushed per object
+	glm::mat4 const& model = sceneObj->getMatrix();
+	vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(model), &model);
 
-			VisualComponent const* visualComp = sceneObj->findComponent<VisualComponent>();
-			if (visualComp) visualComp->draw(commandBuffer, m_PipelineLayout);
-		});
+	VisualComponent const* visualComp = sceneObj->findComponent<VisualComponent>();
+	if (visualComp)
+	{
+		float const lodErrorScale = VisualComponent::calculateLodErrorScale(sceneObj->getMatrix(), m_Camera.getMatrix()[3], m_ProjectionMatrix, static_cast<float>(resY));
+		visualComp->draw(commandBuffer, m_PipelineLayout, lodErrorScale, m_LodPixelThreshold, bindings, m_FrustumCuller.getMeshVisibility(0, objectIdx));
+	}
 }
 
 void key_callback(Window& window, int key, int scancode, int action, int mods)
@@ -118,4 +214,24 @@ void cursor_position_callback(Window& window, double xpos, double ypos)
 
 		camera->rotate( -diffY * 0.01f, -diffX * 0.01f);
 	}
-}
\ No newline at end of file
+}
+
+void input_callback(Window& window, InputSampler::Event const& event)
+{
+	switch (event.type)
+	{
+	case InputSampler::Event::Type::KEY: key_callback(window, event.key, event.scancode, event.action, event.mods); break;
+	case InputSampler::Event::Type::MOUSE_BUTTON: mouse_button_callback(window, event.key, event.action, event.mods); break;
+	case InputSampler::Event::Type::MOUSE_MOVE: cursor_position_callback(window, event.x, event.y); break;
+	}
+}
+
+void moveCamera(Camera& camera, float speed)
+{
+	if (keyDown['E']) camera.move(0.0f, 0.0f, speed);
+	if (keyDown['Q']) camera.move(0.0f, 0.0f, -speed);
+	if (keyDown['W']) camera.move(speed, 0.0f, 0.0f);
+	if (keyDown['S']) camera.move(-speed, 0.0f, 0.0f);
+	if (keyDown['A']) camera.move(0.0f, -speed, 0.0f);
+	if (keyDown['D']) camera.move(0.0f, speed, 0.0f);
+}
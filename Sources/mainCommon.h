@@ -31,7 +31,11 @@
 #include "MaterialManager.h"
 
 #include "Window.h"
+#include "InputSampler.h"
 #include "VulkanInstance.h"
+#include "ParallelRecorder.h"
+#include "FrustumCuller.h"
+#include "GpuDrivenRenderer.h"
 
 using namespace std;
 
@@ -39,9 +43,10 @@ using namespace std;
 class SceneObjectFactory
 {
 public:
-	SceneObjectFactory(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool  commandPool, VkQueue graphicQueue);
+	SceneObjectFactory(VkPhysicalDevice physicalDevice, VkDevice device, StagingRing& stagingRing, VertexFormatType vertexFormat = VertexFormatType::FULL, PositionFormatType positionFormat = PositionFormatType::FLOAT);
 	unique_ptr<SceneObject> createSceneObjectFromFile(string const& path);
 	MaterialManager* getMaterialManager() const;
+	ModelManager* getModelManager() const;
 
 private:
 	unique_ptr<TextureManager> m_TextureManager;
@@ -53,6 +58,8 @@ private:
 const unsigned int MAX_LIGHT_COUNT = 10;
 struct SceneData
 {
+	alignas(16) glm::mat4 proj;
+	alignas(16) glm::mat4 view;
 	alignas(16) glm::vec3 cameraPos = glm::vec3(1.0f, 0.0f, 0.0f);
 	alignas(16) glm::vec3 lightPos = glm::vec3(0.0f, 590.0f, 0.0f);
 	alignas(16) glm::vec3 lightColor;
@@ -62,10 +69,10 @@ struct SceneData
 struct SceneDescription
 {
 	SceneData m_Data;
-	Buffer m_UniformBuffer;
+	UniformRing& m_UniformRing; //m_Data is pushed every frame, previous frames in flight keep their copy
 	DescriptorSet m_DescriptorSet;
 
-	SceneDescription(VkPhysicalDevice physicalDevice, VkDevice device, shared_ptr<DescriptorSetLayout> descriptorSetLayout);
+	SceneDescription(UniformRing& uniformRing, shared_ptr<DescriptorSetLayout> descriptorSetLayout);
 };
 
 struct SceneContext
@@ -79,7 +86,34 @@ struct SceneContext
 	VkPipelineLayout m_PipelineLayout;
 	VkPipeline m_GraphicsPipeline;
 
+	float m_LodPixelThreshold = 1.0f; //max screen space error (pixels) of selected LOD
+
+	FrustumCuller m_FrustumCuller; //view 0 is camera, view i + 1 is m_Lights[i]
+
+	//tests meshes against camera and light frustums, called once per frame before command buffers are recorded
+	void cull();
+
 	void recordCommandBuffer(VkCommandBuffer commandBuffer);
+
+	//objects are split between threads of recorder into secondary command buffers executed in commandBuffer
+	//render pass has to be begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+	void recordCommandBuffer(VkCommandBuffer commandBuffer, ParallelRecorder& recorder, VkRenderPass renderPass, VkFramebuffer framebuffer);
+
+	//objects are drawn by indirect commands of gpuDrivenRenderer culled for frame (frame in flight) before render pass
+	void recordCommandBuffer(VkCommandBuffer commandBuffer, GpuDrivenRenderer const& gpuDrivenRenderer, uint32_t frame);
+
+	//rewrites camera of scene data pushed since last latch with current camera, called right before frame is submitted
+	void latchCamera();
+
+private:
+	uint32_t pushSceneData();
+	void bindSceneState(VkCommandBuffer commandBuffer, uint32_t sceneOffset);
+	void recordObject(VkCommandBuffer commandBuffer, SceneObject* sceneObj, size_t objectIdx, GeometryBindings& bindings);
+	void writeCamera(SceneData& data);
+
+	vector<SceneData*> m_LatchedSceneData; //in mapped uniform ring, referenced by recorded commands
+
+	static const size_t PARALLEL_CHUNK_SIZE = 64; //objects taken by recording thread at once, threads which finish early take more
 };
 
 extern array<bool, 128> keyDown;
@@ -91,4 +125,9 @@ extern unsigned int resY;
 
 void key_callback(Window& window, int key, int scancode, int action, int mods);
 void mouse_button_callback(Window& window, int button, int action, int mods);
-void cursor_position_callback(Window& window, double xpos, double ypos);
\ No newline at end of file
+void cursor_position_callback(Window& window, double xpos, double ypos);
+
+//dispatches sampled event to callbacks above
+void input_callback(Window& window, InputSampler::Event const& event);
+//WASD / EQ movement of held keys
+void moveCamera(Camera& camera, float speed);
\ No newline at end of file
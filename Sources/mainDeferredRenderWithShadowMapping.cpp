@@ -1,5 +1,6 @@
 
 #include "mainDeferredRenderWithShadowMapping.h"
+#include "CpuProfiler.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -19,6 +20,7 @@
 #include <algorithm>
 #include <unordered_set>
 #include <unordered_map>
+#include <chrono>
 
 #include "VulkanHelper.h"
 #include "Model.h"
@@ -36,6 +38,9 @@
 #include "VulkanInstance.h"
 #include "DeferredRenderer.h"
 #include "ShadowRenderer.h"
+#include "RenderGraph.h"
+#include "HiZPyramid.h"
+#include "GpuDrivenRenderer.h"
 #include "ParticleRenderer.h"
 #include "ParticleComponent.h"
 
@@ -45,17 +50,23 @@
  using namespace std;
 
 
- void runDeferredRenderWithShadowMapping()
+ void runDeferredRenderWithShadowMapping(VertexFormatType vertexFormat, PositionFormatType positionFormat)
  {
+	 auto const startTime = chrono::steady_clock::now(); //time to first frame, pipeline cache makes difference on second run
+	 bool firstFrame = true;
+
 	 Window window(resX, resY, "Vulkan");
-	 VulcanInstance vulcanInstance(window.getWindow(), resX, resY);
+	 FrameSettings frameSettings;
+	 frameSettings.measureInputLatency = true;
+	 VulcanInstance vulcanInstance(window.getWindow(), resX, resY, frameSettings);
 
-	 SceneObjectFactory sceneObjectFactory(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, vulcanInstance.m_CommandPool, vulcanInstance.m_GraphicQueue);
-	 ShadowRenderer shadowRender(vulcanInstance.m_Device, vulcanInstance.m_PhysicalDevice, vulcanInstance.m_SwapChainExtent);
-	 DeferredRender deferredRender(vulcanInstance.m_Device, vulcanInstance.m_PhysicalDevice, vulcanInstance.m_SwapChainExtent, vulcanInstance.m_SwapChainImageFormat, shadowRender.m_ShadowAttachment.view, vulcanInstance.m_RenderPass, sceneObjectFactory.getMaterialManager()->getDescriptorSetLayout());
+	 SceneObjectFactory sceneObjectFactory(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, *vulcanInstance.m_StagingRing, vertexFormat, positionFormat);
+	 RenderGraph renderGraph(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, vulcanInstance.m_GpuProfiler.get());
+	 ShadowRenderer shadowRender(vulcanInstance.m_Device, vulcanInstance.m_PhysicalDevice, vulcanInstance.m_SwapChainExtent, positionFormat, renderGraph);
+	 DeferredRender deferredRender(vulcanInstance.m_Device, vulcanInstance.m_PhysicalDevice, vulcanInstance.m_SwapChainExtent, vulcanInstance.m_SwapChainImageFormat, renderGraph, shadowRender.m_ShadowMap, vulcanInstance.m_RenderPass, sceneObjectFactory.getMaterialManager()->getDescriptorSetLayout(), vertexFormat, *vulcanInstance.m_UniformRing);
 
 	 SceneContext sceneContext;
-	 sceneContext.m_SceneDescription = make_unique<SceneDescription>(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, deferredRender.m_1stPassDescriptorSetLayout2);
+	 sceneContext.m_SceneDescription = make_unique<SceneDescription>(*vulcanInstance.m_UniformRing, deferredRender.m_1stPassDescriptorSetLayout2);
 	 sceneContext.m_GraphicsPipeline = deferredRender.m_1stPassPipeline;
 	 sceneContext.m_PipelineLayout = deferredRender.m_1stPassPipelineLayout;
 	 sceneContext.m_Camera.setPos(glm::vec3(0.0f, 0.0f, 200.0f));
@@ -91,167 +102,215 @@
 		 sceneContext.m_SceneObjectManager.insert(move(obj));
 	 }
 
-	 window.setKeyCallback(key_callback);
-	 window.setMouseMoveCallback(cursor_position_callback);
-	 window.setMouseButtonCallback(mouse_button_callback);
-
-	 volatile static bool restart = false;
-	 while (!window.shouldClose())
+	 //G-buffer is culled and drawn by GPU when device supports it, Hi-Z pyramid of its depth is used for occlusion culling in next frame
+	 unique_ptr<HiZPyramid> hiZPyramid;
+	 unique_ptr<GpuDrivenRenderer> gpuDrivenRenderer;
+	 if (vertexFormat == VertexFormatType::FULL && GpuDrivenRenderer::isSupported(vulcanInstance.m_PhysicalDevice))
 	 {
-		 window.pollEvents();
-
-		 vulcanInstance.drawFrame([&sceneContext, &deferredRender, &shadowRender](VkCommandBuffer commandBuffer, VkFramebuffer frameBuffer, VkImage image)
-			 {
-				 VkCommandBufferBeginInfo beginInfo = {};
-				 beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-				 beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-				 beginInfo.pInheritanceInfo = nullptr; // Optional
-
-				 auto res = vkBeginCommandBuffer(commandBuffer, &beginInfo);
-				 assert(res == VK_SUCCESS);
-
-				 { //Deffered renderer 1st pass to fill Gbuffers with values
-					 array<VkClearValue, 5> clearValues = {};
-					 clearValues[0].color = { 0.0f, 0.0f, 0.0f, 0.0f };
-					 clearValues[1].color = { 0.0f, 0.0f, 0.0f, 0.0f };
-					 clearValues[2].color = { 0.0f, 0.0f, 0.0f, 0.0f };
-					 clearValues[3].color = { 0.0f, 0.0f, 0.0f, 0.0f };
-					 clearValues[4].depthStencil = { 1.0f, 0 };
-
-					 VkRenderPassBeginInfo renderPassInfo = {};
-					 renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-
-					 renderPassInfo.renderPass = deferredRender.m_1stRenderPass;
-					 renderPassInfo.framebuffer = deferredRender.m_1stFramebuffer;
-
-					 renderPassInfo.renderArea.offset = { 0, 0 };
-					 renderPassInfo.renderArea.extent = deferredRender.m_Extent;
-					 renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-					 renderPassInfo.pClearValues = &clearValues[0];
-
-					 vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		 hiZPyramid = make_unique<HiZPyramid>(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, vulcanInstance.m_CommandPool, vulcanInstance.m_GraphicQueue, vulcanInstance.m_SwapChainExtent);
+		 gpuDrivenRenderer = make_unique<GpuDrivenRenderer>(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, *vulcanInstance.m_StagingRing, *vulcanInstance.m_UniformRing, *vulcanInstance.m_GpuProfiler, *hiZPyramid,
+			 vulcanInstance.m_FramesInFlight, vulcanInstance.m_DrawIndirectCount, deferredRender.m_1stRenderPass, vulcanInstance.m_SwapChainExtent, sceneObjectFactory.getMaterialManager()->getDescriptorSetLayout(), deferredRender.m_1stPassDescriptorSetLayout2);
+		 gpuDrivenRenderer->build(sceneContext.m_SceneObjectManager);
+	 }
 
-					 sceneContext.recordCommandBuffer(commandBuffer);
+	 //G-buffer, then shadow map and illumination per light, shadow map is rewritten for next light after illumination sampled it
+	 //graph inserts barriers between passes and aliases G-buffer depth with shadow map
+	 VkFramebuffer swapChainFramebuffer = VK_NULL_HANDLE; //illumination renders into swapchain image acquired for frame
 
-					 vkCmdEndRenderPass(commandBuffer);
-				 }
+	 //scene objects are drawn by indirect commands culled on GPU, or recorded on all cores into secondary command buffers
+	 RenderGraph::PassId gBufferPass = 0;
+	 gBufferPass = renderGraph.addPass("gBuffer", deferredRender.m_GBuffer, deferredRender.m_GBufferDepth, {}, false, [&sceneContext, &vulcanInstance, &renderGraph, &gBufferPass, &gpuDrivenRenderer](VkCommandBuffer commandBuffer)
+		 {
+			 if (gpuDrivenRenderer)
+			 {
+				 sceneContext.recordCommandBuffer(commandBuffer, *gpuDrivenRenderer, static_cast<uint32_t>(vulcanInstance.m_CurrentFrame));
+			 }
+			 else
+			 {
+				 sceneContext.recordCommandBuffer(commandBuffer, *vulcanInstance.m_ParallelRecorder, renderGraph.getRenderPass(gBufferPass), renderGraph.getFramebuffer(gBufferPass));
+			 }
+		 }, gpuDrivenRenderer ? VK_SUBPASS_CONTENTS_INLINE : VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
+	 //before shadow passes, G-buffer depth is aliased with shadow map
+	 if (hiZPyramid)
+	 {
+		 renderGraph.addPass("hiZ", {}, nullopt, { deferredRender.m_GBufferDepth }, true, [&hiZPyramid](VkCommandBuffer commandBuffer)
+			 {
+				 hiZPyramid->build(commandBuffer);
+			 });
+	 }
 
-				 for (size_t i = 0; i < sceneContext.m_Lights.size(); ++i)
-				 {
+	 //light parameters depend on camera, they are rewritten by late latch right before submission like scene data
+	 auto const writeLightParam = [&sceneContext](LightParamUBO& lightParam, size_t i)
+	 {
+		 lightParam.viewProj = sceneContext.m_ProjectionMatrix * sceneContext.m_Lights[i].getInvMatrix() * sceneContext.m_Camera.getMatrix();
+		 lightParam.viewSpacePos = glm::vec3(sceneContext.m_Camera.getInvMatrix() * sceneContext.m_Lights[i].getMatrix()[3]);
+		 lightParam.color = glm::vec3(1000000.0f);
+	 };
+	 vector<pair<LightParamUBO*, size_t>> latchedLightParams;
 
-					 { //Generate shadow map
-						 array<VkClearValue, 1> clearValues = {};
-						 clearValues[0].depthStencil = { 1.0f, 0 };
+	 vector<RenderGraph::ResourceId> illuminationInputs = deferredRender.m_GBuffer;
+	 illuminationInputs.push_back(shadowRender.m_ShadowMap);
 
-						 VkRenderPassBeginInfo renderPassInfo = {};
-						 renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-						 renderPassInfo.renderPass = shadowRender.m_ShadowRenderPass;
-						 renderPassInfo.framebuffer = shadowRender.m_ShadowFramebuffer;
-						 renderPassInfo.renderArea.offset = { 0, 0 };
-						 renderPassInfo.renderArea.extent = shadowRender.m_Extent;
-						 renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-						 renderPassInfo.pClearValues = &clearValues[0];
+	 for (size_t i = 0; i < sceneContext.m_Lights.size(); ++i)
+	 {
+		 renderGraph.addPass("shadow" + to_string(i), {}, shadowRender.m_ShadowMap, {}, false, [&sceneContext, &shadowRender, i](VkCommandBuffer commandBuffer)
+			 {
+				 vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowRender.m_ShadowGraphicPipeline);
 
-						 vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+				 VkDescriptorSet  descSet = shadowRender.m_ShadowDescriptorSet->getDescriptorSet();
+				 vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowRender.m_ShadowPipelineLayout, 0, 1, &descSet, 0, nullptr);
 
-						 vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowRender.m_ShadowGraphicPipeline);
+				 GeometryBindings bindings;
+				 size_t objectIdx = 0;
 
-						 VkDescriptorSet  descSet = shadowRender.m_ShadowDescriptorSet->getDescriptorSet();
-						 vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowRender.m_ShadowPipelineLayout, 0, 1, &descSet, 0, nullptr);
+				 sceneContext.m_SceneObjectManager.enumerate([&](SceneObject* sceneObj)
+					 {
+						 VisualComponent const* visualComp = sceneObj->findComponent<VisualComponent>();
+						 uint8_t const* meshVisibility = sceneContext.m_FrustumCuller.getMeshVisibility(i + 1, objectIdx++);
+						 if (visualComp)
+						 {
+							 float const lodErrorScale = VisualComponent::calculateLodErrorScale(sceneObj->getMatrix(), sceneContext.m_Lights[i].getMatrix()[3], sceneContext.m_ProjectionMatrix, static_cast<float>(shadowRender.m_Extent.height));
 
-						 sceneContext.m_SceneObjectManager.enumerate([&](SceneObject* sceneObj)
+							 for (size_t meshIdx = 0; meshIdx < visualComp->m_ModelData->meshes.size(); ++meshIdx)
 							 {
-								 array<glm::mat4, 3> matrices = { sceneContext.m_ProjectionMatrix, sceneContext.m_Lights[i].getInvMatrix(), sceneObj->getMatrix() };
-								 vkCmdPushConstants(commandBuffer, shadowRender.m_ShadowPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(matrices), &matrices[0]);
+								 if (meshVisibility && !meshVisibility[meshIdx]) continue;
 
-								 VisualComponent const* visualComp = sceneObj->findComponent<VisualComponent>();
-								 if (visualComp)
-								 {
-									 for (size_t i = 0; i < visualComp->m_ModelData->meshes.size(); ++i)
-									 {
-										 VkDeviceSize offsets[] = { 0 };
-										 vkCmdBindVertexBuffers(commandBuffer, 0, 1, &visualComp->m_ModelData->meshes[i].vertexBuffer.buffer, offsets);
+								 //position stream may be quantized per mesh
+								 array<glm::mat4, 3> matrices = { sceneContext.m_ProjectionMatrix, sceneContext.m_Lights[i].getInvMatrix(), sceneObj->getMatrix() * visualComp->m_ModelData->meshes[meshIdx].positionDequantization };
+								 vkCmdPushConstants(commandBuffer, shadowRender.m_ShadowPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(matrices), &matrices[0]);
 
-										 vkCmdBindIndexBuffer(commandBuffer, visualComp->m_ModelData->meshes[i].indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-										 vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(visualComp->m_ModelData->meshes[i].indexBuffer.count), 1, 0, 0, 0);
-									 }
-								 }
+								 visualComp->drawPositions(commandBuffer, meshIdx, lodErrorScale, sceneContext.m_LodPixelThreshold, bindings);
+							 }
+						 }
 
-							 });
+					 });
 
-						 vkCmdEndRenderPass(commandBuffer);
-					 }
+			 });
 
+		 renderGraph.addPass("illumination" + to_string(i), {}, nullopt, illuminationInputs, true, [&deferredRender, &swapChainFramebuffer, &writeLightParam, &latchedLightParams, i](VkCommandBuffer commandBuffer)
+			 {
+				 array<VkClearValue, 2> clearValues = {};
+				 clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+				 clearValues[1].depthStencil = { 1.0f, 0 };
+
+				 VkClearAttachment clearAtt;
+				 clearAtt.colorAttachment = 0;
+				 clearAtt.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				 clearAtt.clearValue = clearValues[0];
+
+				 VkClearRect rect;
+				 rect.baseArrayLayer = 0;
+				 rect.layerCount = 1;
+				 rect.rect.offset = { 0,0 };
+				 rect.rect.extent = { 1024,1024 };
+
+				 //vkCmdClearColorImage(commandBuffer, 1, clearValues[0]
+				 VkRenderPassBeginInfo renderPassInfo = {};
+				 renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				 renderPassInfo.renderPass = deferredRender.m_DstRenderPass;
+				 renderPassInfo.framebuffer = swapChainFramebuffer;
+				 renderPassInfo.renderArea.offset = { 0, 0 };
+				 renderPassInfo.renderArea.extent = deferredRender.m_Extent;
+				 renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+				 renderPassInfo.pClearValues = &clearValues[0];
+
+				 vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+
+				 //==================
+				 LightParamUBO lightParam;
+				 writeLightParam(lightParam, i);
+
+				 uint32_t const lightParamOffset = deferredRender.m_UniformRing.push(lightParam);
+				 latchedLightParams.push_back({ static_cast<LightParamUBO*>(deferredRender.m_UniformRing.getMappedData(lightParamOffset)), i });
+				 //==================
+
+				 if (i == 0)
+				 {
+					 vkCmdClearAttachments(commandBuffer, 1, &clearAtt, 1, &rect);
+				 }
 
-					 { //Use shadow map and Gbuffer values to calculate illumination
-						 array<VkClearValue, 2> clearValues = {};
-						 clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-						 clearValues[1].depthStencil = { 1.0f, 0 };
 
-						 VkClearAttachment clearAtt;
-						 clearAtt.colorAttachment = 0;
-						 clearAtt.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-						 clearAtt.clearValue = clearValues[0];
+				 VkDescriptorSet  descSet = deferredRender.m_2ndPassDescriptorSet->getDescriptorSet();
+				 vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, deferredRender.m_2ndPassPipelineLayout, 0, 1, &descSet, 1, &lightParamOffset);
+				 vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, deferredRender.m_2ndPassPipeline);
 
-						 VkClearRect rect;
-						 rect.baseArrayLayer = 0;
-						 rect.layerCount = 1;
-						 rect.rect.offset = { 0,0 };
-						 rect.rect.extent = { 1024,1024 };
+				 vkCmdDraw(commandBuffer, 6, 1, 0, 0);
 
-						 //vkCmdClearColorImage(commandBuffer, 1, clearValues[0]
-						 VkRenderPassBeginInfo renderPassInfo = {};
-						 renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-						 renderPassInfo.renderPass = deferredRender.m_DstRenderPass;
-						 renderPassInfo.framebuffer = frameBuffer;
-						 renderPassInfo.renderArea.offset = { 0, 0 };
-						 renderPassInfo.renderArea.extent = deferredRender.m_Extent;
-						 renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-						 renderPassInfo.pClearValues = &clearValues[0];
+				 vkCmdEndRenderPass(commandBuffer);
+			 });
+	 }
 
-						 vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	 renderGraph.compile();
+	 renderGraph.printStatistics();
+	 deferredRender.bindAttachments(renderGraph);
+	 if (hiZPyramid) hiZPyramid->bindDepth(renderGraph.getImageView(deferredRender.m_GBufferDepth));
 
+	 shadowRender.waitForPipeline(); //compiled in background during scene load
 
-						 //==================
-						 LightParamUBO lightParam;
+	 vulcanInstance.m_MemoryAllocator->printStatistics();
+	 vulcanInstance.m_DescriptorAllocator->printStatistics();
+	 vulcanInstance.m_PipelineRegistry->printStatistics();
+	 sceneObjectFactory.getModelManager()->printStatistics();
 
-						 lightParam.viewProj = sceneContext.m_ProjectionMatrix * sceneContext.m_Lights[i].getInvMatrix() * sceneContext.m_Camera.getMatrix();
-						 lightParam.viewSpacePos = glm::vec3(sceneContext.m_Camera.getInvMatrix() * sceneContext.m_Lights[i].getMatrix()[3]);
-						 lightParam.color = glm::vec3(1000000.0f);
+	 InputSampler inputSampler(window, input_callback);
+	 const float speed = 10.0f;
 
-						 vkCmdPushConstants(commandBuffer, deferredRender.m_2ndPassPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(lightParam), &lightParam);
-						 deferredRender.m_lightParamBuffer->updateBuffer(&lightParam);
-						 //==================
+	 volatile static bool restart = false;
+	 while (!window.shouldClose())
+	 {
+		 window.pollEvents();
 
-						 if (i == 0)
-						 {
-							 vkCmdClearAttachments(commandBuffer, 1, &clearAtt, 1, &rect);
-						 }
+		 //ranges of moved meshes are patched before frame is recorded, copies are flushed with frame
+		 if (sceneObjectFactory.getModelManager()->defragment() && gpuDrivenRenderer) gpuDrivenRenderer->relocate();
 
+		 vulcanInstance.drawFrame([&renderGraph, &sceneContext, &swapChainFramebuffer, &gpuDrivenRenderer, &vulcanInstance](VkCommandBuffer commandBuffer, VkFramebuffer frameBuffer, VkImage image)
+			 {
+				 //shared by G-buffer and shadow passes
+				 sceneContext.cull();
 
-						 VkDescriptorSet  descSet = deferredRender.m_2ndPassDescriptorSet->getDescriptorSet();
-						 vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, deferredRender.m_2ndPassPipelineLayout, 0, 1, &descSet, 0, NULL);
-						 vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, deferredRender.m_2ndPassPipeline);
+				 VkCommandBufferBeginInfo beginInfo = {};
+				 beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				 beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				 beginInfo.pInheritanceInfo = nullptr; // Optional
 
-						 vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+				 auto res = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+				 assert(res == VK_SUCCESS);
 
-						 vkCmdEndRenderPass(commandBuffer);
-					 }
+				 //G-buffer draws, shadow passes keep CPU frustum culling
+				 if (gpuDrivenRenderer)
+				 {
+					 gpuDrivenRenderer->cull(commandBuffer, static_cast<uint32_t>(vulcanInstance.m_CurrentFrame), sceneContext.m_ProjectionMatrix, sceneContext.m_Camera.getMatrix(), static_cast<float>(resY), sceneContext.m_LodPixelThreshold);
 				 }
+
+				 swapChainFramebuffer = frameBuffer;
+				 renderGraph.execute(commandBuffer);
+
 				 res = vkEndCommandBuffer(commandBuffer);
 				 assert(res == VK_SUCCESS);
 
+			 },
+			 [&inputSampler, &sceneContext, &writeLightParam, &latchedLightParams, &gpuDrivenRenderer, speed]()
+			 {
+				 //input which arrived while frame was recorded moves camera of this frame
+				 auto const inputTime = inputSampler.sample();
+				 moveCamera(sceneContext.m_Camera, speed);
+
+				 sceneContext.latchCamera();
+				 for (auto const& lightParam : latchedLightParams) writeLightParam(*lightParam.first, lightParam.second);
+				 latchedLightParams.clear();
+				 if (gpuDrivenRenderer) gpuDrivenRenderer->latch(sceneContext.m_Camera.getMatrix());
+
+				 return inputTime;
 			 });
 
+		 if (firstFrame)
+		 {
+			 cout << "Time to first frame: " << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count() << " ms" << endl;
+			 firstFrame = false;
+		 }
 
-		 const float speed = 10.0f;
-		 if (keyDown['E']) sceneContext.m_Camera.move(0.0f, 0.0f, speed);
-		 if (keyDown['Q']) sceneContext.m_Camera.move(0.0f, 0.0f, -speed);
-		 if (keyDown['W']) sceneContext.m_Camera.move(speed, 0.0f, 0.0f);
-		 if (keyDown['S']) sceneContext.m_Camera.move(-speed, 0.0f, 0.0f);
-		 if (keyDown['A']) sceneContext.m_Camera.move(0.0f, -speed, 0.0f);
-		 if (keyDown['D']) sceneContext.m_Camera.move(0.0f, speed, 0.0f);
 
 
 
@@ -273,6 +332,16 @@
 
 	 }
 
+	 vulcanInstance.printFrameStatistics();
+	 sceneContext.m_FrustumCuller.printStatistics();
+	 if (gpuDrivenRenderer) gpuDrivenRenderer->printStatistics();
+	 vulcanInstance.m_GpuProfiler->printStatistics();
+
+#if PHOENIX_CPU_PROFILER
+	 CpuProfiler::get().printStatistics();
+	 CpuProfiler::get().writeTrace("deferredRenderTrace.json");
+#endif
+
 	 sceneContext.m_SceneObjectManager.clear();
 
  };
@@ -1,3 +1,7 @@
 #pragma once
 
-void runDeferredRenderWithShadowMapping();
\ No newline at end of file
+#include "VertexFormat.h"
+
+//vertexFormat selects G-buffer vertex shader (vert.spv, vertOct.spv or vertQTangent.spv), GPU-driven path is used only with FULL
+//positionFormat is format of position stream read by shadow map pass
+void runDeferredRenderWithShadowMapping(VertexFormatType vertexFormat = VertexFormatType::FULL, PositionFormatType positionFormat = PositionFormatType::FLOAT);
\ No newline at end of file
@@ -1,5 +1,6 @@
 
 #include "mainParticles.h"
+#include "CpuProfiler.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -57,8 +58,8 @@
 	 VulcanInstance vulcanInstance(window.getWindow(), resX, resY);
 
 
-	 ParticleRenderer particleRender(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, vulcanInstance.m_RenderPass, vulcanInstance.getQueueFamilyIndex(VK_QUEUE_COMPUTE_BIT));
-	 SceneObjectFactory sceneObjectFactory(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, vulcanInstance.m_CommandPool, vulcanInstance.m_GraphicQueue);
+	 ParticleRenderer particleRender(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, vulcanInstance.m_RenderPass, *vulcanInstance.m_ComputeScheduler, *vulcanInstance.m_GpuProfiler);
+	 SceneObjectFactory sceneObjectFactory(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, *vulcanInstance.m_StagingRing);
 
 	 static auto projectionMatrix = VulkanHelpers::preparePerspectiveProjectionMatrix((float)resX / resY, 60, 1.0f, 10000.0f);
 
@@ -77,7 +78,7 @@
 		 VisualComponent* visualComp = obj->findComponent<VisualComponent>();
 
 		 glm::vec3 offset(0.0);
-		 obj->addComponent(make_unique<ParticleComponent>(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, visualComp->m_ModelData, offset, particleRender.m_ParticleRendererData));
+		 obj->addComponent(make_unique<ParticleComponent>(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, *vulcanInstance.m_StagingRing, visualComp->m_ModelData, offset, particleRender.m_ParticleRendererData));
 		 modelData = visualComp->m_ModelData;
 
 		 sceneObjectManager.insert(move(obj));
@@ -150,8 +151,9 @@
 			 }
 		 });
 
-	 particleRender.recordComputeCommand(particleComponents);
+	 particleRender.setParticleComponents(particleComponents);
 
+	 uint32_t const renderScope = vulcanInstance.m_GpuProfiler->createScope("particle rendering");
 
 	 volatile static bool restart = false;
 	 while (!window.shouldClose())
@@ -163,6 +165,9 @@
 		 {
 			 glm::vec3 offset((0.5f * (-500 + rand() % 1000) / 500.0f), 0.5f * ((rand() % 1000) / 1000.0f), 1.0f * (-500 + rand() % 1000) / 500.0f);
 
+			 //frames in flight and simulation of next frame still use particle buffers
+			 vkDeviceWaitIdle(vulcanInstance.m_Device);
+
 			 for (auto& it : particleComponents)
 			 {
 				 it->reset(*particleComponents[0], modelData, offset);
@@ -170,10 +175,10 @@
 		 }
 
 
-		 particleRender.submitComputeCommand();
-
-		 vulcanInstance.drawFrame([&particleRender, &sceneObjectManager](VkCommandBuffer commandBuffer, VkFramebuffer frameBuffer, VkImage image)
+		 vulcanInstance.drawFrame([&particleRender, &sceneObjectManager, &vulcanInstance, renderScope](VkCommandBuffer commandBuffer, VkFramebuffer frameBuffer, VkImage image)
 			 {
+				 //runs on compute queue while previous frame is rendered, this frame waits for it on GPU
+				 particleRender.submitComputeCommand();
 
 				 VkCommandBufferBeginInfo beginInfo = {};
 				 beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -184,6 +189,8 @@
 				 assert(res == VK_SUCCESS);
 
 				 { ///particles pass
+					 GpuScope gpuScope(*vulcanInstance.m_GpuProfiler, commandBuffer, renderScope);
+
 					 VkRenderPassBeginInfo renderPassInfo = {};
 					 renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 					 renderPassInfo.renderPass = particleRender.m_RenderPass;
@@ -223,10 +230,10 @@
 								 {
 									 vkCmdPushConstants(commandBuffer, particleRender.m_ParticleRenderPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &mvp);
 
-									 auto descriptorSet = group.m_DescriptorSet.getDescriptorSet();
+									 auto descriptorSet = group.m_DescriptorSets[particleRender.m_CurrentBuffer].getDescriptorSet();
 									 vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, particleRender.m_ParticleRenderPipelineLayout, 0, 1, &descriptorSet, 0, NULL);
 									 vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, particleRender.m_ParticleRenderPipeline);
-									 vkCmdDraw(commandBuffer, group.m_Particles.count * 3, 1, 0, 0);
+									 vkCmdDraw(commandBuffer, group.m_Particles[particleRender.m_CurrentBuffer].count * 3, 1, 0, 0);
 								 }
 							 }
 						 });
@@ -250,5 +257,12 @@
 
 	 }
 
+	 vulcanInstance.printFrameStatistics();
+	 vulcanInstance.m_GpuProfiler->printStatistics();
+
+#if PHOENIX_CPU_PROFILER
+	 CpuProfiler::get().printStatistics();
+	 CpuProfiler::get().writeTrace("particlesTrace.json");
+#endif
  };
 
@@ -1,5 +1,6 @@
 
 #include "mainRayTracer.h"
+#include "CpuProfiler.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -97,11 +98,13 @@ void runRayTracing()
 	camera->setDir(glm::vec3(0.0f, 0.0f, -1.0f));
 
 	Window window(resX, resY, "Vulkan");
-	VulcanInstance vulcanInstance(window.getWindow(), resX, resY);
-	RayTracer rayTracer(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, vulcanInstance.getQueueFamilyIndex(VK_QUEUE_COMPUTE_BIT), vulcanInstance.m_CommandPool, vulcanInstance.m_GraphicQueue, vulcanInstance.m_RenderPass, 1024, 1024);
-	SceneObjectFactory sceneObjectFactory(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, vulcanInstance.m_CommandPool, vulcanInstance.m_GraphicQueue);
+	FrameSettings frameSettings;
+	frameSettings.measureInputLatency = true;
+	VulcanInstance vulcanInstance(window.getWindow(), resX, resY, frameSettings);
+	RayTracer rayTracer(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, *vulcanInstance.m_ComputeScheduler, *vulcanInstance.m_GpuProfiler, vulcanInstance.m_CommandPool, vulcanInstance.m_GraphicQueue, *vulcanInstance.m_StagingRing, vulcanInstance.m_RenderPass, 1024, 1024);
+	SceneObjectFactory sceneObjectFactory(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, *vulcanInstance.m_StagingRing);
 
-	TextureManager textureManager(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, vulcanInstance.m_CommandPool, vulcanInstance.m_GraphicQueue);
+	TextureManager textureManager(vulcanInstance.m_PhysicalDevice, vulcanInstance.m_Device, *vulcanInstance.m_StagingRing);
 
 	
 	auto frontTex = textureManager.loadTexture("C:/Phoenix/Models/front.jpg");
@@ -133,10 +136,10 @@ void runRayTracing()
 
 	for (size_t i = 0; i < visualComp->m_ModelData->meshes.size(); ++i)
 	{
-		unsigned int* indices = static_cast<unsigned int*>(visualComp->m_ModelData->meshes[i].indexBuffer.mapMemory());
-		Vertex* vertices = static_cast<Vertex*>(visualComp->m_ModelData->meshes[i].vertexBuffer.mapMemory());
+		vector<uint32_t> indices = visualComp->m_ModelData->readIndices(i);
+		vector<Vertex> vertices = visualComp->m_ModelData->readVertices(i);
 
-		for (size_t idx = 0; idx < visualComp->m_ModelData->meshes[i].indexBuffer.count; idx += 3)
+		for (size_t idx = 0; idx < visualComp->m_ModelData->meshes[i].lods[0].indexCount; idx += 3)
 		{
 			Triangle triangle;
 
@@ -150,9 +153,6 @@ void runRayTracing()
 
 			triangles.push_back(triangle);
 		}
-
-		visualComp->m_ModelData->meshes[i].indexBuffer.unmapMemory();
-		visualComp->m_ModelData->meshes[i].vertexBuffer.unmapMemory();
 	}
 
 
@@ -366,23 +366,19 @@ void runRayTracing()
 	rayTracer.setSpheres(spheres);
 	rayTracer.setMaterials(materialHelper.getDataArray());
 
-	window.setKeyCallback(key_callback);
-	window.setMouseMoveCallback(cursor_position_callback);
-	window.setMouseButtonCallback(mouse_button_callback);
+	InputSampler inputSampler(window, input_callback);
+	const float speed = 10.0f;
+
 
+	uint32_t const displayScope = vulcanInstance.m_GpuProfiler->createScope("ray tracer display");
 
 	volatile static bool restart = false;
 	while (!window.shouldClose())
 	{
 		window.pollEvents();
 
-		vulcanInstance.drawFrame([ &rayTracer](VkCommandBuffer commandBuffer, VkFramebuffer frameBuffer, VkImage image)
+		vulcanInstance.drawFrame([ &rayTracer, &vulcanInstance, displayScope](VkCommandBuffer commandBuffer, VkFramebuffer frameBuffer, VkImage image)
 			{
-				rayTracer.setView(camera->getMatrix());
-
-				rayTracer.recordComputeCommand();
-				rayTracer.submitComputeCommand();
-
 				VkCommandBufferBeginInfo beginInfo = {};
 				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
@@ -391,6 +387,8 @@ void runRayTracing()
 				auto res = vkBeginCommandBuffer(commandBuffer, &beginInfo);
 				assert(res == VK_SUCCESS);
 
+				vulcanInstance.m_GpuProfiler->begin(commandBuffer, displayScope);
+
 				VkRenderPassBeginInfo renderPassInfo = {};
 				renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 				renderPassInfo.renderPass = rayTracer.m_RenderPass;
@@ -427,22 +425,34 @@ void runRayTracing()
 				vkCmdDraw(commandBuffer, 6, 1, 0, 0);
 
 				vkCmdEndRenderPass(commandBuffer);
+				vulcanInstance.m_GpuProfiler->end(commandBuffer, displayScope);
+
 				res = vkEndCommandBuffer(commandBuffer);
 				assert(res == VK_SUCCESS);
 
-			});
-
+			},
+			[&inputSampler, &rayTracer, speed]()
+			{
+				//view is push constant of compute command, so it is recorded and submitted once camera is latched
+				auto const inputTime = inputSampler.sample();
+				moveCamera(*camera, speed);
 
-		const float speed = 10.0f;
-		if (keyDown['E']) camera->move(0.0f, 0.0f, speed);
-		if (keyDown['Q']) camera->move(0.0f, 0.0f, -speed);
-		if (keyDown['W']) camera->move(speed, 0.0f, 0.0f);
-		if (keyDown['S']) camera->move(-speed, 0.0f, 0.0f);
-		if (keyDown['A']) camera->move(0.0f, -speed, 0.0f);
-		if (keyDown['D']) camera->move(0.0f, speed, 0.0f);
+				rayTracer.setView(camera->getMatrix());
+				rayTracer.recordComputeCommand();
+				rayTracer.submitComputeCommand();
 
+				return inputTime;
+			});
 	}
 
+	vulcanInstance.printFrameStatistics();
+	vulcanInstance.m_GpuProfiler->printStatistics();
+
+#if PHOENIX_CPU_PROFILER
+	CpuProfiler::get().printStatistics();
+	CpuProfiler::get().writeTrace("rayTracerTrace.json");
+#endif
+
 	delete camera;
 	camera = nullptr;
 